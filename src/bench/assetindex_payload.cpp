@@ -0,0 +1,54 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <services/asset.h>
+#include <streams.h>
+#include <version.h>
+
+// Receivers of the indexed allocation send
+static const unsigned int ASSET_INDEX_BENCH_RECEIVERS = 10;
+
+static void MakeAllocationSendRecord(CAssetIndexTxRecord& record, CAsset& dbAsset)
+{
+    dbAsset.nAsset = 1;
+    dbAsset.strSymbol = "BENCH";
+    dbAsset.nPrecision = 8;
+    dbAsset.nBalance = dbAsset.nTotalSupply = dbAsset.nMaxSupply = 1000 * COIN;
+    record.nTxVersion = PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_SEND;
+    record.nHeight = 500000;
+    record.blockhash = uint256S("0x5a2d8e2a9f08d5b4b2c0ec4c8c5a8d7d1b4a0d6e1a5d4c5f0b0a4b9e8d7c6b5a");
+    record.assetAllocation.assetAllocationTuple = CAssetAllocationTuple(1, CWitnessAddress(0, std::vector<unsigned char>(WITNESS_V0_KEYHASH_SIZE, 0x01)));
+    for (unsigned int i = 0; i < ASSET_INDEX_BENCH_RECEIVERS; i++)
+        record.assetAllocation.listSendingAllocationAmounts.emplace_back(CWitnessAddress(0, std::vector<unsigned char>(WITNESS_V0_KEYHASH_SIZE, 0x02 + i)), (i + 1) * COIN);
+}
+
+// Payload as stored before the binary records: built as JSON and written as text while the block is connected
+static void AssetIndexPayloadJSON(benchmark::State& state)
+{
+    CAssetIndexTxRecord record;
+    CAsset dbAsset;
+    MakeAllocationSendRecord(record, dbAsset);
+    const uint256 txid = uint256S("0x01");
+    while (state.KeepRunning()) {
+        UniValue oName(UniValue::VOBJ);
+        AssetAllocationTxToJSON(record.nTxVersion, txid, record.assetAllocation, record.vchEthAddress, dbAsset, record.nHeight, record.blockhash, oName);
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << oName.write();
+    }
+}
+
+static void AssetIndexPayloadBinary(benchmark::State& state)
+{
+    CAssetIndexTxRecord record;
+    CAsset dbAsset;
+    MakeAllocationSendRecord(record, dbAsset);
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << record;
+    }
+}
+
+BENCHMARK(AssetIndexPayloadJSON, 50 * 1000);
+BENCHMARK(AssetIndexPayloadBinary, 500 * 1000);
@@ -8,6 +8,7 @@
 #include <hash.h>
 #include <random.h>
 #include <uint256.h>
+#include <crypto/keccak256.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -59,6 +60,42 @@ static void SHA256D64_1024(benchmark::State& state)
     }
 }
 
+static void KECCAK256(benchmark::State& state)
+{
+    uint8_t hash[CKeccak256::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    while (state.KeepRunning())
+        CKeccak256().Write(in.data(), in.size()).Finalize(hash);
+}
+
+/* Ethereum trie proofs are a handful of branch nodes of about 532 bytes each */
+static const size_t TRIE_NODE_SIZE = 532;
+
+static void KECCAK256_TrieNodes_1way(benchmark::State& state)
+{
+    std::vector<uint8_t> in(TRIE_NODE_SIZE * 64, 0);
+    std::vector<uint8_t> out(CKeccak256::OUTPUT_SIZE * 64);
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < 64; i++)
+            CKeccak256().Write(in.data() + i * TRIE_NODE_SIZE, TRIE_NODE_SIZE).Finalize(out.data() + i * CKeccak256::OUTPUT_SIZE);
+    }
+}
+
+static void KECCAK256_TrieNodes_Many(benchmark::State& state)
+{
+    // the bench runner does not autodetect, pick up the SIMD permutation if there is one
+    Keccak256AutoDetect();
+    std::vector<uint8_t> in(TRIE_NODE_SIZE * 64, 0);
+    std::vector<uint8_t> out(CKeccak256::OUTPUT_SIZE * 64);
+    std::vector<const unsigned char*> inputs;
+    for (size_t i = 0; i < 64; i++)
+        inputs.push_back(in.data() + i * TRIE_NODE_SIZE);
+    const std::vector<size_t> lens(64, TRIE_NODE_SIZE);
+    while (state.KeepRunning()) {
+        Keccak256Many(out.data(), inputs.data(), lens.data(), 64);
+    }
+}
+
 static void SHA512(benchmark::State& state)
 {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
@@ -96,9 +133,12 @@ BENCHMARK(RIPEMD160, 440);
 BENCHMARK(SHA1, 570);
 BENCHMARK(SHA256, 340);
 BENCHMARK(SHA512, 330);
+BENCHMARK(KECCAK256, 100);
 
 BENCHMARK(SHA256_32b, 4700 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(KECCAK256_TrieNodes_1way, 5000);
+BENCHMARK(KECCAK256_TrieNodes_Many, 10000);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,76 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <governancevote.h>
+#include <key.h>
+#include <messagesigner.h>
+#include <random.h>
+#include <util/system.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+// Number of governance votes received in one burst
+static const size_t MN_SIG_BENCH_VOTES = 1000;
+// Number of masternodes casting them
+static const size_t MN_SIG_BENCH_MASTERNODES = 50;
+static const int MIN_CORES = 2;
+
+static std::vector<CHashSignature> SignedGovernanceVotes()
+{
+    std::vector<CKey> vecKeys(MN_SIG_BENCH_MASTERNODES);
+    for (CKey& key : vecKeys)
+        key.MakeNewKey(true);
+    std::vector<CHashSignature> vecSigs;
+    vecSigs.reserve(MN_SIG_BENCH_VOTES);
+    for (size_t i = 0; i < MN_SIG_BENCH_VOTES; i++) {
+        const CKey& key = vecKeys[i % vecKeys.size()];
+        CGovernanceVote vote(COutPoint(uint256(), i % vecKeys.size()), GetRandHash(), VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+        std::vector<unsigned char> vchSig;
+        bool fSigned = CHashSigner::SignHash(vote.GetSignatureHash(), key, vchSig);
+        assert(fSigned);
+        vecSigs.emplace_back(vote.GetSignatureHash(), key.GetPubKey().GetID(), vchSig);
+    }
+    return vecSigs;
+}
+
+// Votes are checked one by one as the message handler used to do
+static void MasternodeVoteSigsSerial(benchmark::State& state)
+{
+    const std::vector<CHashSignature> vecSigs = SignedGovernanceVotes();
+    std::string strError;
+    while (state.KeepRunning()) {
+        // start every burst with an empty cache
+        InitHashSignerCache();
+        for (const CHashSignature& sig : vecSigs) {
+            bool fValid = CHashSigner::VerifyHash(sig.hash, sig.keyID, sig.vchSig, strError);
+            assert(fValid);
+        }
+    }
+}
+
+// Votes are checked as a batch on the hash signer check workers, then handled one by one against the cache
+static void MasternodeVoteSigsBatch(benchmark::State& state)
+{
+    const std::vector<CHashSignature> vecSigs = SignedGovernanceVotes();
+    boost::thread_group tg;
+    for (int i = 0; i < std::max(MIN_CORES, GetNumCores()) - 1; i++)
+        tg.create_thread([i]{ ThreadHashSignerCheck(i); });
+    std::string strError;
+    while (state.KeepRunning()) {
+        InitHashSignerCache();
+        CHashSigner::VerifyHashes(vecSigs);
+        for (const CHashSignature& sig : vecSigs) {
+            bool fValid = CHashSigner::VerifyHash(sig.hash, sig.keyID, sig.vchSig, strError);
+            assert(fValid);
+        }
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(MasternodeVoteSigsSerial, 5);
+BENCHMARK(MasternodeVoteSigsBatch, 5);
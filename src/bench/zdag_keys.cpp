@@ -0,0 +1,68 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <services/assetallocation.h>
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// Number of distinct ZDAG senders held in the mempool balance map
+static const size_t ZDAG_BENCH_SENDERS = 1000 * 1000;
+
+static std::vector<CAssetAllocationTuple> ZDAGSenders()
+{
+    std::vector<CAssetAllocationTuple> vecSenders;
+    vecSenders.reserve(ZDAG_BENCH_SENDERS);
+    for (uint32_t i = 0; i < ZDAG_BENCH_SENDERS; i++) {
+        std::vector<unsigned char> vchProgram(WITNESS_V0_KEYHASH_SIZE);
+        for (unsigned int j = 0; j < 4; j++)
+            vchProgram[j] = i >> (j * 8);
+        vecSenders.emplace_back(1 + i % 64, CWitnessAddress(0, vchProgram));
+    }
+    return vecSenders;
+}
+
+// Lookups as done before the binary keys: the tuple is rendered to its address string for every access
+static void ZDAGStringKeyLookup(benchmark::State& state)
+{
+    const std::vector<CAssetAllocationTuple> vecSenders = ZDAGSenders();
+    std::unordered_map<std::string, CAmount> mapBalances;
+    size_t nKeyUsage = 0;
+    for (const CAssetAllocationTuple& sender : vecSenders) {
+        const std::string& strSender = sender.ToString();
+        nKeyUsage += memusage::MallocUsage(strSender.capacity() + 1);
+        mapBalances.emplace(strSender, 1);
+    }
+    std::cout << "ZDAGStringKeyLookup: " << ZDAG_BENCH_SENDERS << " senders use " << (memusage::DynamicUsage(mapBalances) + nKeyUsage) << " bytes" << std::endl;
+    size_t i = 0;
+    CAmount nTotal = 0;
+    while (state.KeepRunning()) {
+        nTotal += mapBalances.find(vecSenders[i].ToString())->second;
+        if (++i == vecSenders.size())
+            i = 0;
+    }
+    assert(nTotal > 0);
+}
+
+static void ZDAGBinaryKeyLookup(benchmark::State& state)
+{
+    const std::vector<CAssetAllocationTuple> vecSenders = ZDAGSenders();
+    AssetBalanceMap mapBalances;
+    for (const CAssetAllocationTuple& sender : vecSenders)
+        mapBalances.emplace(CAssetAllocationTupleKey(sender), 1);
+    std::cout << "ZDAGBinaryKeyLookup: " << ZDAG_BENCH_SENDERS << " senders use " << mapBalances.DynamicMemoryUsage() << " bytes" << std::endl;
+    size_t i = 0;
+    CAmount nTotal = 0;
+    while (state.KeepRunning()) {
+        nTotal += mapBalances.find(CAssetAllocationTupleKey(vecSenders[i]))->second;
+        if (++i == vecSenders.size())
+            i = 0;
+    }
+    assert(nTotal > 0);
+}
+
+BENCHMARK(ZDAGStringKeyLookup, 500 * 1000);
+BENCHMARK(ZDAGBinaryKeyLookup, 5 * 1000 * 1000);
@@ -0,0 +1,47 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <services/asset.h>
+#include <services/graph.h>
+
+#include <cassert>
+#include <limits>
+#include <vector>
+
+// Number of asset allocation transactions in the block template
+static const size_t ZDAG_BENCH_TEMPLATE_TXS = 10 * 1000;
+
+static void OrderZDAGBlockTemplate(benchmark::State& state)
+{
+    FastRandomContext rng(true);
+    std::vector<CTransactionRef> vtx;
+    std::vector<int64_t> vecArrivalTimes;
+    // the coinbase and a plain transaction for every tenth allocation, arrivals are spread over the 30 minute ZDAG window
+    vtx.emplace_back(MakeTransactionRef(CMutableTransaction()));
+    vecArrivalTimes.push_back(std::numeric_limits<int64_t>::max());
+    for (size_t i = 0; i < ZDAG_BENCH_TEMPLATE_TXS; i++) {
+        CMutableTransaction tx;
+        tx.nVersion = PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_SEND;
+        tx.nLockTime = i;
+        vtx.emplace_back(MakeTransactionRef(tx));
+        vecArrivalTimes.push_back(1560000000000 + rng.randrange(30 * 60 * 1000));
+        if (i % 10 == 0) {
+            CMutableTransaction txPlain;
+            txPlain.nLockTime = i;
+            vtx.emplace_back(MakeTransactionRef(txPlain));
+            vecArrivalTimes.push_back(std::numeric_limits<int64_t>::max());
+        }
+    }
+
+    std::vector<unsigned int> vecOrder;
+    while (state.KeepRunning()) {
+        std::vector<CTransactionRef> vtxTemplate(vtx);
+        bool ret = OrderBasedOnArrivalTime(vtxTemplate, vecArrivalTimes, vecOrder);
+        assert(ret);
+    }
+}
+
+BENCHMARK(OrderZDAGBlockTemplate, 100);
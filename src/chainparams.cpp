@@ -298,6 +298,7 @@ public:
 
         // privKey: cU52TqHDWJg6HoL3keZHBvrJgsCLsduRvDFkPyZ5EmeMwoEHshiT
         strSporkAddress = "TCGpumHyMXC5BmfkaAQXwB7Bf4kbkhM9BX";
+        nMasternodeForkBlock = 5000;
         nFulfilledRequestExpireTime = 5*60; // fulfilled requests expire in 5 minutes
         /*checkpointData = {
             {
@@ -390,6 +391,7 @@ public:
         fMineBlocksOnDemand = true;
         // privKey: cPPpaK9LCXjGGXVJUqcrtEMVQw5tALMuN3WsVuPCWFf9tswYYDvY
         strSporkAddress = "TCSJVL68KFq9FdbfxB2KhTcWp6rHD7vePs";
+        nMasternodeForkBlock = 5000;
         nFulfilledRequestExpireTime = 5*60; // fulfilled requests expire in 5 minutes
        /* checkpointData = {
             {
@@ -0,0 +1,288 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/keccak256.h>
+#include <crypto/common.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace keccak256_avx2
+{
+void KeccakF_4way(uint64_t* st);
+}
+
+// Internal implementation code.
+namespace
+{
+/// Internal Keccak-f[1600] implementation.
+namespace keccak256
+{
+const uint64_t RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL};
+const int RHO[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+const int PI[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+uint64_t inline Rotl(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+/** Apply the Keccak-f[1600] permutation to a 25 word state. */
+void KeccakF(uint64_t* st)
+{
+    uint64_t bc[5];
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        for (int i = 0; i < 5; i++)
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        for (int i = 0; i < 5; i++) {
+            const uint64_t t = bc[(i + 4) % 5] ^ Rotl(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5)
+                st[j + i] ^= t;
+        }
+        // Rho and pi
+        uint64_t t = st[1];
+        for (int i = 0; i < 24; i++) {
+            const uint64_t tmp = st[PI[i]];
+            st[PI[i]] = Rotl(t, RHO[i]);
+            t = tmp;
+        }
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; i++)
+                bc[i] = st[j + i];
+            for (int i = 0; i < 5; i++)
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+        // Iota
+        st[0] ^= RC[round];
+    }
+}
+
+/** Return block nBlock of the padded input, the final block is assembled in pad. */
+const unsigned char* PaddedBlock(const unsigned char* in, size_t len, size_t nBlock, unsigned char* pad)
+{
+    const size_t nPos = nBlock * CKeccak256::RATE;
+    if (nPos + CKeccak256::RATE <= len)
+        return in + nPos;
+    const size_t nRest = len - nPos;
+    memset(pad, 0, CKeccak256::RATE);
+    if (nRest)
+        memcpy(pad, in + nPos, nRest);
+    pad[nRest] ^= 0x01;
+    pad[CKeccak256::RATE - 1] ^= 0x80;
+    return pad;
+}
+
+/** Number of permutations needed to absorb len bytes including the padding. */
+size_t inline Blocks(size_t len) { return len / CKeccak256::RATE + 1; }
+
+} // namespace keccak256
+
+typedef void (*KeccakF4WayFn)(uint64_t*);
+
+/** 4-way interleaved permutation, word i of lane l is at st[i * 4 + l]. Null when no SIMD implementation is in use. */
+KeccakF4WayFn KeccakF_4way = nullptr;
+
+/** Hash the inputs on the 4-way permutation, a lane is refilled with the next input as soon as its hash is done. */
+void Keccak256Many4Way(unsigned char* output, const unsigned char* const* inputs, const size_t* lens, size_t count)
+{
+    uint64_t st[25 * 4] = {0};
+    unsigned char pad[4][CKeccak256::RATE];
+    size_t vIndex[4], vBlock[4];
+    bool vActive[4];
+    size_t nNext = 0;
+    size_t nActive = 0;
+    for (int l = 0; l < 4; l++) {
+        vActive[l] = nNext < count;
+        vIndex[l] = nNext;
+        vBlock[l] = 0;
+        if (vActive[l]) {
+            nNext++;
+            nActive++;
+        }
+    }
+    while (nActive > 0) {
+        for (int l = 0; l < 4; l++) {
+            if (!vActive[l])
+                continue;
+            const unsigned char* block = keccak256::PaddedBlock(inputs[vIndex[l]], lens[vIndex[l]], vBlock[l], pad[l]);
+            for (size_t i = 0; i < CKeccak256::RATE / 8; i++)
+                st[i * 4 + l] ^= ReadLE64(block + i * 8);
+        }
+        KeccakF_4way(st);
+        for (int l = 0; l < 4; l++) {
+            if (!vActive[l] || ++vBlock[l] < keccak256::Blocks(lens[vIndex[l]]))
+                continue;
+            for (int i = 0; i < 4; i++)
+                WriteLE64(output + vIndex[l] * CKeccak256::OUTPUT_SIZE + i * 8, st[i * 4 + l]);
+            for (int i = 0; i < 25; i++)
+                st[i * 4 + l] = 0;
+            vBlock[l] = 0;
+            if (nNext < count) {
+                vIndex[l] = nNext++;
+            } else {
+                vActive[l] = false;
+                nActive--;
+            }
+        }
+    }
+}
+
+bool SelfTest()
+{
+    // Compare every lane of the 4-way permutation with the single lane one.
+    if (KeccakF_4way) {
+        uint64_t st[25 * 4];
+        uint64_t st1[4][25];
+        for (int i = 0; i < 25; i++) {
+            for (int l = 0; l < 4; l++)
+                st[i * 4 + l] = st1[l][i] = 0x0123456789abcdefULL * (i + 1) + l;
+        }
+        KeccakF_4way(st);
+        for (int l = 0; l < 4; l++) {
+            keccak256::KeccakF(st1[l]);
+            for (int i = 0; i < 25; i++) {
+                if (st[i * 4 + l] != st1[l][i]) return false;
+            }
+        }
+    }
+
+    // Keccak-256 of "abc" through both the streaming and the multi-buffer interface.
+    static const unsigned char result[CKeccak256::OUTPUT_SIZE] = {
+        0x4e, 0x03, 0x65, 0x7a, 0xea, 0x45, 0xa9, 0x4f, 0xc7, 0xd4, 0x7b, 0xa8, 0x26, 0xc8, 0xd6, 0x67,
+        0xc0, 0xd1, 0xe6, 0xe3, 0x3a, 0x64, 0xa0, 0x36, 0xec, 0x44, 0xf5, 0x8f, 0xa1, 0x2d, 0x6c, 0x45};
+    static const unsigned char abc[3] = {'a', 'b', 'c'};
+    unsigned char out[CKeccak256::OUTPUT_SIZE * 2];
+    CKeccak256().Write(abc, sizeof(abc)).Finalize(out);
+    if (memcmp(out, result, CKeccak256::OUTPUT_SIZE)) return false;
+    const unsigned char* inputs[2] = {abc, abc};
+    const size_t lens[2] = {sizeof(abc), sizeof(abc)};
+    Keccak256Many(out, inputs, lens, 2);
+    return !memcmp(out, result, CKeccak256::OUTPUT_SIZE) && !memcmp(out + CKeccak256::OUTPUT_SIZE, result, CKeccak256::OUTPUT_SIZE);
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+// We can't use cpuid.h's __get_cpuid as it does not support subleafs.
+void inline cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+#ifdef __GNUC__
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+#else
+  __asm__ ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(leaf), "2"(subleaf));
+#endif
+}
+
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+
+std::string Keccak256AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    bool have_xsave = false;
+    bool have_avx = false;
+    bool have_avx2 = false;
+    bool enabled_avx = false;
+
+    (void)AVXEnabled;
+    (void)have_avx;
+    (void)have_xsave;
+    (void)have_avx2;
+    (void)enabled_avx;
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    have_xsave = (ecx >> 27) & 1;
+    have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_PAYDAYCOIN_INTERNAL)
+    if (have_avx2 && have_avx && enabled_avx) {
+        KeccakF_4way = keccak256_avx2::KeccakF_4way;
+        ret += ",avx2(4way)";
+    }
+#endif
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
+
+////// Keccak-256
+
+CKeccak256::CKeccak256() : bufsize(0)
+{
+    memset(s, 0, sizeof(s));
+}
+
+CKeccak256& CKeccak256::Write(const unsigned char* data, size_t len)
+{
+    while (len > 0) {
+        const size_t nCopy = std::min(len, RATE - bufsize);
+        memcpy(buf + bufsize, data, nCopy);
+        bufsize += nCopy;
+        data += nCopy;
+        len -= nCopy;
+        if (bufsize == RATE) {
+            for (size_t i = 0; i < RATE / 8; i++)
+                s[i] ^= ReadLE64(buf + i * 8);
+            keccak256::KeccakF(s);
+            bufsize = 0;
+        }
+    }
+    return *this;
+}
+
+void CKeccak256::Finalize(unsigned char hash[OUTPUT_SIZE])
+{
+    unsigned char pad[RATE];
+    const unsigned char* block = keccak256::PaddedBlock(buf, bufsize, 0, pad);
+    for (size_t i = 0; i < RATE / 8; i++)
+        s[i] ^= ReadLE64(block + i * 8);
+    keccak256::KeccakF(s);
+    for (size_t i = 0; i < OUTPUT_SIZE / 8; i++)
+        WriteLE64(hash + i * 8, s[i]);
+    Reset();
+}
+
+CKeccak256& CKeccak256::Reset()
+{
+    memset(s, 0, sizeof(s));
+    bufsize = 0;
+    return *this;
+}
+
+void Keccak256Many(unsigned char* output, const unsigned char* const* inputs, const size_t* lens, size_t count)
+{
+    if (KeccakF_4way && count > 1) {
+        Keccak256Many4Way(output, inputs, lens, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+        CKeccak256().Write(inputs[i], lens[i]).Finalize(output + i * CKeccak256::OUTPUT_SIZE);
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PAYDAYCOIN_CRYPTO_KECCAK256_H
+#define PAYDAYCOIN_CRYPTO_KECCAK256_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** A hasher class for Keccak-256, the pre-FIPS 202 padding used by Ethereum. */
+class CKeccak256
+{
+public:
+    static const size_t OUTPUT_SIZE = 32;
+    static const size_t RATE = 136;
+
+private:
+    uint64_t s[25];
+    unsigned char buf[RATE];
+    size_t bufsize;
+
+public:
+    CKeccak256();
+    CKeccak256& Write(const unsigned char* data, size_t len);
+    void Finalize(unsigned char hash[OUTPUT_SIZE]);
+    CKeccak256& Reset();
+};
+
+/** Autodetect the best available Keccak-f[1600] implementation.
+ *  Returns the name of the implementation.
+ */
+std::string Keccak256AutoDetect();
+
+/** Compute the Keccak-256 of multiple independent inputs, several at a time when a SIMD
+ *  implementation is available.
+ *  output:  pointer to a count*32 byte output buffer
+ *  inputs:  pointers to the count inputs
+ *  lens:    the lengths of the count inputs
+ *  count:   the number of hashes to compute.
+ */
+void Keccak256Many(unsigned char* output, const unsigned char* const* inputs, const size_t* lens, size_t count);
+
+#endif // PAYDAYCOIN_CRYPTO_KECCAK256_H
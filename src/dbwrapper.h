@@ -133,6 +133,8 @@ public:
     bool Valid() const;
 
     void SeekToFirst();
+    // PAYDAYCOIN
+    void SeekToLast();
 
     template<typename K> void Seek(const K& key) {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -143,6 +145,8 @@ public:
     }
 
     void Next();
+    // PAYDAYCOIN
+    void Prev();
 
     template<typename K> bool GetKey(K& key) {
         leveldb::Slice slKey = piter->key();
@@ -171,6 +175,11 @@ public:
         return piter->value().size();
     }
 
+    // PAYDAYCOIN
+    unsigned int GetKeySize() {
+        return piter->key().size();
+    }
+
 };
 
 class CDBWrapper
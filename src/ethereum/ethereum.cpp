@@ -31,12 +31,19 @@ bool VerifyProof(bytesConstRef path, const RLP& value, const RLP& parentNodes, c
         int pathPtr = 0;
 
     	const std::string pathString = toHex(path);
+
+        // PAYDAYCOIN hash all the nodes up front so they go through the multi-buffer Keccak together
+        std::vector<bytesConstRef> vecNodes;
+        vecNodes.reserve(len);
+        for (int i = 0 ; i < len ; i++)
+          vecNodes.push_back(parentNodes[i].data());
+        const std::vector<h256> vecNodeHashes = sha3Many(vecNodes);
   
         int nibbles;
         char pathPtrInt[2];
         for (int i = 0 ; i < len ; i++) {
           currentNode = parentNodes[i];
-          if(!nodeKey.payload().contentsEqual(sha3(currentNode.data()).ref().toVector())){
+          if(!nodeKey.payload().contentsEqual(vecNodeHashes[i].ref())){
             return false;
           } 
 
@@ -47,7 +54,7 @@ bool VerifyProof(bytesConstRef path, const RLP& value, const RLP& parentNodes, c
           switch(currentNode.itemCount()){
             case 17://branch node
               if(pathPtr == (int)pathString.size()){
-                if(currentNode[16].payload().contentsEqual(value.data().toVector())){
+                if(currentNode[16].payload().contentsEqual(value.data())){
     
                   return true;
                 }else{
@@ -69,7 +76,7 @@ bool VerifyProof(bytesConstRef path, const RLP& value, const RLP& parentNodes, c
               pathPtr += nibbles;
       
               if(pathPtr == (int)pathString.size()) { //leaf node
-                if(currentNode[1].payload().contentsEqual(value.data().toVector())){
+                if(currentNode[1].payload().contentsEqual(value.data())){
          
                   return true;
                 } else {
@@ -100,16 +107,13 @@ bool VerifyProof(bytesConstRef path, const RLP& value, const RLP& parentNodes, c
  * @param nAsset The asset burned or 0 for PDAY 
  * @return true if everything is valid
  */
-bool parseEthMethodInputData(const std::vector<unsigned char>& vchInputExpectedMethodHash, const std::vector<unsigned char>& vchInputData, CAmount& outputAmount, uint32_t& nAsset, CWitnessAddress& witnessAddress) {
+bool parseEthMethodInputData(const std::vector<unsigned char>& vchInputExpectedMethodHash, bytesConstRef vchInputData, CAmount& outputAmount, uint32_t& nAsset, CWitnessAddress& witnessAddress) {
     // 132 for the varint position + 1 for varint + 1 for version + 3 minimum for witness program bytes
     if(vchInputData.size() < 137) 
         return false;  
     // method hash is 4 bytes
-    std::vector<unsigned char>::const_iterator first = vchInputData.begin();
-    std::vector<unsigned char>::const_iterator last = first + 4;
-    const std::vector<unsigned char> vchMethodHash(first,last);
     // if the method hash doesn't match the expected method hash then return false
-    if(vchMethodHash != vchInputExpectedMethodHash) 
+    if(!vchInputData.cropped(0, 4).contentsEqual(vchInputExpectedMethodHash)) 
         return false;
 
     // get the first parameter and convert to CAmount and assign to output var
@@ -140,9 +144,10 @@ bool parseEthMethodInputData(const std::vector<unsigned char>& vchInputExpectedM
         return false;
     // witness address information starting at position dataPos till the end
     // get version proceeded by witness program bytes
+    // the witness program must lie within the input data
+    if(vchInputData.size() < (size_t)dataPos + dataLength)
+        return false;
     const unsigned char& nVersion = vchInputData[dataPos++];
-    std::vector<unsigned char>::const_iterator firstWitness = vchInputData.begin()+dataPos;
-    std::vector<unsigned char>::const_iterator lastWitness = firstWitness + (dataLength-1);
-    witnessAddress = CWitnessAddress(nVersion, std::vector<unsigned char>(firstWitness,lastWitness));
+    witnessAddress = CWitnessAddress(nVersion, vchInputData.cropped(dataPos, dataLength-1).toVector());
     return witnessAddress.IsValid();
 }
\ No newline at end of file
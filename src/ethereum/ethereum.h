@@ -12,5 +12,5 @@
 class CWitnessAddress;
 
 bool VerifyProof(dev::bytesConstRef path, const dev::RLP& value, const dev::RLP& parentNodes, const dev::RLP& root); 
-bool parseEthMethodInputData(const std::vector<unsigned char>& vchInputExpectedMethodHash, const std::vector<unsigned char>& vchInputData, CAmount& outputAmount, uint32_t& nAsset, CWitnessAddress& witnessAddress);
+bool parseEthMethodInputData(const std::vector<unsigned char>& vchInputExpectedMethodHash, dev::bytesConstRef vchInputData, CAmount& outputAmount, uint32_t& nAsset, CWitnessAddress& witnessAddress);
 #endif // PAYDAYCOIN_ETHEREUM_ETHEREUM_H
@@ -10,6 +10,7 @@
 #include <clientversion.h>
 #include <hash.h>
 #include <streams.h>
+#include <util/system.h>
 
 #include <boost/filesystem.hpp>
 
@@ -51,11 +52,13 @@ private:
         uint256 hash = Hash(ssObj.begin(), ssObj.end());
         ssObj << hash;
 
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        // open temp output file, and associate with CAutoFile
+        // the caches are also dumped periodically, a crash while writing must not leave a truncated file in place
+        boost::filesystem::path pathTmp = pathDB.string() + ".new";
+        FILE *file = fopen(pathTmp.string().c_str(), "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
         // Write and commit header, data
         try {
@@ -64,8 +67,14 @@ private:
         catch (std::exception &e) {
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        if (!FileCommit(fileout.Get()))
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
         fileout.fclose();
 
+        // replace existing file, if any, with new file
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Rename-into-place failed", __func__);
+
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
 
@@ -7,6 +7,7 @@
 #define PAYDAYCOIN_GOVERNANCEVOTE_H
 
 #include <key.h>
+#include <messagesigner.h>
 #include <primitives/transaction.h>
 
 class CGovernanceVote;
@@ -93,6 +94,8 @@ public:
 
     bool Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode);
     bool CheckSignature(const CPubKey& pubKeyMasternode) const;
+    /// The signature CheckSignature verifies, for checking it ahead of time with CHashSigner::VerifyHashes
+    CHashSignature GetHashSignature(const CPubKey& pubKeyMasternode) const { return CHashSignature(GetSignatureHash(), pubKeyMasternode.GetID(), vchSig); }
     bool IsValid(bool fSignatureCheck) const;
     void Relay(CConnman& connman) const;
 
@@ -0,0 +1,375 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/assetindex.h>
+#include <services/asset.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <map>
+#include <set>
+
+/* Every asset and every allocation gets its own monotonic sequence of indexed transactions:
+ *  - [seq prefix, owner, uint64 seq (BE)] -> txid
+ *  - [next seq prefix, owner] -> next sequence number of owner
+ *  - [tx seq prefix, txid, owner] -> sequence number of txid, so rewinds find the entry without a scan
+ * The owner is the asset guid (BE) or the binary allocation tuple key. Sequence numbers are big-endian
+ * so the transactions of one owner are contiguous and ordered, a page is one seek plus a short scan.
+ * The CAssetIndexTxRecord of every indexed transaction is stored under [DB_ASSET_PAYLOAD, txid].
+ */
+constexpr char DB_ASSET_PAYLOAD = 'p';
+
+namespace {
+
+struct IndexPrefixes {
+    char seq;
+    char next_seq;
+    char tx_seq;
+};
+constexpr IndexPrefixes ASSET_PREFIXES{'a', 'A', 'x'};
+constexpr IndexPrefixes ALLOCATION_PREFIXES{'l', 'L', 'y'};
+
+template<typename Stream> inline void SerializeIndexOwner(Stream& s, const uint32_t& nAsset) { ser_writedata32be(s, nAsset); }
+template<typename Stream> inline void UnserializeIndexOwner(Stream& s, uint32_t& nAsset) { nAsset = ser_readdata32be(s); }
+template<typename Stream> inline void SerializeIndexOwner(Stream& s, const CAssetAllocationTupleKey& allocationKey) { s << allocationKey; }
+template<typename Stream> inline void UnserializeIndexOwner(Stream& s, CAssetAllocationTupleKey& allocationKey) { s >> allocationKey; }
+
+template <typename Owner>
+struct DBSeqKey {
+    Owner owner;
+    uint64_t seq;
+
+    DBSeqKey() : owner(), seq(0) {}
+    DBSeqKey(const Owner& owner_in, uint64_t seq_in) : owner(owner_in), seq(seq_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        SerializeIndexOwner(s, owner);
+        ser_writedata32be(s, (uint32_t)(seq >> 32));
+        ser_writedata32be(s, (uint32_t)seq);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        UnserializeIndexOwner(s, owner);
+        seq = (uint64_t)ser_readdata32be(s) << 32;
+        seq |= ser_readdata32be(s);
+    }
+};
+
+template <typename Key>
+std::vector<unsigned char> SerializeIndexKey(const Key& key)
+{
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << key;
+    return std::vector<unsigned char>(ssKey.begin(), ssKey.end());
+}
+
+}; // namespace
+
+std::unique_ptr<AssetIndex> g_assetindex;
+
+/** Writes of one block, its sequence numbers are tracked here until the batch is written */
+struct AssetIndex::Batch
+{
+    CDBBatch batch;
+    /// Next sequence number of every owner appended to, by serialized next seq key
+    std::map<std::vector<unsigned char>, uint64_t> mapNextSeqs;
+    /// Serialized tx seq keys written by the batch
+    std::set<std::vector<unsigned char>> setTxKeys;
+
+    explicit Batch(const CDBWrapper& db) : batch(db) {}
+};
+
+class AssetIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    template <typename Owner>
+    bool AppendIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid, AssetIndex::Batch& batch);
+
+    template <typename Owner>
+    bool AppendIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid);
+
+    template <typename Owner>
+    bool ReadIndexTXIDs(const IndexPrefixes& prefixes, const Owner& owner, const int64_t& page, std::vector<uint256>& TXIDS) const;
+
+    template <typename Owner>
+    bool EraseIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid);
+};
+
+AssetIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "assetindex", n_cache_size, f_memory, f_wipe)
+{}
+
+template <typename Owner>
+bool AssetIndex::DB::AppendIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid, AssetIndex::Batch& batch)
+{
+    const auto tx_key = std::make_pair(prefixes.tx_seq, std::make_pair(txid, owner));
+    std::vector<unsigned char> vchTxKey = SerializeIndexKey(tx_key);
+    // already indexed, a sender can also be one of the receivers, ZDAG sends are indexed on mempool entry
+    // and blocks are indexed again after an unclean shutdown
+    if (batch.setTxKeys.count(vchTxKey) || Exists(tx_key)) {
+        return true;
+    }
+    const auto next_key = std::make_pair(prefixes.next_seq, owner);
+    std::vector<unsigned char> vchNextKey = SerializeIndexKey(next_key);
+    uint64_t seq = 0;
+    auto itNextSeq = batch.mapNextSeqs.find(vchNextKey);
+    if (itNextSeq != batch.mapNextSeqs.end()) {
+        seq = itNextSeq->second;
+    } else if (Exists(next_key) && !Read(next_key, seq)) {
+        return false;
+    }
+    batch.batch.Write(std::make_pair(prefixes.seq, DBSeqKey<Owner>(owner, seq)), txid);
+    batch.batch.Write(tx_key, seq);
+    batch.batch.Write(next_key, seq + 1);
+    batch.mapNextSeqs[std::move(vchNextKey)] = seq + 1;
+    batch.setTxKeys.insert(std::move(vchTxKey));
+    return true;
+}
+
+template <typename Owner>
+bool AssetIndex::DB::AppendIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid)
+{
+    AssetIndex::Batch batch(*this);
+    return AppendIndexTXID(prefixes, owner, txid, batch) && WriteBatch(batch.batch);
+}
+
+template <typename Owner>
+bool AssetIndex::DB::ReadIndexTXIDs(const IndexPrefixes& prefixes, const Owner& owner, const int64_t& page, std::vector<uint256>& TXIDS) const
+{
+    TXIDS.clear();
+    uint64_t next_seq = 0;
+    Read(std::make_pair(prefixes.next_seq, owner), next_seq);
+    const uint64_t page_size = fAssetIndexPageSize;
+    if (next_seq == 0) {
+        return page == 0;
+    }
+    if (next_seq <= page * page_size) {
+        return false;
+    }
+    // pages are counted back from the newest sequence number, entries erased out of order just leave a shorter page
+    const uint64_t end = next_seq - page * page_size;
+    const uint64_t begin = end > page_size ? end - page_size : 0;
+    std::unique_ptr<CDBIterator> pcursor(const_cast<AssetIndex::DB*>(this)->NewIterator());
+    pcursor->Seek(std::make_pair(prefixes.seq, DBSeqKey<Owner>(owner, begin)));
+    std::pair<char, DBSeqKey<Owner>> key;
+    uint256 txid;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        if (!pcursor->GetKey(key) || key.first != prefixes.seq || !(key.second.owner == owner) || key.second.seq >= end) {
+            break;
+        }
+        if (!pcursor->GetValue(txid)) {
+            return error("%s: cannot read txid of asset index entry", __func__);
+        }
+        TXIDS.push_back(txid);
+    }
+    return true;
+}
+
+template <typename Owner>
+bool AssetIndex::DB::EraseIndexTXID(const IndexPrefixes& prefixes, const Owner& owner, const uint256& txid)
+{
+    const auto tx_key = std::make_pair(prefixes.tx_seq, std::make_pair(txid, owner));
+    uint64_t seq;
+    if (!Read(tx_key, seq)) {
+        return false;
+    }
+    CDBBatch batch(*this);
+    batch.Erase(std::make_pair(prefixes.seq, DBSeqKey<Owner>(owner, seq)));
+    batch.Erase(tx_key);
+    // rewinds undo the newest transactions first, handing their sequence numbers out again keeps the pages dense
+    const auto next_key = std::make_pair(prefixes.next_seq, owner);
+    uint64_t next_seq;
+    if (Read(next_key, next_seq) && next_seq == seq + 1) {
+        batch.Write(next_key, seq);
+    }
+    return WriteBatch(batch);
+}
+
+AssetIndex::AssetIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AssetIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AssetIndex::~AssetIndex() {}
+
+BaseIndex::DB& AssetIndex::GetDB() const { return *m_db; }
+
+/** Decode the index record of tx with the asset and the allocations it is listed under, false if tx is not indexed */
+static bool GetIndexEntries(const CTransaction& tx, const int nHeight, const uint256& blockhash, CAssetIndexTxRecord& record,
+                            uint32_t& nAsset, std::vector<CAssetAllocationTupleKey>& vecAllocations)
+{
+    if (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT) {
+        if (!record.FromMintTx(tx, nHeight, blockhash)) {
+            return false;
+        }
+        nAsset = record.mintPaydayCoin.assetAllocationTuple.nAsset;
+        // mints are listed under the burn address the funds came from and under the receiver
+        vecAllocations.emplace_back(CAssetAllocationTuple(nAsset, CWitnessAddress(0, vchFromString("burn"))));
+        vecAllocations.emplace_back(record.mintPaydayCoin.assetAllocationTuple);
+    } else if (IsAssetAllocationTx(tx.nVersion) || tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND) {
+        if (!record.FromAssetAllocationTx(tx, nHeight, blockhash)) {
+            return false;
+        }
+        nAsset = record.assetAllocation.assetAllocationTuple.nAsset;
+        vecAllocations.emplace_back(record.assetAllocation.assetAllocationTuple);
+        for (const auto& amountTuple : record.assetAllocation.listSendingAllocationAmounts) {
+            vecAllocations.emplace_back(CAssetAllocationTuple(nAsset, amountTuple.first));
+        }
+    } else if (IsAssetTx(tx.nVersion)) {
+        if (!record.FromAssetTx(tx, nHeight, blockhash)) {
+            return false;
+        }
+        nAsset = record.asset.nAsset;
+    } else {
+        return false;
+    }
+    return fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), nAsset) != fAssetIndexGuids.end();
+}
+
+bool AssetIndex::IndexTransaction(const CTransaction& tx, const int nHeight, const uint256& blockhash, Batch& batch)
+{
+    CAssetIndexTxRecord record;
+    uint32_t nAsset;
+    std::vector<CAssetAllocationTupleKey> vecAllocations;
+    if (!GetIndexEntries(tx, nHeight, blockhash, record, nAsset, vecAllocations)) {
+        return true;
+    }
+    const uint256& txid = tx.GetHash();
+    for (const CAssetAllocationTupleKey& allocationKey : vecAllocations) {
+        if (!m_db->AppendIndexTXID(ALLOCATION_PREFIXES, allocationKey, txid, batch)) {
+            return false;
+        }
+    }
+    if (!m_db->AppendIndexTXID(ASSET_PREFIXES, nAsset, txid, batch)) {
+        return false;
+    }
+    // the payload of a send indexed on mempool entry is replaced by the one of the confirming block
+    batch.batch.Write(std::make_pair(DB_ASSET_PAYLOAD, txid), record);
+    return true;
+}
+
+void AssetIndex::EraseTransaction(const CTransaction& tx)
+{
+    CAssetIndexTxRecord record;
+    uint32_t nAsset;
+    std::vector<CAssetAllocationTupleKey> vecAllocations;
+    if (!GetIndexEntries(tx, 0, uint256(), record, nAsset, vecAllocations)) {
+        return;
+    }
+    // entries may be gone already when a rewind is repeated after an unclean shutdown
+    const uint256& txid = tx.GetHash();
+    for (const CAssetAllocationTupleKey& allocationKey : vecAllocations) {
+        m_db->EraseIndexTXID(ALLOCATION_PREFIXES, allocationKey, txid);
+    }
+    m_db->EraseIndexTXID(ASSET_PREFIXES, nAsset, txid);
+    m_db->Erase(std::make_pair(DB_ASSET_PAYLOAD, txid));
+}
+
+bool AssetIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    LOCK(cs_index);
+    Batch batch(*m_db);
+    const uint256& blockhash = pindex->GetBlockHash();
+    for (const CTransactionRef& tx : block.vtx) {
+        if (IsPaydayCoinTx(tx->nVersion) && !IndexTransaction(*tx, pindex->nHeight, blockhash, batch)) {
+            return error("%s: failed to index transaction %s", __func__, tx->GetHash().ToString());
+        }
+    }
+    return m_db->WriteBatch(batch.batch);
+}
+
+bool AssetIndex::IndexUnconfirmedTransaction(const CTransaction& tx, const int nHeight, const uint256& blockhash)
+{
+    // an index catching up would list the send ahead of the older blocks it has yet to index
+    if (!IsSynced()) {
+        return true;
+    }
+    LOCK(cs_index);
+    Batch batch(*m_db);
+    if (!IndexTransaction(tx, nHeight, blockhash, batch)) {
+        return error("%s: failed to index transaction %s", __func__, tx.GetHash().ToString());
+    }
+    return m_db->WriteBatch(batch.batch);
+}
+
+bool AssetIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    LOCK(cs_index);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        for (auto it = block.vtx.rbegin(); it != block.vtx.rend(); ++it) {
+            if (IsPaydayCoinTx((*it)->nVersion)) {
+                EraseTransaction(**it);
+            }
+        }
+    }
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+void AssetIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    if (!IsSynced()) {
+        return;
+    }
+    const CBlockIndex* best_block_index = GetBestBlockIndex();
+    if (!best_block_index || !best_block_index->pprev || best_block_index->GetBlockHash() != block->GetHash()) {
+        return;
+    }
+    if (!Rewind(best_block_index, best_block_index->pprev)) {
+        // BaseIndex retries the rewind once a block of the new branch connects
+        LogPrintf("%s: failed to rewind %s past disconnected block %s\n", __func__, GetName(), block->GetHash().ToString());
+    }
+}
+
+bool AssetIndex::AppendIndexTXID(const uint32_t& assetGuid, const uint256& txid)
+{
+    LOCK(cs_index);
+    return m_db->AppendIndexTXID(ASSET_PREFIXES, assetGuid, txid);
+}
+
+bool AssetIndex::AppendIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid)
+{
+    LOCK(cs_index);
+    return m_db->AppendIndexTXID(ALLOCATION_PREFIXES, CAssetAllocationTupleKey(allocationTuple), txid);
+}
+
+bool AssetIndex::ReadIndexTXIDs(const uint32_t& assetGuid, const int64_t& page, std::vector<uint256>& TXIDS) const
+{
+    return m_db->ReadIndexTXIDs(ASSET_PREFIXES, assetGuid, page, TXIDS);
+}
+
+bool AssetIndex::ReadIndexTXIDs(const CAssetAllocationTuple& allocationTuple, const int64_t& page, std::vector<uint256>& TXIDS) const
+{
+    return m_db->ReadIndexTXIDs(ALLOCATION_PREFIXES, CAssetAllocationTupleKey(allocationTuple), page, TXIDS);
+}
+
+bool AssetIndex::EraseIndexTXID(const uint32_t& assetGuid, const uint256& txid)
+{
+    LOCK(cs_index);
+    return m_db->EraseIndexTXID(ASSET_PREFIXES, assetGuid, txid);
+}
+
+bool AssetIndex::EraseIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid)
+{
+    LOCK(cs_index);
+    return m_db->EraseIndexTXID(ALLOCATION_PREFIXES, CAssetAllocationTupleKey(allocationTuple), txid);
+}
+
+bool AssetIndex::ReadPayload(const uint256& txid, UniValue& payload) const
+{
+    CAssetIndexTxRecord record;
+    return m_db->Read(std::make_pair(DB_ASSET_PAYLOAD, txid), record) && record.ToJSON(txid, payload);
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PAYDAYCOIN_INDEX_ASSETINDEX_H
+#define PAYDAYCOIN_INDEX_ASSETINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <sync.h>
+
+class CAssetAllocationTuple;
+class UniValue;
+
+/**
+ * AssetIndex lists the transactions of every asset and asset allocation, newest first in pages of
+ * -assetindexpagesize transactions. It is built from BlockConnected notifications and catches up in
+ * its own thread, so indexing never runs inside ConnectBlock. ZDAG sends are also indexed as they enter
+ * the mempool. Every block is written in a single batch.
+ */
+class AssetIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    struct Batch;
+
+    const std::unique_ptr<DB> m_db;
+
+    /// Serializes the sequence number updates of the index thread and the mempool.
+    CCriticalSection cs_index;
+
+    /// Add the entries and the payload of an asset, allocation or asset mint transaction to batch.
+    bool IndexTransaction(const CTransaction& tx, const int nHeight, const uint256& blockhash, Batch& batch);
+
+    /// Remove the entries IndexTransaction wrote for tx.
+    void EraseTransaction(const CTransaction& tx);
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    /// Erase the transactions of the rewound blocks before moving the best block back.
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "assetindex"; }
+
+    /// Rewind right away instead of waiting for the next block of the new branch.
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AssetIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AssetIndex() override;
+
+    /// Index a ZDAG send as it enters the mempool, the block confirming it only refreshes its payload.
+    bool IndexUnconfirmedTransaction(const CTransaction& tx, const int nHeight, const uint256& blockhash);
+
+    /// Append txid to the transactions of an asset or an allocation, indexing a txid twice is a no-op.
+    bool AppendIndexTXID(const uint32_t& assetGuid, const uint256& txid);
+    bool AppendIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid);
+
+    /// Transactions on a page, page 0 being the most recent, false if the page is past the oldest one.
+    bool ReadIndexTXIDs(const uint32_t& assetGuid, const int64_t& page, std::vector<uint256>& TXIDS) const;
+    bool ReadIndexTXIDs(const CAssetAllocationTuple& allocationTuple, const int64_t& page, std::vector<uint256>& TXIDS) const;
+
+    bool EraseIndexTXID(const uint32_t& assetGuid, const uint256& txid);
+    bool EraseIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid);
+
+    /// Render the indexed record of txid as JSON.
+    bool ReadPayload(const uint256& txid, UniValue& payload) const;
+};
+
+/// The global asset index, used by listassetindex. May be null.
+extern std::unique_ptr<AssetIndex> g_assetindex;
+
+#endif // PAYDAYCOIN_INDEX_ASSETINDEX_H
@@ -108,6 +108,12 @@ public:
 
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
+
+    /// Whether the initial sync has finished and the index follows the chain through notifications.
+    bool IsSynced() const { return m_synced; }
+
+    /// The last block the index is in sync with, null before the genesis block has been indexed.
+    const CBlockIndex* GetBestBlockIndex() const { return m_best_block_index.load(); }
 };
 
 #endif // PAYDAYCOIN_INDEX_BASE_H
@@ -17,11 +17,13 @@
 #include <chainparams.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/keccak256.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
 #include <index/blockfilterindex.h>
 #include <interfaces/chain.h>
+#include <index/assetindex.h>
 #include <index/txindex.h>
 #include <key.h>
 #include <validation.h>
@@ -92,10 +94,6 @@
 #include <util/executable_path/include/boost/executable_path.hpp>
 #include <util/executable_path/include/boost/detail/executable_path_internals.hpp>
 std::string exePath = "";
-extern AssetBalanceMap mempoolMapAssetBalances;
-extern ArrivalTimesMapImpl arrivalTimesMap; 
-extern CCriticalSection cs_assetallocation;
-extern CCriticalSection cs_assetallocationarrival;
 static CDSNotificationInterface* pdsNotificationInterface = NULL;
 
 static bool fFeeEstimatesInitialized = false;
@@ -105,6 +103,8 @@ static const bool DEFAULT_STOPAFTERBLOCKIMPORT = false;
 
 // Dump addresses to banlist.dat every 15 minutes (900s)
 static constexpr int DUMP_BANS_INTERVAL = 60 * 15;
+// PAYDAYCOIN Dump the masternode, payment and governance caches every 15 minutes (900s)
+static constexpr int DUMP_MASTERNODE_CACHES_INTERVAL = 60 * 15;
 
 std::unique_ptr<CConnman> g_connman;
 std::unique_ptr<PeerLogicValidation> peerLogic;
@@ -222,6 +222,23 @@ static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 static boost::thread_group threadGroup;
 static CScheduler scheduler;
 
+// PAYDAYCOIN
+/** Write the masternode, payment, governance and fulfilled request caches so a restart only has to sync the delta */
+static void DumpMasternodeCaches()
+{
+    // the periodic dump may still be running when shutdown dumps
+    static CCriticalSection cs_dump;
+    LOCK(cs_dump);
+    CFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
+    flatdb1.Dump(mnodeman);
+    CFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    flatdb2.Dump(mnpayments);
+    CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    flatdb3.Dump(governance);
+    CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
+    flatdb4.Dump(netfulfilledman);
+}
+
 void Interrupt()
 {
     InterruptHTTPServer();
@@ -235,6 +252,10 @@ void Interrupt()
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    // PAYDAYCOIN
+    if (g_assetindex) {
+        g_assetindex->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
 }
 
@@ -259,8 +280,7 @@ void Shutdown(InitInterfaces& interfaces)
     StopHTTPServer();
     if (!fLiteMode) {
         // STORE DATA CACHES INTO SERIALIZED DAT FILES
-        CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
-        flatdb4.Dump(netfulfilledman);
+        DumpMasternodeCaches();
     }
     for (const auto& client : interfaces.chain_clients) {
         client->flush();
@@ -272,6 +292,8 @@ void Shutdown(InitInterfaces& interfaces)
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    // PAYDAYCOIN
+    if (g_assetindex) g_assetindex->Stop();
     if (g_auxpow_miner != nullptr) {
         g_auxpow_miner.reset();
     }
@@ -290,6 +312,8 @@ void Shutdown(InitInterfaces& interfaces)
     g_connman.reset();
     g_banman.reset();
     g_txindex.reset();
+    // PAYDAYCOIN
+    g_assetindex.reset();
     DestroyAllBlockFilterIndexes();
 
     if (::mempool.IsLoaded() && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
@@ -323,14 +347,13 @@ void Shutdown(InitInterfaces& interfaces)
     // up with our current chain to avoid any strange pruning edge cases and make
     // next startup faster by avoiding rescan.
     // PAYDAYCOIN
-    arrivalTimesMap.clear();
+    zdagState.ClearArrivalTimes();
     FlushPaydayCoinDBs();
     passetdb.reset();
     passetallocationdb.reset();
     passetallocationmempooldb.reset();
     pethereumtxrootsdb.reset();
     pethereumtxmintdb.reset();
-    passetindexdb.reset();
     pblockindexdb.reset();
 	plockedoutpointsdb.reset();
     if (threadpool)
@@ -491,6 +514,7 @@ void SetupServerArgs()
     gArgs.AddArg("-masternodeprivkey=<n>", "Set the masternode private key", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-assetindex=<n>", strprintf("Index PaydayCoin Assets for historical information (0-1, default: 0)"), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-assetindexpagesize=<n>", strprintf("Page size of results for Asset index, should match the paging mechanism of the consuming client. (10-1000, default: 25). Used in conjunction with -assetindex=1."), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-assetdbcache=<n>", strprintf("Maximum in-memory cache size of asset and asset allocation records <n> MiB, written back together with the chainstate (default: %d)", DEFAULT_ASSET_DB_CACHE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-assetindexguids=<guid>", strprintf("Whitelist Assets to index, comma separated. Used in conjunction with -assetindex=1. Leave empty for all."), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-tpstest", strprintf("TPSTest for unittest. Leave false"), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-sporkkey=<key>", strprintf("Private key for use with sporks"), false, OptionsCategory::OPTIONS);
@@ -1104,6 +1128,9 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        // PAYDAYCOIN
+        if (gArgs.GetBoolArg("-assetindex", false))
+            return InitError(_("Prune mode is incompatible with -assetindex."));
         if (!g_enabled_filter_types.empty()) {
             return InitError(_("Prune mode is incompatible with -blockfilterindex."));
         }
@@ -1327,6 +1354,9 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    // PAYDAYCOIN
+    std::string keccak256_algo = Keccak256AutoDetect();
+    LogPrintf("Using the '%s' Keccak256 implementation\n", keccak256_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1405,6 +1435,9 @@ bool AppInitMain(InitInterfaces& interfaces)
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    // PAYDAYCOIN
+    InitEthereumProofCache();
+    InitHashSignerCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
@@ -1412,6 +1445,12 @@ bool AppInitMain(InitInterfaces& interfaces)
             threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
     }
     // PAYDAYCOIN
+    if (nScriptCheckThreads) {
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread([i]() { return ThreadAssetCheck(i); });
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread([i]() { return ThreadHashSignerCheck(i); });
+    }
     if (!threadpool) {
         threadpool = new tp::ThreadPool;
         LogPrint(BCLog::THREADPOOL, "THREADPOOL::Created threadpool\n");
@@ -1602,6 +1641,9 @@ bool AppInitMain(InitInterfaces& interfaces)
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    // PAYDAYCOIN
+    int64_t nAssetIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-assetindex", false) ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= nAssetIndexCache;
     int64_t filter_index_cache = 0;
     if (!g_enabled_filter_types.empty()) {
         size_t n_indexes = g_enabled_filter_types.size();
@@ -1613,6 +1655,8 @@ bool AppInitMain(InitInterfaces& interfaces)
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
+    // PAYDAYCOIN
+    nAssetCacheUsage = std::max(gArgs.GetArg("-assetdbcache", DEFAULT_ASSET_DB_CACHE), (int64_t)1) << 20;
     int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1f MiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
@@ -1620,6 +1664,10 @@ bool AppInitMain(InitInterfaces& interfaces)
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
     // PAYDAYCOIN
+    if (gArgs.GetBoolArg("-assetindex", false)) {
+        LogPrintf("* Using %.1f MiB for asset index database\n", nAssetIndexCache * (1.0 / 1024 / 1024));
+    }
+    // PAYDAYCOIN
     fLoaded = false;
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
@@ -1627,6 +1675,7 @@ bool AppInitMain(InitInterfaces& interfaces)
     }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1f MiB for in-memory asset and asset allocation records\n", nAssetCacheUsage * (1.0 / 1024 / 1024));
 
     while (!fLoaded && !ShutdownRequested()) {
         bool fReset = fReindex;
@@ -1651,29 +1700,23 @@ bool AppInitMain(InitInterfaces& interfaces)
                 passetallocationmempooldb.reset();
                 pethereumtxrootsdb.reset();
                 pethereumtxmintdb.reset();
-                passetindexdb.reset();
                 pblockindexdb.reset();
 				plockedoutpointsdb.reset();
 
 				plockedoutpointsdb.reset(new CLockedOutpointsDB(nCoinDBCache * 16, false, fReset));
                 passetdb.reset(new CAssetDB(nCoinDBCache*16, false, fReset || fReindexChainState));
                 passetallocationdb.reset(new CAssetAllocationDB(nCoinDBCache*32, false, fReset || fReindexChainState));
-                passetallocationmempooldb.reset(new CAssetAllocationMempoolDB(0, false, fReset || fReindexChainState));
-                {
-                    LOCK(cs_assetallocation);
-                    passetallocationmempooldb->ReadAssetAllocationMempoolBalances(mempoolMapAssetBalances);
+                if (!CheckAssetKeyLayout(*passetdb) || !CheckAssetKeyLayout(*passetallocationdb)) {
+                    strLoadError = _("The asset databases use an old format, you need to rebuild them using -reindex-chainstate");
+                    break;
                 }
-                {
-                    LOCK(cs_assetallocationarrival);
-                    passetallocationmempooldb->ReadAssetAllocationMempoolArrivalTimes(arrivalTimesMap);
-                }                
+                passetallocationmempooldb.reset(new CAssetAllocationMempoolDB(0, false, fReset || fReindexChainState));
+                passetallocationmempooldb->LoadZDAGState(zdagState);
                 // we don't need to ever reset the txroots db because it is an external chain not related to paydaycoin chain
                 pethereumtxrootsdb.reset(new CEthereumTxRootsDB(nCoinDBCache*16, false, false));
                 pethereumtxmintdb.reset(new CEthereumMintedTxDB(nCoinDBCache, false, fReset || fReindexChainState));
                 pblockindexdb.reset(new CBlockIndexDB(nCoinDBCache, false, fReset || fReindexChainState));
                 fAssetIndex = gArgs.GetBoolArg("-assetindex", false);
-                if(fAssetIndex)
-                    passetindexdb.reset(new CAssetIndexDB(nCoinDBCache*16, false, fReset));
                 // new CBlockTreeDB tries to delete the existing file, which
                 // fails if it's still open from the previous loop. Close it first:
                 pblocktree.reset();
@@ -1739,6 +1782,12 @@ bool AppInitMain(InitInterfaces& interfaces)
                     break;
                 }
 
+                // PAYDAYCOIN finish applying asset state that was flushed with the chainstate before an unclean shutdown
+                if (!ReplayAssetStateJournal(*pcoinsdbview)) {
+                    strLoadError = _("Unable to replay the asset state journal. You will need to rebuild the database using -reindex-chainstate.");
+                    break;
+                }
+
                 // The on-disk coinsdb is now in a good state, create the cache
                 pcoinsTip.reset(new CCoinsViewCache(pcoinscatcher.get()));
 
@@ -1843,6 +1892,32 @@ bool AppInitMain(InitInterfaces& interfaces)
         g_txindex->Start();
     }
 
+    // PAYDAYCOIN
+    // the guid whitelist must be known before the asset index starts syncing in its own thread
+    fAssetIndexPageSize = gArgs.GetArg("-assetindexpagesize", 25);
+    if(fAssetIndexPageSize < 10 || fAssetIndexPageSize > 1000){
+        return InitError(_("Asset index page size is invalid, must be between 10 and 1000."));
+    }
+    if (gArgs.IsArgSet("-assetindexguids")) {
+        const std::vector<std::string> &assetguidsStr = gArgs.GetArgs("-assetindexguids");
+        for(const std::string& guidStr: assetguidsStr){
+            uint32_t guid;
+            if(!ParseUInt32(guidStr, &guid))
+                return InitError(_("Could not parse Asset GUID"));
+            fAssetIndexGuids.push_back(guid);
+        }
+    }
+    if (fAssetIndex) {
+        // the index used to be written from ConnectBlock into its own database, it is rebuilt under indexes/
+        const fs::path legacy_assetindex_dir = GetDataDir() / "assetindex";
+        if (fs::exists(legacy_assetindex_dir)) {
+            LogPrintf("Removing obsolete asset index database %s\n", legacy_assetindex_dir.string());
+            fs::remove_all(legacy_assetindex_dir);
+        }
+        g_assetindex = MakeUnique<AssetIndex>(nAssetIndexCache, false, fReindex);
+        g_assetindex->Start();
+    }
+
     for (const auto& filter_type : g_enabled_filter_types) {
         InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
         GetBlockFilterIndex(filter_type)->Start();
@@ -1924,19 +1999,6 @@ bool AppInitMain(InitInterfaces& interfaces)
     fZMQNetworkStatus = gArgs.IsArgSet("-zmqpubnetworkstatus");
     fZMQWalletRawTx = gArgs.IsArgSet("-zmqpubwalletrawtx");
 
-    fAssetIndexPageSize = gArgs.GetArg("-assetindexpagesize", 25);
-    if(fAssetIndexPageSize < 10 || fAssetIndexPageSize > 1000){
-        return InitError(_("Asset index page size is invalid, must be between 10 and 1000."));
-    }
-    if (gArgs.IsArgSet("-assetindexguids")) {
-        const std::vector<std::string> &assetguidsStr = gArgs.GetArgs("-assetindexguids");
-        for(const std::string& guidStr: assetguidsStr){
-            uint32_t guid;
-            if(!ParseUInt32(guidStr, &guid))
-                return InitError(_("Could not parse Asset GUID"));
-            fAssetIndexGuids.push_back(guid);
-        }
-    }
      //lite mode disables all masternode functionality
     fLiteMode = gArgs.GetBoolArg("-litemode", false);
 
@@ -2002,6 +2064,34 @@ bool AppInitMain(InitInterfaces& interfaces)
         std::string strDBName;
 
 
+        strDBName = "mncache.dat";
+        uiInterface.InitMessage(_("Loading masternode cache..."));
+        CFlatDB<CMasternodeMan> flatdb1(strDBName, "magicMasternodeCache");
+        if(!flatdb1.Load(mnodeman)) {
+            return InitError(_("Failed to load masternode cache from") + "\n" + (pathDB / strDBName).string());
+        }
+        mnodeman.CheckLoadedState();
+
+        if(mnodeman.size()) {
+            strDBName = "mnpayments.dat";
+            uiInterface.InitMessage(_("Loading masternode payment cache..."));
+            CFlatDB<CMasternodePayments> flatdb2(strDBName, "magicMasternodePaymentsCache");
+            if(!flatdb2.Load(mnpayments)) {
+                return InitError(_("Failed to load masternode payments cache from") + "\n" + (pathDB / strDBName).string());
+            }
+            mnpayments.CheckLoadedState(WITH_LOCK(cs_main, return ::ChainActive().Height()));
+        } else {
+            uiInterface.InitMessage(_("Masternode cache is empty, skipping payments cache..."));
+        }
+
+        strDBName = "governance.dat";
+        uiInterface.InitMessage(_("Loading governance cache..."));
+        CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
+        if(!flatdb3.Load(governance)) {
+            return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / strDBName).string());
+        }
+        governance.InitOnLoad();
+
         strDBName = "netfulfilled.dat";
         uiInterface.InitMessage(_("Loading fulfilled requests cache..."));
         CFlatDB<CNetFulfilledRequestManager> flatdb4(strDBName, "magicFulfilledCache");
@@ -2027,6 +2117,7 @@ bool AppInitMain(InitInterfaces& interfaces)
 
         scheduler.scheduleEvery(boost::bind(&CMasternodePayments::DoMaintenance, boost::ref(mnpayments)), 60*1000);
         scheduler.scheduleEvery(boost::bind(&CGovernanceManager::DoMaintenance, boost::ref(governance), boost::ref(*g_connman)), 60 * 5*1000);
+        scheduler.scheduleEvery(DumpMasternodeCaches, DUMP_MASTERNODE_CACHES_INTERVAL * 1000);
     }
     // ********************************************************* Step 12: start node
 
@@ -2126,6 +2217,8 @@ bool AppInitMain(InitInterfaces& interfaces)
     scheduler.scheduleEvery([]{
         g_banman->DumpBanlist();
     }, DUMP_BANS_INTERVAL * 1000);
+    // PAYDAYCOIN
+    scheduler.scheduleEvery(ExpireAssetAllocationArrivalTimes, ZDAG_EXPIRY_INTERVAL_MILLIS);
 
     return true;
 }
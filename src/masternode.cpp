@@ -101,7 +101,7 @@ bool CMasternode::UpdateFromNewBroadcast(CMasternodeBroadcast& mnb, CConnman& co
 // the proof of work for that block. The further away they are the better, the furthest will win the election
 // and get paid this block
 //
-arith_uint256 CMasternode::CalculateScore(const uint256& blockHash) const
+arith_uint256 CMasternode::CalculateScore(const COutPoint& outpoint, const uint256& nCollateralMinConfBlockHash, const uint256& blockHash)
 {
     // Deterministically calculate a "score" for a Masternode based on any given (block)hash
     CHashWriter ss(SER_GETHASH, MIN_PEER_PROTO_VERSION);
@@ -9,6 +9,7 @@
 #include <clientversion.h>
 #include <interfaces/wallet.h>
 #include <key.h>
+#include <messagesigner.h>
 #include <net_processing.h>
 #include <spork.h>
 #include <validation.h>
@@ -73,6 +74,8 @@ public:
 
     bool Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode);
     bool CheckSignature(const CPubKey& pubKeyMasternode, int& nDos) const;
+    /// The signature CheckSignature verifies, for checking it ahead of time with CHashSigner::VerifyHashes
+    CHashSignature GetHashSignature(const CPubKey& pubKeyMasternode) const { return CHashSignature(GetSignatureHash(), pubKeyMasternode.GetID(), vchSig); }
     bool SimpleCheck(int& nDos);
     bool CheckAndUpdate(CMasternode* pmn, bool fFromNewBroadcast, int& nDos, CConnman& connman);
     void Relay(CConnman& connman);
@@ -204,7 +207,8 @@ public:
     }
 
     // CALCULATE A RANK AGAINST OF GIVEN BLOCK
-    arith_uint256 CalculateScore(const uint256& blockHash) const;
+    arith_uint256 CalculateScore(const uint256& blockHash) const { return CalculateScore(outpoint, nCollateralMinConfBlockHash, blockHash); }
+    static arith_uint256 CalculateScore(const COutPoint& outpoint, const uint256& nCollateralMinConfBlockHash, const uint256& blockHash);
 
     bool UpdateFromNewBroadcast(CMasternodeBroadcast& mnb, CConnman& connman);
 
@@ -351,6 +355,8 @@ public:
 
     bool Sign(const CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos) const;
+    /// The signature CheckSignature verifies, for checking it ahead of time with CHashSigner::VerifyHashes
+    CHashSignature GetHashSignature() const { return CHashSignature(GetSignatureHash(), pubKeyCollateralAddress.GetID(), vchSig); }
     void Relay(CConnman& connman) const;
 };
 
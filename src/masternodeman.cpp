@@ -26,15 +26,6 @@ CMasternodeMan mnodeman;
 const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan-Version-7";
 const int CMasternodeMan::LAST_PAID_SCAN_BLOCKS = 100;
 
-struct CompareLastPaidBlock
-{
-    bool operator()(const std::pair<int, const CMasternode*>& t1,
-                    const std::pair<int, const CMasternode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->outpoint < t2.second->outpoint);
-    }
-};
-
 struct CompareScoreMN
 {
     bool operator()(const std::pair<arith_uint256, const CMasternode*>& t1,
@@ -54,9 +45,58 @@ struct CompareByAddr
     }
 };
 
+CMasternodeStore::handle_t CMasternodeStore::Insert(const CMasternode& mn)
+{
+    handle_t h;
+    if (!vecFree.empty()) {
+        h = vecFree.back();
+        vecFree.pop_back();
+        vecSlots[h] = mn;
+        vecLive[h] = true;
+    } else {
+        h = vecSlots.size();
+        vecSlots.push_back(mn);
+        vecLive.push_back(true);
+        vecActiveState.push_back(0);
+        vecProtocolVersion.push_back(0);
+        vecLastPaidBlock.push_back(0);
+    }
+    mapHandles.emplace(mn.outpoint, h);
+    Refresh(h);
+    return h;
+}
+
+void CMasternodeStore::Erase(handle_t h)
+{
+    mapHandles.erase(vecSlots[h].outpoint);
+    // release what the masternode holds on to, the slot itself is kept for reuse
+    vecSlots[h] = CMasternode();
+    vecLive[h] = false;
+    vecFree.push_back(h);
+}
+
+void CMasternodeStore::Clear()
+{
+    vecSlots.clear();
+    vecFree.clear();
+    mapHandles.clear();
+    vecLive.clear();
+    vecActiveState.clear();
+    vecProtocolVersion.clear();
+    vecLastPaidBlock.clear();
+}
+
+void CMasternodeStore::Refresh(handle_t h)
+{
+    const CMasternode& mn = vecSlots[h];
+    vecActiveState[h] = mn.nActiveState;
+    vecProtocolVersion[h] = mn.nProtocolVersion;
+    vecLastPaidBlock[h] = mn.GetLastPaidBlock();
+}
+
 CMasternodeMan::CMasternodeMan():
     cs(),
-    mapMasternodes(),
+    storeMasternodes(),
     mAskedUsForMasternodeList(),
     mWeAskedForMasternodeList(),
     mWeAskedForMasternodeListEntry(),
@@ -78,7 +118,9 @@ bool CMasternodeMan::Add(CMasternode &mn)
     if (Has(mn.outpoint)) return false;
 
     LogPrint(BCLog::MN, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
-    mapMasternodes[mn.outpoint] = mn;
+    storeMasternodes.Insert(mn);
+    setLastPaid.emplace(mn.GetLastPaidBlock(), mn.outpoint);
+    InvalidateRankTables();
     fMasternodesAdded = true;
     return true;
 }
@@ -130,10 +172,11 @@ bool CMasternodeMan::PoSeBan(const COutPoint &outpoint)
 void CMasternodeMan::Check(bool fForce)
 {
     LOCK2(cs_main, cs);
-    for (auto& mnpair : mapMasternodes) {
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
         // NOTE: internally it checks only every MASTERNODE_CHECK_SECONDS seconds
         // since the last time, so expect some MNs to skip this
-        mnpair.second.Check(fForce);
+        it->Check(fForce);
+        storeMasternodes.Refresh(it.handle());
     }
 }
 
@@ -154,26 +197,29 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
         rank_pair_vec_t vecMasternodeRanks;
         // ask for up to MNB_RECOVERY_MAX_ASK_ENTRIES masternode entries at a time
         int nAskForMnbRecovery = MNB_RECOVERY_MAX_ASK_ENTRIES;
-        std::map<COutPoint, CMasternode>::iterator it = mapMasternodes.begin();
-        while (it != mapMasternodes.end()) {
-            CMasternodeBroadcast mnb = CMasternodeBroadcast(it->second);
+        auto it = storeMasternodes.begin();
+        while (it != storeMasternodes.end()) {
+            CMasternodeBroadcast mnb = CMasternodeBroadcast(*it);
             const uint256 &hash = mnb.GetHash();
             // If collateral was spent ...
-            if (it->second.IsOutpointSpent()) {
-                LogPrint(BCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing Masternode: %s  addr=%s  %i now\n", it->second.GetStateString(), it->second.addr.ToString(), size() - 1);
+            if (it->IsOutpointSpent()) {
+                LogPrint(BCLog::MN, "CMasternodeMan::CheckAndRemove -- Removing Masternode: %s  addr=%s  %i now\n", it->GetStateString(), it->addr.ToString(), size() - 1);
 
                 // erase all of the broadcasts we've seen from this txin, ...
                 mapSeenMasternodeBroadcast.erase(hash);
-                mWeAskedForMasternodeListEntry.erase(it->first);
+                mWeAskedForMasternodeListEntry.erase(it->outpoint);
 
                 // and finally remove it from the list
-                it->second.FlagGovernanceItemsAsDirty();
-                mapMasternodes.erase(it++);
+                it->FlagGovernanceItemsAsDirty();
+                setLastPaid.erase(std::make_pair(storeMasternodes.GetLastPaidBlock(it.handle()), it->outpoint));
+                storeMasternodes.Erase(it.handle());
+                ++it;
+                InvalidateRankTables();
                 fMasternodesRemoved = true;
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
                             masternodeSync.IsSynced() &&
-                            it->second.IsNewStartRequired() &&
+                            it->IsNewStartRequired() &&
                             !IsMnbRecoveryRequested(hash) &&
                             !gArgs.IsArgSet("-connect");
                 if(fAsk) {
@@ -188,7 +234,7 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                     // ask first MNB_RECOVERY_QUORUM_TOTAL masternodes we can connect to and we haven't asked recently
                     for(int i = 0; setRequested.size() < MNB_RECOVERY_QUORUM_TOTAL && i < (int)vecMasternodeRanks.size(); i++) {
                         // avoid banning
-                        if(mWeAskedForMasternodeListEntry.count(it->first) && mWeAskedForMasternodeListEntry[it->first].count(vecMasternodeRanks[i].second.addr)) continue;
+                        if(mWeAskedForMasternodeListEntry.count(it->outpoint) && mWeAskedForMasternodeListEntry[it->outpoint].count(vecMasternodeRanks[i].second.addr)) continue;
                         // didn't ask recently, ok to ask now
                         CService addr = vecMasternodeRanks[i].second.addr;
                         setRequested.insert(addr);
@@ -196,7 +242,7 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                         fAskedForMnbRecovery = true;
                     }
                     if(fAskedForMnbRecovery) {
-                        LogPrint(BCLog::MN, "CMasternodeMan::CheckAndRemove -- Recovery initiated, masternode=%s\n", it->first.ToStringShort());
+                        LogPrint(BCLog::MN, "CMasternodeMan::CheckAndRemove -- Recovery initiated, masternode=%s\n", it->outpoint.ToStringShort());
                         nAskForMnbRecovery--;
                     }
                     // wait for mnb recovery replies for MNB_RECOVERY_WAIT_SECONDS seconds
@@ -321,10 +367,50 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
     }
 }
 
+void CMasternodeMan::CheckLoadedState()
+{
+    LOCK2(cs_main, cs);
+
+    int nRemoved = 0;
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
+        Coin coin;
+        if (!GetUTXOCoin(it->outpoint, coin) || coin.IsSpent() || coin.IsCoinBase()) {
+            mapSeenMasternodeBroadcast.erase(CMasternodeBroadcast(*it).GetHash());
+            setLastPaid.erase(std::make_pair(storeMasternodes.GetLastPaidBlock(it.handle()), it->outpoint));
+            storeMasternodes.Erase(it.handle());
+            nRemoved++;
+        }
+    }
+    if (nRemoved > 0) {
+        InvalidateRankTables();
+        fMasternodesRemoved = true;
+    }
+    LogPrint(BCLog::MN, "CMasternodeMan::CheckLoadedState -- removed %d masternodes with spent collateral, %s\n", nRemoved, ToString());
+}
+
+void CMasternodeMan::RebuildLastPaidIndex()
+{
+    AssertLockHeld(cs);
+    setLastPaid.clear();
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
+        setLastPaid.emplace(storeMasternodes.GetLastPaidBlock(it.handle()), it->outpoint);
+    }
+}
+
+void CMasternodeMan::RefreshMasternode(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs);
+    CMasternodeStore::handle_t h = storeMasternodes.Find(outpoint);
+    if (h != CMasternodeStore::INVALID_HANDLE)
+        storeMasternodes.Refresh(h);
+}
+
 void CMasternodeMan::Clear()
 {
     LOCK(cs);
-    mapMasternodes.clear();
+    storeMasternodes.Clear();
+    setLastPaid.clear();
+    InvalidateRankTables();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -338,8 +424,8 @@ int CMasternodeMan::CountMasternodes(int nProtocolVersion)
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinMasternodePaymentsProto() : nProtocolVersion;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(mnpair.second.nProtocolVersion < nProtocolVersion) continue;
+    for (CMasternodeStore::handle_t h = 0; h < storeMasternodes.slots(); h++) {
+        if(!storeMasternodes.IsLive(h) || storeMasternodes.GetProtocolVersion(h) < nProtocolVersion) continue;
         nCount++;
     }
 
@@ -352,8 +438,9 @@ int CMasternodeMan::CountEnabled(int nProtocolVersion)
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinMasternodePaymentsProto() : nProtocolVersion;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(mnpair.second.nProtocolVersion < nProtocolVersion || !mnpair.second.IsEnabled()) continue;
+    for (CMasternodeStore::handle_t h = 0; h < storeMasternodes.slots(); h++) {
+        if(!storeMasternodes.IsLive(h) || storeMasternodes.GetProtocolVersion(h) < nProtocolVersion ||
+           storeMasternodes.GetActiveState(h) != MASTERNODE_ENABLED) continue;
         nCount++;
     }
 
@@ -366,10 +453,10 @@ int CMasternodeMan::CountByIP(int nNetworkType)
     LOCK(cs);
     int nNodeCount = 0;
 
-    for (const auto& mnpair : mapMasternodes)
-        if ((nNetworkType == NET_IPV4 && mnpair.second.addr.IsIPv4()) ||
-            (nNetworkType == NET_TOR  && mnpair.second.addr.IsTor())  ||
-            (nNetworkType == NET_IPV6 && mnpair.second.addr.IsIPv6())) {
+    for (const CMasternode& mn : storeMasternodes)
+        if ((nNetworkType == NET_IPV4 && mn.addr.IsIPv4()) ||
+            (nNetworkType == NET_TOR  && mn.addr.IsTor())  ||
+            (nNetworkType == NET_IPV6 && mn.addr.IsIPv6())) {
                 nNodeCount++;
         }
 
@@ -403,40 +490,40 @@ void CMasternodeMan::DsegUpdate(CNode* pnode, CConnman& connman)
 CMasternode* CMasternodeMan::Find(const COutPoint &outpoint)
 {
     LOCK(cs);
-    auto it = mapMasternodes.find(outpoint);
-    return it == mapMasternodes.end() ? NULL : &(it->second);
+    CMasternodeStore::handle_t h = storeMasternodes.Find(outpoint);
+    return h == CMasternodeStore::INVALID_HANDLE ? NULL : &storeMasternodes.Get(h);
 }
 
 bool CMasternodeMan::Get(const COutPoint& outpoint, CMasternode& masternodeRet)
 {
     // Theses mutexes are recursive so double locking by the same thread is safe.
     LOCK(cs);
-    auto it = mapMasternodes.find(outpoint);
-    if (it == mapMasternodes.end()) {
+    CMasternodeStore::handle_t h = storeMasternodes.Find(outpoint);
+    if (h == CMasternodeStore::INVALID_HANDLE) {
         return false;
     }
 
-    masternodeRet = it->second;
+    masternodeRet = storeMasternodes.Get(h);
     return true;
 }
 
 bool CMasternodeMan::GetMasternodeInfo(const COutPoint& outpoint, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    auto it = mapMasternodes.find(outpoint);
-    if (it == mapMasternodes.end()) {
+    CMasternodeStore::handle_t h = storeMasternodes.Find(outpoint);
+    if (h == CMasternodeStore::INVALID_HANDLE) {
         return false;
     }
-    mnInfoRet = it->second.GetInfo();
+    mnInfoRet = storeMasternodes.Get(h).GetInfo();
     return true;
 }
 
 bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnInfoRet = mnpair.second.GetInfo();
+    for (const CMasternode& mn : storeMasternodes) {
+        if (mn.pubKeyMasternode == pubKeyMasternode) {
+            mnInfoRet = mn.GetInfo();
             return true;
         }
     }
@@ -446,10 +533,10 @@ bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masterno
 bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        const CScript &scriptCollateralAddress = GetScriptForDestination(PKHash(mnpair.second.pubKeyCollateralAddress));
+    for (const CMasternode& mn : storeMasternodes) {
+        const CScript &scriptCollateralAddress = GetScriptForDestination(PKHash(mn.pubKeyCollateralAddress));
         if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
+            mnInfoRet = mn.GetInfo();
             return true;
         }
     }
@@ -459,7 +546,7 @@ bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t&
 bool CMasternodeMan::Has(const COutPoint& outpoint)
 {
     LOCK(cs);
-    return mapMasternodes.find(outpoint) != mapMasternodes.end();
+    return storeMasternodes.Find(outpoint) != CMasternodeStore::INVALID_HANDLE;
 }
 
 //
@@ -480,68 +567,96 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
         return false;
     }
 
-    // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
-    LOCK2(cs_main,cs);
+    // Taken before cs, GetBlockHash and GetUTXOConfirmations lock cs_main which must not be locked while holding cs
+    uint256 blockHash;
+    bool fHaveBlockHash = GetBlockHash(blockHash, nBlockHeight - 101);
 
-    std::vector<std::pair<int, const CMasternode*> > vecMasternodeLastPaid;
+    struct payee_candidate_t {
+        COutPoint outpoint;
+        uint256 nCollateralMinConfBlockHash;
+        bool fRecentSigTime;
+        int nConfirmations;
+    };
+    std::vector<payee_candidate_t> vecCandidates;
+    int nMnCount;
 
     /*
-        Make a vector with all of the last paid times
+        Walk the masternodes from the longest ago paid, the order used to pick the winner
     */
+    {
+        LOCK(cs);
+        nMnCount = CountMasternodes();
+        vecCandidates.reserve(setLastPaid.size());
+        for (const auto& lastpaid : setLastPaid) {
+            CMasternodeStore::handle_t h = storeMasternodes.Find(lastpaid.second);
+            if(storeMasternodes.GetActiveState(h) != MASTERNODE_ENABLED) continue;
 
-    int nMnCount = CountMasternodes();
+            //check protocol version
+            if(storeMasternodes.GetProtocolVersion(h) < mnpayments.GetMinMasternodePaymentsProto()) continue;
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(!mnpair.second.IsValidForPayment()) continue;
+            const CMasternode& mn = storeMasternodes.Get(h);
 
-        //check protocol version
-        if(mnpair.second.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
+            //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
+            if(mnpayments.IsScheduled(mn, nBlockHeight)) continue;
 
-        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if(mnpayments.IsScheduled(mnpair.second, nBlockHeight)) continue;
+            //it's too new, wait for a cycle
+            bool fRecentSigTime = mn.sigTime + (nMnCount*4*60) > GetAdjustedTime();
+
+            vecCandidates.push_back({mn.outpoint, mn.nCollateralMinConfBlockHash, fRecentSigTime, -1});
+        }
+    }
 
-        //it's too new, wait for a cycle
-        if(fFilterSigTime && mnpair.second.sigTime + (nMnCount*4*60) > GetAdjustedTime()) continue;
+    {
+        // look the collaterals up under one cs_main lock instead of locking it again for every candidate
+        LOCK(cs_main);
+        for (auto& candidate : vecCandidates)
+            candidate.nConfirmations = GetUTXOConfirmations(candidate.outpoint);
+    }
 
+    // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
+    //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
+    //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
+    //  -- (chance per block * chances before IsScheduled will fire)
+    // Both the queue with the too new masternodes filtered out and the one without are scored in the same pass,
+    // the unfiltered one is used when the network is in the process of upgrading.
+    int nTenthNetwork = std::max(1, nMnCount/10);
+    int nCountFiltered = 0;
+    int nCountAll = 0;
+    arith_uint256 nHighestFiltered = 0;
+    arith_uint256 nHighestAll = 0;
+    const COutPoint* pBestFiltered = nullptr;
+    const COutPoint* pBestAll = nullptr;
+    for (const auto& candidate : vecCandidates) {
         //make sure it has at least as many confirmations as there are masternodes
-        if(GetUTXOConfirmations(mnpair.first) < nMnCount) continue;
+        if(candidate.nConfirmations < nMnCount) continue;
 
-        vecMasternodeLastPaid.push_back(std::make_pair(mnpair.second.GetLastPaidBlock(), &mnpair.second));
-    }
+        nCountAll++;
+        if (!candidate.fRecentSigTime)
+            nCountFiltered++;
+        if (!fHaveBlockHash || (nCountAll > nTenthNetwork && nCountFiltered > nTenthNetwork)) continue;
 
-    nCountRet = (int)vecMasternodeLastPaid.size();
+        arith_uint256 nScore = CMasternode::CalculateScore(candidate.outpoint, candidate.nCollateralMinConfBlockHash, blockHash);
+        if (nCountAll <= nTenthNetwork && nScore > nHighestAll) {
+            nHighestAll = nScore;
+            pBestAll = &candidate.outpoint;
+        }
+        if (!candidate.fRecentSigTime && nCountFiltered <= nTenthNetwork && nScore > nHighestFiltered) {
+            nHighestFiltered = nScore;
+            pBestFiltered = &candidate.outpoint;
+        }
+    }
 
     //when the network is in the process of upgrading, don't penalize nodes that recently restarted
-    if(fFilterSigTime && nCountRet < nMnCount/3)
-        return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet);
-
-    // Sort them low to high
-    sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(), CompareLastPaidBlock());
+    bool fFiltered = fFilterSigTime && nCountFiltered >= nMnCount/3;
+    nCountRet = fFiltered ? nCountFiltered : nCountAll;
+    const COutPoint* pBestOutpoint = fFiltered ? pBestFiltered : pBestAll;
 
-    uint256 blockHash;
-    if(!GetBlockHash(blockHash, nBlockHeight - 101)) {
+    if (!fHaveBlockHash) {
         LogPrint(BCLog::MN, "CMasternode::GetNextMasternodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
         return false;
     }
-    // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
-    //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
-    //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
-    //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nMnCount/10;
-    int nCountTenth = 0;
-    arith_uint256 nHighest = 0;
-    const CMasternode *pBestMasternode = NULL;
-    for (const auto& s : vecMasternodeLastPaid) {
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
-        if(nScore > nHighest){
-            nHighest = nScore;
-            pBestMasternode = s.second;
-        }
-        nCountTenth++;
-        if(nCountTenth >= nTenthNetwork) break;
-    }
-    if (pBestMasternode) {
-        mnInfoRet = pBestMasternode->GetInfo();
+    if (pBestOutpoint) {
+        GetMasternodeInfo(*pBestOutpoint, mnInfoRet);
     }
     return mnInfoRet.fInfoValid;
 }
@@ -558,10 +673,13 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
     LogPrint(BCLog::MN, "CMasternodeMan::FindRandomNotInVec -- %d enabled masternodes, %d masternodes to choose from\n", nCountEnabled, nCountNotExcluded);
     if(nCountNotExcluded < 1) return masternode_info_t();
 
-    // fill a vector of pointers
+    // fill a vector of pointers to the enabled ones
     std::vector<const CMasternode*> vpMasternodesShuffled;
-    for (const auto& mnpair : mapMasternodes) {
-        vpMasternodesShuffled.push_back(&mnpair.second);
+    vpMasternodesShuffled.reserve(nCountEnabled);
+    for (CMasternodeStore::handle_t h = 0; h < storeMasternodes.slots(); h++) {
+        if(!storeMasternodes.IsLive(h) || storeMasternodes.GetProtocolVersion(h) < nProtocolVersion ||
+           storeMasternodes.GetActiveState(h) != MASTERNODE_ENABLED) continue;
+        vpMasternodesShuffled.push_back(&storeMasternodes.Get(h));
     }
 
     FastRandomContext insecure_rand;
@@ -571,7 +689,6 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
 
     // loop through
     for (const auto& pmn : vpMasternodesShuffled) {
-        if(pmn->nProtocolVersion < nProtocolVersion || !pmn->IsEnabled()) continue;
         fExclude = false;
         for (const auto& outpointToExclude : vecToExclude) {
             if(pmn->outpoint == outpointToExclude) {
@@ -589,6 +706,21 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
     return masternode_info_t();
 }
 
+void CMasternodeMan::ForEachMasternode(const std::function<void(const CMasternode&)>& func) const
+{
+    LOCK(cs);
+    // callers list masternodes by outpoint, sort handles rather than the masternodes themselves
+    std::vector<std::pair<COutPoint, CMasternodeStore::handle_t> > vecSorted;
+    vecSorted.reserve(storeMasternodes.size());
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
+        vecSorted.emplace_back(it->outpoint, it.handle());
+    }
+    std::sort(vecSorted.begin(), vecSorted.end());
+    for (const auto& entry : vecSorted) {
+        func(storeMasternodes.Get(entry.second));
+    }
+}
+
 bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeMan::score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol)
 {
     vecMasternodeScoresRet.clear();
@@ -598,13 +730,15 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
 
     AssertLockHeld(cs);
 
-    if (mapMasternodes.empty())
+    if (storeMasternodes.empty())
         return false;
 
     // calculate scores
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.nProtocolVersion >= nMinProtocol) {
-            vecMasternodeScoresRet.push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
+    vecMasternodeScoresRet.reserve(storeMasternodes.size());
+    for (CMasternodeStore::handle_t h = 0; h < storeMasternodes.slots(); h++) {
+        if (storeMasternodes.IsLive(h) && storeMasternodes.GetProtocolVersion(h) >= nMinProtocol) {
+            const CMasternode& mn = storeMasternodes.Get(h);
+            vecMasternodeScoresRet.push_back(std::make_pair(mn.CalculateScore(nBlockHash), &mn));
         }
     }
 
@@ -612,6 +746,37 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     return !vecMasternodeScoresRet.empty();
 }
 
+const CMasternodeMan::rank_table_t* CMasternodeMan::GetRankTable(const uint256& nBlockHash, int nMinProtocol)
+{
+    AssertLockHeld(cs);
+
+    for (auto it = listRankTables.begin(); it != listRankTables.end(); ++it) {
+        if (it->nBlockHash == nBlockHash && it->nMinProtocol == nMinProtocol) {
+            listRankTables.splice(listRankTables.begin(), listRankTables, it);
+            return &listRankTables.front();
+        }
+    }
+
+    score_pair_vec_t vecMasternodeScores;
+    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+        return nullptr;
+
+    rank_table_t ranks;
+    ranks.nBlockHash = nBlockHash;
+    ranks.nMinProtocol = nMinProtocol;
+    ranks.vecRanked.reserve(vecMasternodeScores.size());
+    ranks.mapRanks.reserve(vecMasternodeScores.size());
+    for (const auto& scorePair : vecMasternodeScores) {
+        ranks.vecRanked.push_back(scorePair.second);
+        ranks.mapRanks.emplace(scorePair.second->outpoint, ranks.vecRanked.size());
+    }
+
+    listRankTables.push_front(std::move(ranks));
+    if (listRankTables.size() > MAX_RANK_TABLES)
+        listRankTables.pop_back();
+    return &listRankTables.front();
+}
+
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -628,20 +793,16 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const rank_table_t* pRanks = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pRanks)
         return false;
 
-    int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores) {
-        nRank++;
-        if(scorePair.second->outpoint == outpoint) {
-            nRankRet = nRank;
-            return true;
-        }
-    }
+    auto it = pRanks->mapRanks.find(outpoint);
+    if (it == pRanks->mapRanks.end())
+        return false;
 
-    return false;
+    nRankRet = it->second;
+    return true;
 }
 
 bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight, int nMinProtocol)
@@ -660,14 +821,15 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    const rank_table_t* pRanks = GetRankTable(nBlockHash, nMinProtocol);
+    if (!pRanks)
         return false;
 
+    vecMasternodeRanksRet.reserve(pRanks->vecRanked.size());
     int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores) {
+    for (const CMasternode* pmn : pRanks->vecRanked) {
         nRank++;
-        vecMasternodeRanksRet.push_back(std::make_pair(nRank, *scorePair.second));
+        vecMasternodeRanksRet.push_back(std::make_pair(nRank, *pmn));
     }
 
     return true;
@@ -818,7 +980,9 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         if(pmn && pmn->IsNewStartRequired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        bool fUpdated = mnp.CheckAndUpdate(pmn, false, nDos, connman);
+        if(pmn) RefreshMasternode(mnp.masternodeOutpoint);
+        if(fUpdated) return;
 
         if(nDos > 0) {
             // if anything significant failed, mark that node
@@ -884,13 +1048,13 @@ void CMasternodeMan::SyncSingle(CNode* pnode, const COutPoint& outpoint, CConnma
 
     LOCK(cs);
 
-    auto it = mapMasternodes.find(outpoint);
+    CMasternode* pmn = Find(outpoint);
 
-    if(it !=  mapMasternodes.end()) {
-        if (it->second.addr.IsRFC1918() || it->second.addr.IsLocal()) return; // do not send local network masternode
+    if(pmn) {
+        if (pmn->addr.IsRFC1918() || pmn->addr.IsLocal()) return; // do not send local network masternode
         // NOTE: send masternode regardless of its current state, the other node will need it to verify old votes.
-        LogPrint(BCLog::MN, "CMasternodeMan::%s -- Sending Masternode entry: masternode=%s  addr=%s\n", __func__, outpoint.ToStringShort(), it->second.addr.ToString());
-        PushDsegInvs(pnode, it->second);
+        LogPrint(BCLog::MN, "CMasternodeMan::%s -- Sending Masternode entry: masternode=%s  addr=%s\n", __func__, outpoint.ToStringShort(), pmn->addr.ToString());
+        PushDsegInvs(pnode, *pmn);
         LogPrint(BCLog::MN, "CMasternodeMan::%s -- Sent 1 Masternode inv to peer=%d\n", __func__, pnode->GetId());
     }
 }
@@ -920,11 +1084,11 @@ void CMasternodeMan::SyncAll(CNode* pnode, CConnman& connman)
     int nInvCount = 0;
 
 
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.addr.IsRFC1918() || mnpair.second.addr.IsLocal()) continue; // do not send local network masternode
+    for (const CMasternode& mn : storeMasternodes) {
+        if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) continue; // do not send local network masternode
         // NOTE: send masternode regardless of its current state, the other node will need it to verify old votes.
-        LogPrint(BCLog::MN, "CMasternodeMan::%s -- Sending Masternode entry: masternode=%s  addr=%s\n", __func__, mnpair.first.ToStringShort(), mnpair.second.addr.ToString());
-        PushDsegInvs(pnode, mnpair.second);
+        LogPrint(BCLog::MN, "CMasternodeMan::%s -- Sending Masternode entry: masternode=%s  addr=%s\n", __func__, mn.outpoint.ToStringShort(), mn.addr.ToString());
+        PushDsegInvs(pnode, mn);
         nInvCount++;
     }
 
@@ -1025,7 +1189,7 @@ void CMasternodeMan::DoFullVerificationStep(CConnman& connman)
 
 void CMasternodeMan::CheckSameAddr()
 {
-    if(!masternodeSync.IsSynced() || mapMasternodes.empty()) return;
+    if(!masternodeSync.IsSynced() || storeMasternodes.empty()) return;
 
     std::vector<CMasternode*> vBan;
     std::vector<CMasternode*> vSortedByAddr;
@@ -1036,15 +1200,17 @@ void CMasternodeMan::CheckSameAddr()
         CMasternode* pprevMasternode = NULL;
         CMasternode* pverifiedMasternode = NULL;
 
-        for (auto& mnpair : mapMasternodes) {
-            vSortedByAddr.push_back(&mnpair.second);
+        // check only (pre)enabled masternodes
+        for (CMasternodeStore::handle_t h = 0; h < storeMasternodes.slots(); h++) {
+            if(!storeMasternodes.IsLive(h)) continue;
+            int nActiveState = storeMasternodes.GetActiveState(h);
+            if(nActiveState != MASTERNODE_ENABLED && nActiveState != MASTERNODE_PRE_ENABLED) continue;
+            vSortedByAddr.push_back(&storeMasternodes.Get(h));
         }
 
         sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
 
         for (const auto& pmn : vSortedByAddr) {
-            // check only (pre)enabled masternodes
-            if(!pmn->IsEnabled() && !pmn->IsPreEnabled()) continue;
             // initial step
             if(!pprevMasternode) {
                 pprevMasternode = pmn;
@@ -1226,26 +1392,26 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         uint256 hash1 = mnv.GetSignatureHash1(blockHash);
       
 
-        for (auto& mnpair : mapMasternodes) {
-            if(CAddress(mnpair.second.addr, NODE_NETWORK) == pnode->addr) {
+        for (CMasternode& mn : storeMasternodes) {
+            if(CAddress(mn.addr, NODE_NETWORK) == pnode->addr) {
                 bool fFound = false;
                 if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
-                    fFound = CHashSigner::VerifyHash(hash1, mnpair.second.pubKeyMasternode, mnv.vchSig1, strError);
+                    fFound = CHashSigner::VerifyHash(hash1, mn.pubKeyMasternode, mnv.vchSig1, strError);
                     // we don't care about mnv with signature in old format
                 } 
                 if (fFound) {
                     // found it!
-                    prealMasternode = &mnpair.second;
-                    if(!mnpair.second.IsPoSeVerified()) {
-                        mnpair.second.DecreasePoSeBanScore();
+                    prealMasternode = &mn;
+                    if(!mn.IsPoSeVerified()) {
+                        mn.DecreasePoSeBanScore();
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
 
                     // we can only broadcast it if we are an activated masternode
                     if(activeMasternode.outpoint.IsNull()) continue;
                     // update ...
-                    mnv.addr = mnpair.second.addr;
-                    mnv.masternodeOutpoint1 = mnpair.second.outpoint;
+                    mnv.addr = mn.addr;
+                    mnv.masternodeOutpoint1 = mn.outpoint;
                     mnv.masternodeOutpoint2 = activeMasternode.outpoint;
                     // ... and sign it
                     std::string strError;
@@ -1269,7 +1435,7 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
                     mnv.Relay();
 
                 } else {
-                    vpMasternodesToBan.push_back(&mnpair.second);
+                    vpMasternodesToBan.push_back(&mn);
                 }
             }
         }
@@ -1390,12 +1556,12 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
 
         // increase ban score for everyone else with the same addr
         int nCount = 0;
-        for (auto& mnpair : mapMasternodes) {
-            if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.masternodeOutpoint1) continue;
-            mnpair.second.IncreasePoSeBanScore();
+        for (CMasternode& mn : storeMasternodes) {
+            if(mn.addr != mnv.addr || mn.outpoint == mnv.masternodeOutpoint1) continue;
+            mn.IncreasePoSeBanScore();
             nCount++;
             LogPrint(BCLog::MN, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
-                        mnpair.first.ToStringShort(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
+                        mn.outpoint.ToStringShort(), mn.addr.ToString(), mn.nPoSeBanScore);
         }
         if(nCount)
             LogPrint(BCLog::MN, "CMasternodeMan::ProcessVerifyBroadcast -- PoSe score increased for %d fake masternodes, addr %s\n",
@@ -1407,7 +1573,7 @@ std::string CMasternodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Masternodes: " << (int)mapMasternodes.size() <<
+    info << "Masternodes: " << (int)storeMasternodes.size() <<
             ", peers who asked us for Masternode list: " << (int)mAskedUsForMasternodeList.size() <<
             ", peers we asked for Masternode list: " << (int)mWeAskedForMasternodeList.size() <<
             ", entries in Masternode list we asked for: " << (int)mWeAskedForMasternodeListEntry.size();
@@ -1469,7 +1635,11 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.outpoint);
         if(pmn) {
             const CMasternodeBroadcast &mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if(!mnb.Update(pmn, nDos, connman)) {
+            // the protocol version may change even if the update fails half way
+            const bool fUpdated = mnb.Update(pmn, nDos, connman);
+            InvalidateRankTables();
+            RefreshMasternode(mnb.outpoint);
+            if(!fUpdated) {
                 LogPrint(BCLog::MN, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.outpoint.ToStringShort());
                 return false;
             }
@@ -1511,7 +1681,7 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
 {
     LOCK2(cs_main, cs);
 
-    if(fLiteMode || !masternodeSync.IsWinnersListSynced() || mapMasternodes.empty()) return;
+    if(fLiteMode || !masternodeSync.IsWinnersListSynced() || storeMasternodes.empty()) return;
 
     static int nLastRunBlockHeight = 0;
     // Scan at least LAST_PAID_SCAN_BLOCKS but no more than mnpayments.GetStorageLimit()
@@ -1521,8 +1691,13 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
     LogPrint(BCLog::MN, "CMasternodeMan::UpdateLastPaid -- nCachedBlockHeight=%d, nLastRunBlockHeight=%d, nMaxBlocksToScanBack=%d\n",
                             nCachedBlockHeight, nLastRunBlockHeight, nMaxBlocksToScanBack);
 
-    for (auto& mnpair : mapMasternodes) {
-        mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
+        it->UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        if (it->GetLastPaidBlock() != storeMasternodes.GetLastPaidBlock(it.handle())) {
+            setLastPaid.erase(std::make_pair(storeMasternodes.GetLastPaidBlock(it.handle()), it->outpoint));
+            setLastPaid.emplace(it->GetLastPaidBlock(), it->outpoint);
+            storeMasternodes.Refresh(it.handle());
+        }
     }
 
     nLastRunBlockHeight = nCachedBlockHeight;
@@ -1556,17 +1731,18 @@ bool CMasternodeMan::AddGovernanceVote(const COutPoint& outpoint, uint256 nGover
 void CMasternodeMan::RemoveGovernanceObject(uint256 nGovernanceObjectHash)
 {
     LOCK(cs);
-    for(auto& mnpair : mapMasternodes) {
-        mnpair.second.RemoveGovernanceObject(nGovernanceObjectHash);
+    for (CMasternode& mn : storeMasternodes) {
+        mn.RemoveGovernanceObject(nGovernanceObjectHash);
     }
 }
 
 void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForce)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnpair.second.Check(fForce);
+    for (auto it = storeMasternodes.begin(); it != storeMasternodes.end(); ++it) {
+        if (it->pubKeyMasternode == pubKeyMasternode) {
+            it->Check(fForce);
+            storeMasternodes.Refresh(it.handle());
             return;
         }
     }
@@ -1631,8 +1807,8 @@ void CMasternodeMan::WarnMasternodeDaemonUpdates()
 
     int nUpdatedMasternodes{0};
 
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.lastPing.nDaemonVersion > CLIENT_MASTERNODE_VERSION) {
+    for (const CMasternode& mn : storeMasternodes) {
+        if (mn.lastPing.nDaemonVersion > CLIENT_MASTERNODE_VERSION) {
             ++nUpdatedMasternodes;
         }
     }
@@ -9,11 +9,119 @@
 #include <masternode.h>
 #include <sync.h>
 
+#include <deque>
+#include <functional>
+#include <limits>
+#include <list>
+#include <set>
+#include <unordered_map>
+
 class CMasternodeMan;
 class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+/**
+ * Flat storage of the masternode list.
+ * Every masternode lives in a slot whose handle and address stay the same until it is erased, freed slots
+ * are reused. The fields the periodic full scans filter on are mirrored per slot in parallel arrays so those
+ * scans don't have to walk the masternode objects, Refresh() has to be called after changing a masternode.
+ */
+class CMasternodeStore
+{
+public:
+    typedef uint32_t handle_t;
+    static const handle_t INVALID_HANDLE = std::numeric_limits<handle_t>::max();
+
+    template <typename Store, typename Value>
+    class iterator_base
+    {
+    private:
+        Store* pstore;
+        handle_t h;
+
+        void SkipFree() { while (h < pstore->slots() && !pstore->IsLive(h)) h++; }
+
+    public:
+        iterator_base(Store* pstoreIn, handle_t hIn) : pstore(pstoreIn), h(hIn) { SkipFree(); }
+        handle_t handle() const { return h; }
+        Value& operator*() const { return pstore->Get(h); }
+        Value* operator->() const { return &pstore->Get(h); }
+        iterator_base& operator++() { h++; SkipFree(); return *this; }
+        bool operator!=(const iterator_base& other) const { return h != other.h; }
+    };
+    typedef iterator_base<CMasternodeStore, CMasternode> iterator;
+    typedef iterator_base<const CMasternodeStore, const CMasternode> const_iterator;
+
+private:
+    std::deque<CMasternode> vecSlots;
+    std::vector<handle_t> vecFree;
+    std::unordered_map<COutPoint, handle_t, SaltedOutpointHasher> mapHandles;
+
+    // mirrored fields, indexed by handle
+    std::vector<bool> vecLive;
+    std::vector<int> vecActiveState;
+    std::vector<int> vecProtocolVersion;
+    std::vector<int> vecLastPaidBlock;
+
+public:
+    size_t size() const { return mapHandles.size(); }
+    bool empty() const { return mapHandles.empty(); }
+    /// One past the highest handle ever used
+    handle_t slots() const { return vecSlots.size(); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, slots()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slots()); }
+
+    handle_t Find(const COutPoint& outpoint) const
+    {
+        auto it = mapHandles.find(outpoint);
+        return it == mapHandles.end() ? INVALID_HANDLE : it->second;
+    }
+    bool IsLive(handle_t h) const { return vecLive[h]; }
+    CMasternode& Get(handle_t h) { return vecSlots[h]; }
+    const CMasternode& Get(handle_t h) const { return vecSlots[h]; }
+
+    int GetActiveState(handle_t h) const { return vecActiveState[h]; }
+    int GetProtocolVersion(handle_t h) const { return vecProtocolVersion[h]; }
+    int GetLastPaidBlock(handle_t h) const { return vecLastPaidBlock[h]; }
+
+    /// Add a masternode, there must be none with the same outpoint yet
+    handle_t Insert(const CMasternode& mn);
+    void Erase(handle_t h);
+    void Clear();
+    /// Update the mirrored fields from the masternode in slot h
+    void Refresh(handle_t h);
+
+    // same format as the std::map the list used to be kept in
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        WriteCompactSize(s, size());
+        for (const CMasternode& mn : *this) {
+            s << mn.outpoint;
+            s << mn;
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        Clear();
+        uint64_t nSize = ReadCompactSize(s);
+        for (uint64_t i = 0; i < nSize; i++) {
+            COutPoint outpoint;
+            CMasternode mn;
+            s >> outpoint;
+            s >> mn;
+            if (Find(outpoint) == INVALID_HANDLE)
+                Insert(mn);
+        }
+    }
+};
+
 class CMasternodeMan
 {
 public:
@@ -40,6 +148,19 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    // enough for the blocks payment votes are accepted for around the tip
+    static const size_t MAX_RANK_TABLES             = 16;
+
+    /// Masternode ranking for one block hash and minimum protocol version
+    struct rank_table_t
+    {
+        uint256 nBlockHash;
+        int nMinProtocol;
+        /// Masternodes by descending score, these point into storeMasternodes
+        std::vector<const CMasternode*> vecRanked;
+        /// Rank (starting at 1) of every masternode in vecRanked
+        std::unordered_map<COutPoint, int, SaltedOutpointHasher> mapRanks;
+    };
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -47,8 +168,8 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
-    // map to hold all MNs
-    std::map<COutPoint, CMasternode> mapMasternodes;
+    // all MNs
+    CMasternodeStore storeMasternodes;
     // who's asked for the Masternode list and the last time
     std::map<CService, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -74,12 +195,26 @@ private:
     bool fMasternodesRemoved;
 
     std::vector<uint256> vecDirtyGovernanceObjectHashes;
+
+    /// Recently used rank tables, most recent first.
+    /// Must be invalidated whenever a masternode is added or removed or its score inputs change.
+    std::list<rank_table_t> listRankTables;
+
+    /// Payment queue order, masternodes by last paid block and then outpoint.
+    /// Kept in step with storeMasternodes and UpdateLastPaid so the oldest paid can be read off the front.
+    std::set<std::pair<int, COutPoint> > setLastPaid;
     
     int64_t nLastSentinelPingTime;
 
     friend class CMasternodeSync;
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    /// Cached ranking for nBlockHash, computed on first use. Returns nullptr if there is nothing to rank.
+    const rank_table_t* GetRankTable(const uint256& nBlockHash, int nMinProtocol);
+    void InvalidateRankTables() { AssertLockHeld(cs); listRankTables.clear(); }
+    void RebuildLastPaidIndex();
+    /// Update the mirrored fields of a masternode after changing it
+    void RefreshMasternode(const COutPoint& outpoint);
 
     void SyncSingle(CNode* pnode, const COutPoint& outpoint, CConnman& connman);
     void SyncAll(CNode* pnode, CConnman& connman);
@@ -109,7 +244,7 @@ public:
             READWRITE(strVersion);
         }
 
-        READWRITE(mapMasternodes);
+        READWRITE(storeMasternodes);
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -119,6 +254,10 @@ public:
 
         READWRITE(mapSeenMasternodeBroadcast);
         READWRITE(mapSeenMasternodePing);
+        if(ser_action.ForRead()) {
+            listRankTables.clear();
+            RebuildLastPaidIndex();
+        }
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
@@ -144,6 +283,8 @@ public:
     void CheckAndRemove(CConnman& connman);
     /// This is dummy overload to be used for dumping/loading mncache.dat
     void CheckAndRemove() {}
+    /// Remove loaded masternodes whose collateral is not unspent at the current tip
+    void CheckLoadedState();
 
     /// Clear Masternode vector
     void Clear();
@@ -176,7 +317,8 @@ public:
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
-    std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    /// Call func on every masternode in outpoint order while holding cs, a snapshot read without copying the list
+    void ForEachMasternode(const std::function<void(const CMasternode&)>& func) const;
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
@@ -197,13 +339,15 @@ public:
     void ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerification& mnv);
 
     /// Return the number of (unique) Masternodes
-    int size() { return mapMasternodes.size(); }
+    int size() { return storeMasternodes.size(); }
 
     std::string ToString() const;
 
     /// Perform complete check and only then update masternode list and maps using provided CMasternodeBroadcast
     bool CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBroadcast mnb, int& nDos, CConnman& connman);
     bool IsMnbRecoveryRequested(const uint256& hash) { return mMnbRecoveryRequests.count(hash); }
+    bool HasSeenMasternodeBroadcast(const uint256& hash) { LOCK(cs); return mapSeenMasternodeBroadcast.count(hash); }
+    bool HasSeenMasternodePing(const uint256& hash) { LOCK(cs); return mapSeenMasternodePing.count(hash); }
 
     void UpdateLastPaid(const CBlockIndex* pindex);
 
@@ -25,6 +25,8 @@ CCriticalSection cs_vecPayees;
 CCriticalSection cs_mapMasternodeBlocks;
 CCriticalSection cs_mapMasternodePaymentVotes;
 
+const std::string CMasternodePayments::SERIALIZATION_VERSION_STRING = "CMasternodePayments-Version-1";
+
 /**
 * IsBlockValueValid
 *
@@ -202,6 +204,33 @@ void CMasternodePayments::Clear()
     mapMasternodePaymentVotes.clear();
 }
 
+void CMasternodePayments::CheckLoadedState(int nTipHeight)
+{
+    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+
+    // same window MASTERNODEPAYMENTVOTE accepts votes for
+    const int nFirstBlock = nTipHeight - GetStorageLimit();
+    const int nLastBlock = nTipHeight + 20;
+
+    auto itVote = mapMasternodePaymentVotes.begin();
+    while (itVote != mapMasternodePaymentVotes.end()) {
+        if (itVote->second.nBlockHeight < nFirstBlock || itVote->second.nBlockHeight > nLastBlock) {
+            mapMasternodePaymentVotes.erase(itVote++);
+        } else {
+            ++itVote;
+        }
+    }
+    auto itBlock = mapMasternodeBlocks.begin();
+    while (itBlock != mapMasternodeBlocks.end()) {
+        if (itBlock->first < nFirstBlock || itBlock->first > nLastBlock) {
+            mapMasternodeBlocks.erase(itBlock++);
+        } else {
+            ++itBlock;
+        }
+    }
+    LogPrint(BCLog::MNPAYMENT, "CMasternodePayments::CheckLoadedState -- nTipHeight=%d, %s\n", nTipHeight, ToString());
+}
+
 bool CMasternodePayments::UpdateLastVote(const CMasternodePaymentVote& vote)
 {
     LOCK(cs_mapMasternodePaymentVotes);
@@ -27,6 +27,7 @@ static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_2 = MIN_PEER_PROTO_VERSION
 
 extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapMasternodeBlocks;
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 extern CCriticalSection cs_mapMasternodePayeeVotes;
 
 extern CMasternodePayments mnpayments;
@@ -155,6 +156,8 @@ public:
 
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeyMasternode, int nValidationHeight, int &nDos) const;
+    /// The signature CheckSignature verifies, for checking it ahead of time with CHashSigner::VerifyHashes
+    CHashSignature GetHashSignature(const CPubKey& pubKeyMasternode) const { return CHashSignature(GetSignatureHash(), pubKeyMasternode.GetID(), vchSig); }
 
     bool IsValid(CNode* pnode, int nValidationHeight, std::string& strError, CConnman& connman) const;
     void Relay(CConnman& connman) const;
@@ -173,6 +176,8 @@ public:
 class CMasternodePayments
 {
 private:
+    static const std::string SERIALIZATION_VERSION_STRING;
+
     // masternode count times nStorageCoeff payments blocks should be stored ...
     const float nStorageCoeff;
     // ... but at least nMinBlocksToStore (payments blocks)
@@ -193,11 +198,26 @@ public:
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
+        LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+        std::string strVersion;
+        if(ser_action.ForRead()) {
+            READWRITE(strVersion);
+        }
+        else {
+            strVersion = SERIALIZATION_VERSION_STRING;
+            READWRITE(strVersion);
+        }
+
         READWRITE(mapMasternodePaymentVotes);
         READWRITE(mapMasternodeBlocks);
+        if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
+            Clear();
+        }
     }
 
     void Clear();
+    /// Drop loaded votes that are outside the window accepted around nTipHeight
+    void CheckLoadedState(int nTipHeight);
 
     bool AddOrUpdatePaymentVote(const CMasternodePaymentVote& vote, CConnman& connman);
     bool HasVerifiedPaymentVote(const uint256& hashIn) const;
@@ -10,6 +10,105 @@
 #include <tinyformat.h>
 #include <util/strencodings.h>
 #include <key_io.h>
+#include <checkqueue.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
+#include <logging.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <util/threadnames.h>
+
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ * Valid hash signatures that were verified ahead of the message carrying them, so the serial message
+ * handler only has to look them up.
+ */
+class CHashSignerCache
+{
+private:
+    //! Entries are SHA256(nonce || hash || key id || signature)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_sigcache;
+
+public:
+    CHashSignerCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(keyID.begin(), keyID.size()).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        setValid.insert(entry);
+    }
+    uint32_t setup_bytes(size_t n)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        // resizing keeps the old entries around, a new nonce makes sure none of them match anymore
+        GetRandBytes(nonce.begin(), 32);
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CHashSignerCache hashSignerCache;
+
+/**
+ * Closure verifying one CHashSignature. Results are recorded in the cache instead of failing the
+ * whole batch, a bad signature only affects its own message.
+ */
+class CHashSignerCheck
+{
+private:
+    const CHashSignature* psig;
+    uint256 entry;
+
+public:
+    CHashSignerCheck(): psig(nullptr) {}
+    CHashSignerCheck(const CHashSignature* psigIn, const uint256& entryIn): psig(psigIn), entry(entryIn) {}
+
+    bool operator()() {
+        CPubKey pubkeyFromSig;
+        if (pubkeyFromSig.RecoverCompact(psig->hash, psig->vchSig) && pubkeyFromSig.GetID() == psig->keyID)
+            hashSignerCache.Set(entry);
+        return true;
+    }
+
+    void swap(CHashSignerCheck& check) {
+        std::swap(psig, check.psig);
+        std::swap(entry, check.entry);
+    }
+};
+static CCheckQueue<CHashSignerCheck> hashsignercheckqueue(16);
+} // namespace
+
+void InitHashSignerCache()
+{
+    size_t nElems = hashSignerCache.setup_bytes(DEFAULT_HASH_SIGNER_CACHE_SIZE << 20);
+    LogPrintf("Using %zu MiB for hash signature cache, able to store %zu elements\n",
+        (nElems * sizeof(uint256)) >> 20, nElems);
+}
+
+void ThreadHashSignerCheck(int worker_num)
+{
+    util::ThreadRename(strprintf("hashsigch.%i", worker_num));
+    hashsignercheckqueue.Thread();
+}
+
 bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     keyRet = DecodeSecret(strSecret);
@@ -52,6 +151,11 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey& pubkey, const s
 
 bool CHashSigner::VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
+    uint256 entry;
+    hashSignerCache.ComputeEntry(entry, hash, keyID, vchSig);
+    if (hashSignerCache.Get(entry))
+        return true;
+
     CPubKey pubkeyFromSig;
     if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
         strErrorRet = "Error recovering public key.";
@@ -67,3 +171,21 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CKeyID& keyID, const std
 
     return true;
 }
+
+void CHashSigner::VerifyHashes(const std::vector<CHashSignature>& vecSigs)
+{
+    std::vector<CHashSignerCheck> vChecks;
+    vChecks.reserve(vecSigs.size());
+    for (const CHashSignature& sig : vecSigs) {
+        // signatures verified by an earlier batch are not queued again
+        uint256 entry;
+        hashSignerCache.ComputeEntry(entry, sig.hash, sig.keyID, sig.vchSig);
+        if (!hashSignerCache.Get(entry))
+            vChecks.emplace_back(&sig, entry);
+    }
+    if (vChecks.empty())
+        return;
+    CCheckQueueControl<CHashSignerCheck> control(&hashsignercheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
@@ -8,6 +8,11 @@
 
 #include <key.h>
 
+#include <vector>
+
+/** Size in MiB of the cache of hash signatures verified ahead of their message */
+static const unsigned int DEFAULT_HASH_SIGNER_CACHE_SIZE = 1;
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
@@ -23,6 +28,17 @@ public:
     static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
 };
 
+/** A signature over a hash by a known public key, verified later by CHashSigner::VerifyHash
+ */
+struct CHashSignature
+{
+    uint256 hash;
+    CKeyID keyID;
+    std::vector<unsigned char> vchSig;
+
+    CHashSignature(const uint256& hashIn, const CKeyID& keyIDIn, const std::vector<unsigned char>& vchSigIn) : hash(hashIn), keyID(keyIDIn), vchSig(vchSigIn) {}
+};
+
 /** Helper class for signing hashes and checking their signatures
  */
 class CHashSigner
@@ -34,6 +50,14 @@ public:
     static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
     /// Verify the hash signature, returns true if succcessful
     static bool VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    /// Verify a batch of hash signatures in parallel on the hash signer check workers.
+    /// Valid ones are remembered so that VerifyHash of the same signature returns without recovering the key again.
+    static void VerifyHashes(const std::vector<CHashSignature>& vecSigs);
 };
 
+/** Initializes the cache of verified hash signatures, called once at startup */
+void InitHashSignerCache();
+/** Run instances of this in the background to verify batches of hash signatures */
+void ThreadHashSignerCheck(int worker_num);
+
 #endif // PAYDAYCOIN_MESSAGESIGNER_H
@@ -108,6 +108,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->vtx.emplace_back();
     pblocktemplate->vTxFees.push_back(-1); // updated at end
     pblocktemplate->vTxSigOpsCost.push_back(-1); // updated at end
+    pblocktemplate->vTxZDAGArrivalTimes.push_back(std::numeric_limits<int64_t>::max());
 
     LOCK2(cs_main, mempool.cs);
     CBlockIndex* pindexPrev = ::ChainActive().Tip();
@@ -183,10 +184,15 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     FillBlockPayments(coinbaseTx, nHeight, blockReward, nFees, pblocktemplate->txoutMasternode, pblocktemplate->voutSuperblock);
 
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
-    if (!OrderBasedOnArrivalTime(pblock->vtx))
+    std::vector<unsigned int> vecArrivalOrder;
+    if (!OrderBasedOnArrivalTime(pblock->vtx, pblocktemplate->vTxZDAGArrivalTimes, vecArrivalOrder))
     {
         throw std::runtime_error("OrderBasedOnArrivalTime failed!");
     }
+    // the template vectors run parallel to the block transactions
+    ApplyArrivalTimeOrder(vecArrivalOrder, pblocktemplate->vTxZDAGArrivalTimes);
+    ApplyArrivalTimeOrder(vecArrivalOrder, pblocktemplate->vTxFees);
+    ApplyArrivalTimeOrder(vecArrivalOrder, pblocktemplate->vTxSigOpsCost);
     pblocktemplate->vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
     pblocktemplate->vTxFees[0] = -nFees;
     // PAYDAYCOIN remove bad burn transactions prior to accepting block                      
@@ -197,7 +203,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     bool bOverflow = false;
     CheckPaydayCoinInputs(false, *pblock->vtx[0], stateInputs, viewOld, false, bOverflow, nHeight, *pblock, false, true, txsToRemove);
     if(bOverflow)
-        ResyncAssetAllocationStates();
+        RequestAssetAllocationResync();
 
     if(!txsToRemove.empty()){
         LogPrint(BCLog::PDAY, "CreateNewBlock: CheckPaydayCoinInputs failed removed %d transactions and trying again...\n", txsToRemove.size());
@@ -269,6 +275,8 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     pblock->vtx.emplace_back(iter->GetSharedTx());
     pblocktemplate->vTxFees.push_back(iter->GetFee());
     pblocktemplate->vTxSigOpsCost.push_back(iter->GetSigOpCost());
+    // PAYDAYCOIN
+    pblocktemplate->vTxZDAGArrivalTimes.push_back(iter->GetZDAGArrivalTime());
     nBlockWeight += iter->GetTxWeight();
     ++nBlockTx;
     nBlockSigOpsCost += iter->GetSigOpCost();
@@ -34,6 +34,7 @@ struct CBlockTemplate
     // PAYDAYCOIN
     CTxOut txoutMasternode; // masternode payment
     std::vector<CTxOut> voutSuperblock; // superblock payment
+    std::vector<int64_t> vTxZDAGArrivalTimes; // cached ZDAG arrival time of each tx, used to order the block
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
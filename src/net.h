@@ -720,6 +720,8 @@ public:
     CCriticalSection cs_vProcessMsg;
     std::list<CNetMessage> vProcessMsg GUARDED_BY(cs_vProcessMsg);
     size_t nProcessQueueSize{0};
+    // PAYDAYCOIN Number of messages at the front of vProcessMsg whose masternode signatures were already checked in a batch
+    int nPreverifiedSigMsgs GUARDED_BY(cs_vProcessMsg){0};
 
     CCriticalSection cs_sendProcessing;
 
@@ -3437,6 +3437,72 @@ bool PeerLogicValidation::SendRejectsAndCheckIfBanned(CNode* pnode, bool enable_
     return false;
 }
 
+// PAYDAYCOIN
+/** How many queued messages of a peer are looked at when batching masternode signature checks */
+static const int MAX_PREVERIFY_SIG_MSGS = 64;
+
+static bool IsMasternodeSigCommand(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::MNANNOUNCE || strCommand == NetMsgType::MNPING ||
+        strCommand == NetMsgType::MASTERNODEPAYMENTVOTE || strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE;
+}
+
+/**
+ * Check the signatures of a run of masternode broadcasts, pings and votes from one peer in parallel.
+ * Nothing is applied here, the messages are still processed one by one in order and their
+ * CheckSignature() finds the valid signatures in the hash signer cache. Messages the handler
+ * skips or rejects before it gets to the signature (already seen, failing the cheap checks or
+ * from an unknown masternode) are left out so a peer cannot make us recover keys for nothing.
+ */
+static void PreverifyMasternodeSignatures(const std::vector<std::pair<std::string, CDataStream>>& vecMsgs)
+{
+    std::vector<CHashSignature> vecSigs;
+    vecSigs.reserve(vecMsgs.size() + 1);
+    for (const auto& pairMsg : vecMsgs) {
+        // work on a copy, the stream is still read by the message handler
+        CDataStream vRecv(pairMsg.second);
+        masternode_info_t mnInfo;
+        try {
+            if (pairMsg.first == NetMsgType::MNANNOUNCE) {
+                CMasternodeBroadcast mnb;
+                vRecv >> mnb;
+                int nDos = 0;
+                if (mnodeman.HasSeenMasternodeBroadcast(mnb.GetHash()) || !mnb.SimpleCheck(nDos) ||
+                    CMasternode::CheckCollateral(mnb.outpoint, mnb.pubKeyCollateralAddress) != CMasternode::COLLATERAL_OK)
+                    continue;
+                vecSigs.push_back(mnb.GetHashSignature());
+                if (mnb.lastPing)
+                    vecSigs.push_back(mnb.lastPing.GetHashSignature(mnb.pubKeyMasternode));
+            } else if (pairMsg.first == NetMsgType::MNPING) {
+                CMasternodePing mnp;
+                vRecv >> mnp;
+                if (mnodeman.HasSeenMasternodePing(mnp.GetHash()))
+                    continue;
+                if (mnodeman.GetMasternodeInfo(mnp.masternodeOutpoint, mnInfo))
+                    vecSigs.push_back(mnp.GetHashSignature(mnInfo.pubKeyMasternode));
+            } else if (pairMsg.first == NetMsgType::MASTERNODEPAYMENTVOTE) {
+                CMasternodePaymentVote vote;
+                vRecv >> vote;
+                if (mnpayments.HasVerifiedPaymentVote(vote.GetHash()))
+                    continue;
+                if (mnodeman.GetMasternodeInfo(vote.masternodeOutpoint, mnInfo))
+                    vecSigs.push_back(vote.GetHashSignature(mnInfo.pubKeyMasternode));
+            } else if (pairMsg.first == NetMsgType::MNGOVERNANCEOBJECTVOTE) {
+                CGovernanceVote vote;
+                vRecv >> vote;
+                if (governance.HaveVoteForHash(vote.GetHash()))
+                    continue;
+                if (mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), mnInfo))
+                    vecSigs.push_back(vote.GetHashSignature(mnInfo.pubKeyMasternode));
+            }
+        } catch (const std::exception&) {
+            // malformed, the message handler reports it
+        }
+    }
+    if (vecSigs.size() > 1)
+        CHashSigner::VerifyHashes(vecSigs);
+}
+
 bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3474,6 +3540,7 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return false;
 
     std::list<CNetMessage> msgs;
+    std::vector<std::pair<std::string, CDataStream>> vecPreverifyMsgs;
     {
         LOCK(pfrom->cs_vProcessMsg);
         if (pfrom->vProcessMsg.empty())
@@ -3483,10 +3550,29 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         pfrom->nProcessQueueSize -= msgs.front().vRecv.size() + CMessageHeader::HEADER_SIZE;
         pfrom->fPauseRecv = pfrom->nProcessQueueSize > connman->GetReceiveFloodSize();
         fMoreWork = !pfrom->vProcessMsg.empty();
+        // PAYDAYCOIN masternode messages tend to arrive in bursts, check the signatures of the ones
+        // queued behind this one together instead of one message at a time
+        if (pfrom->nPreverifiedSigMsgs > 0) {
+            pfrom->nPreverifiedSigMsgs--;
+        } else if (IsMasternodeSigCommand(msgs.front().hdr.GetCommand()) && !pfrom->vProcessMsg.empty() && sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
+            vecPreverifyMsgs.emplace_back(msgs.front().hdr.GetCommand(), msgs.front().vRecv);
+            for (const CNetMessage& msgQueued : pfrom->vProcessMsg) {
+                if (pfrom->nPreverifiedSigMsgs == MAX_PREVERIFY_SIG_MSGS)
+                    break;
+                pfrom->nPreverifiedSigMsgs++;
+                if (IsMasternodeSigCommand(msgQueued.hdr.GetCommand()))
+                    vecPreverifyMsgs.emplace_back(msgQueued.hdr.GetCommand(), msgQueued.vRecv);
+            }
+        }
     }
     CNetMessage& msg(msgs.front());
 
     msg.SetVersion(pfrom->GetRecvVersion());
+    if (!vecPreverifyMsgs.empty()) {
+        for (auto& pairMsg : vecPreverifyMsgs)
+            pairMsg.second.SetVersion(pfrom->GetRecvVersion());
+        PreverifyMasternodeSignatures(vecPreverifyMsgs);
+    }
     // Scan for message start
     if (memcmp(msg.hdr.pchMessageStart, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE) != 0) {
         LogPrint(BCLog::NET, "PROCESSMESSAGE: INVALID MESSAGESTART %s peer=%d\n", SanitizeString(msg.hdr.GetCommand()), pfrom->GetId());
@@ -0,0 +1,238 @@
+// Copyright (c) 2017-2018 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PAYDAYCOIN_OPENHASHMAP_H
+#define PAYDAYCOIN_OPENHASHMAP_H
+
+#include <memusage.h>
+#include <serialize.h>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * STL-like hash map using open addressing with linear probing and backward shift deletion.
+ *
+ * Entries live in one contiguous array and a parallel one byte control array holds an occupied
+ * bit plus 7 bits of the hash, so most probes are resolved without comparing keys and without
+ * chasing per-node heap pointers like std::unordered_map does.
+ *
+ * Any insert or erase may move other entries: iterators and references are only valid until
+ * the next modification of the map, and erase() does not return an iterator.
+ */
+template <typename K, typename V, typename Hasher>
+class openhashmap
+{
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<K, V> value_type;
+    typedef size_t size_type;
+
+private:
+    enum : size_t { MIN_CAPACITY = 16 };
+    enum : unsigned char { CTRL_EMPTY = 0 };
+
+    std::vector<unsigned char> vCtrl;
+    /** Slot storage, a slot holds a constructed entry exactly when its control byte is not CTRL_EMPTY */
+    value_type* pSlots = nullptr;
+    size_t nSize = 0;
+    Hasher hasher;
+
+    static unsigned char Tag(size_t hash) { return 0x80 | (unsigned char)(hash >> (sizeof(size_t) * 8 - 7)); }
+    size_t Capacity() const { return vCtrl.size(); }
+    size_t Mask() const { return vCtrl.size() - 1; }
+
+    /** Slot holding key, or Capacity() if it is not present */
+    size_t FindSlot(const key_type& key) const
+    {
+        if (nSize == 0)
+            return Capacity();
+        const size_t hash = hasher(key);
+        const unsigned char tag = Tag(hash);
+        const size_t mask = Mask();
+        for (size_t i = hash & mask; vCtrl[i] != CTRL_EMPTY; i = (i + 1) & mask) {
+            if (vCtrl[i] == tag && pSlots[i].first == key)
+                return i;
+        }
+        return Capacity();
+    }
+
+    /** First free slot on the probe sequence of hash, the key must not be present */
+    size_t FreeSlot(size_t hash) const
+    {
+        const size_t mask = Mask();
+        size_t i = hash & mask;
+        while (vCtrl[i] != CTRL_EMPTY)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    /** Move the entry in slot j into the free slot i, entries are only ever moved by construction so V need not be assignable */
+    void MoveSlot(size_t i, size_t j)
+    {
+        new (&pSlots[i]) value_type(std::move(pSlots[j]));
+        pSlots[j].~value_type();
+        vCtrl[i] = vCtrl[j];
+        vCtrl[j] = CTRL_EMPTY;
+    }
+
+    void Rehash(size_t nCapacity)
+    {
+        std::vector<unsigned char> vOldCtrl(nCapacity, (unsigned char)CTRL_EMPTY);
+        value_type* pOldSlots = std::allocator<value_type>().allocate(nCapacity);
+        vOldCtrl.swap(vCtrl);
+        std::swap(pOldSlots, pSlots);
+        for (size_t i = 0; i < vOldCtrl.size(); i++) {
+            if (vOldCtrl[i] == CTRL_EMPTY)
+                continue;
+            const size_t j = FreeSlot(hasher(pOldSlots[i].first));
+            new (&pSlots[j]) value_type(std::move(pOldSlots[i]));
+            pOldSlots[i].~value_type();
+            vCtrl[j] = vOldCtrl[i];
+        }
+        if (pOldSlots)
+            std::allocator<value_type>().deallocate(pOldSlots, vOldCtrl.size());
+    }
+
+    void EraseSlot(size_t i)
+    {
+        const size_t mask = Mask();
+        pSlots[i].~value_type();
+        vCtrl[i] = CTRL_EMPTY;
+        nSize--;
+        // shift the rest of the cluster back so lookups never need tombstones
+        for (size_t j = (i + 1) & mask; vCtrl[j] != CTRL_EMPTY; j = (j + 1) & mask) {
+            const size_t home = hasher(pSlots[j].first) & mask;
+            // entry j may fill the hole at i only if its home is not cyclically within (i, j]
+            const bool fInRange = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+            if (fInRange)
+                continue;
+            MoveSlot(i, j);
+            i = j;
+        }
+    }
+
+    template <typename Map, typename Value>
+    class iterator_base
+    {
+    private:
+        Map* pmap;
+        size_t i;
+        void Skip() { while (i < pmap->Capacity() && pmap->vCtrl[i] == CTRL_EMPTY) i++; }
+
+    public:
+        iterator_base(Map* pmapIn, size_t iIn) : pmap(pmapIn), i(iIn) { Skip(); }
+        Value& operator*() const { return pmap->pSlots[i]; }
+        Value* operator->() const { return &pmap->pSlots[i]; }
+        iterator_base& operator++() { i++; Skip(); return *this; }
+        bool operator==(const iterator_base& other) const { return i == other.i; }
+        bool operator!=(const iterator_base& other) const { return i != other.i; }
+        size_t index() const { return i; }
+    };
+
+public:
+    typedef iterator_base<openhashmap, value_type> iterator;
+    typedef iterator_base<const openhashmap, const value_type> const_iterator;
+
+    openhashmap() {}
+    openhashmap(const openhashmap&) = delete;
+    openhashmap& operator=(const openhashmap&) = delete;
+    ~openhashmap() { clear(); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, Capacity()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, Capacity()); }
+    size_type size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+
+    iterator find(const key_type& key) { return iterator(this, FindSlot(key)); }
+    const_iterator find(const key_type& key) const { return const_iterator(this, FindSlot(key)); }
+    size_type count(const key_type& key) const { return FindSlot(key) == Capacity() ? 0 : 1; }
+
+    /** Insert key with a value constructed from args unless key is already present, like std::map::try_emplace */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const key_type& key, Args&&... args)
+    {
+        const size_t nFound = FindSlot(key);
+        if (nFound != Capacity())
+            return std::make_pair(iterator(this, nFound), false);
+        // keep the load factor at or below 3/4
+        if ((nSize + 1) * 4 > Capacity() * 3)
+            Rehash(std::max(Capacity() * 2, (size_t)MIN_CAPACITY));
+        const size_t hash = hasher(key);
+        const size_t i = FreeSlot(hash);
+        new (&pSlots[i]) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        vCtrl[i] = Tag(hash);
+        nSize++;
+        return std::make_pair(iterator(this, i), true);
+    }
+
+    mapped_type& operator[](const key_type& key) { return emplace(key).first->second; }
+
+    void erase(iterator it) { EraseSlot(it.index()); }
+    size_type erase(const key_type& key)
+    {
+        const size_t i = FindSlot(key);
+        if (i == Capacity())
+            return 0;
+        EraseSlot(i);
+        return 1;
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < Capacity(); i++) {
+            if (vCtrl[i] != CTRL_EMPTY)
+                pSlots[i].~value_type();
+        }
+        if (pSlots)
+            std::allocator<value_type>().deallocate(pSlots, Capacity());
+        pSlots = nullptr;
+        vCtrl.clear();
+        nSize = 0;
+    }
+
+    void reserve(size_type n)
+    {
+        size_t nCapacity = MIN_CAPACITY;
+        while (nCapacity * 3 < n * 4)
+            nCapacity *= 2;
+        if (nCapacity > Capacity())
+            Rehash(nCapacity);
+    }
+
+    /** Memory held by the slot arrays, not counting heap memory owned by the keys and values */
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(vCtrl) + memusage::MallocUsage(sizeof(value_type) * Capacity()); }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        WriteCompactSize(s, nSize);
+        for (const value_type& entry : *this) {
+            ::Serialize(s, entry.first);
+            ::Serialize(s, entry.second);
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        clear();
+        const size_t nEntries = ReadCompactSize(s);
+        // do not trust the size prefix for more than a bounded up front allocation
+        reserve(std::min(nEntries, (size_t)MAX_SIZE / 1024));
+        for (size_t n = 0; n < nEntries; n++) {
+            key_type key;
+            ::Unserialize(s, key);
+            ::Unserialize(s, emplace(key).first->second);
+        }
+    }
+};
+
+#endif // PAYDAYCOIN_OPENHASHMAP_H
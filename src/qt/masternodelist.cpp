@@ -294,25 +294,40 @@ void MasternodeList::updateNodeList()
     ui->tableWidgetMasternodes->setSortingEnabled(false);
     ui->tableWidgetMasternodes->clearContents();
     ui->tableWidgetMasternodes->setRowCount(0);
-    const std::map<COutPoint, CMasternode> &mapMasternodes = mnodeman.GetFullMasternodeMap();
     int offsetFromUtc = GetOffsetFromUtc();
 
-    for (const auto& mnpair : mapMasternodes)
+    // copy what is shown out of the list first, the widgets are built without holding the masternode list lock
+    struct node_row_t {
+        std::string strAddress;
+        int nProtocolVersion;
+        std::string strStatus;
+        int nLevel;
+        int64_t sigTime;
+        int64_t nLastPingTime;
+        CPubKey pubKeyCollateralAddress;
+    };
+    std::vector<node_row_t> vecRows;
+    vecRows.reserve(mnodeman.size());
+    mnodeman.ForEachMasternode([&](const CMasternode& mn)
+    {
+        vecRows.push_back({mn.addr.ToString(), mn.nProtocolVersion, mn.GetStatus(), mn.nLevel, mn.sigTime, mn.lastPing.sigTime, mn.pubKeyCollateralAddress});
+    });
+
+    for (const node_row_t& row : vecRows)
     {
-        CMasternode mn = mnpair.second;
         // populate list
         // Address, Protocol, Status, Active Seconds, Last Seen, Pub Key
-        QTableWidgetItem *addressItem = new QTableWidgetItem(QString::fromStdString(mn.addr.ToString()));
-        QTableWidgetItem *protocolItem = new QTableWidgetItem(QString::number(mn.nProtocolVersion));
-        QTableWidgetItem *statusItem = new QTableWidgetItem(QString::fromStdString(mn.GetStatus()));
-        QTableWidgetItem* levelItem = new QTableWidgetItem(QString::fromStdString(CMasternode::GetLevel(mn.nLevel)));
-        int64_t activeTime = (int64_t)(mn.lastPing.sigTime - mn.sigTime);
+        QTableWidgetItem *addressItem = new QTableWidgetItem(QString::fromStdString(row.strAddress));
+        QTableWidgetItem *protocolItem = new QTableWidgetItem(QString::number(row.nProtocolVersion));
+        QTableWidgetItem *statusItem = new QTableWidgetItem(QString::fromStdString(row.strStatus));
+        QTableWidgetItem* levelItem = new QTableWidgetItem(QString::fromStdString(CMasternode::GetLevel(row.nLevel)));
+        int64_t activeTime = row.nLastPingTime - row.sigTime;
         if(activeTime <= 0)
-            activeTime = (int64_t)(GetAdjustedTime() - mn.sigTime);
-            
+            activeTime = GetAdjustedTime() - row.sigTime;
+
         QTableWidgetItem *activeSecondsItem = new QTableWidgetItem(QString::fromStdString(DurationToDHMS(activeTime)));
-        QTableWidgetItem *lastSeenItem = new QTableWidgetItem(QString::fromStdString(DateTimeStrFormat("%Y-%m-%d %H:%M", mn.lastPing.sigTime + offsetFromUtc)));
-        QTableWidgetItem *pubkeyItem = new QTableWidgetItem(QString::fromStdString(EncodeDestination(PKHash(mn.pubKeyCollateralAddress))));
+        QTableWidgetItem *lastSeenItem = new QTableWidgetItem(QString::fromStdString(DateTimeStrFormat("%Y-%m-%d %H:%M", row.nLastPingTime + offsetFromUtc)));
+        QTableWidgetItem *pubkeyItem = new QTableWidgetItem(QString::fromStdString(EncodeDestination(PKHash(row.pubKeyCollateralAddress))));
 
         if (strCurrentFilter != "")
         {
@@ -323,7 +338,16 @@ void MasternodeList::updateNodeList()
                             activeSecondsItem->text() + " " +
                             lastSeenItem->text() + " " +
                             pubkeyItem->text();
-            if (!strToFilter.contains(strCurrentFilter)) continue;
+            if (!strToFilter.contains(strCurrentFilter)) {
+                delete addressItem;
+                delete protocolItem;
+                delete statusItem;
+                delete levelItem;
+                delete activeSecondsItem;
+                delete lastSeenItem;
+                delete pubkeyItem;
+                continue;
+            }
         }
 
         ui->tableWidgetMasternodes->insertRow(0);
@@ -499,27 +499,25 @@ UniValue masternodelist(const JSONRPCRequest& request)
             obj.pushKV(strOutpoint, rankpair.first);
         }
     } else {
-        const std::map<COutPoint, CMasternode> &mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (const auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
-            std::string strOutpoint = mnpair.first.ToStringShort();
+        mnodeman.ForEachMasternode([&](const CMasternode& mn) {
+            std::string strOutpoint = mn.outpoint.ToStringShort();
             if (strMode == "activeseconds") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, (int64_t)(mn.lastPing.sigTime - mn.sigTime));
             } else if (strMode == "addr") {
                 std::string strAddress = mn.addr.ToString();
                 if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strAddress);
             } else if (strMode == "daemon") {
                 std::string strDaemon = mn.lastPing.GetDaemonString();
                 if (strFilter !="" && strDaemon.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strDaemon);
             } else if (strMode == "sentinel") {
                 std::string strSentinel = mn.lastPing.GetSentinelString();
                 if (strFilter !="" && strSentinel.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strSentinel);
             } else if (strMode == "full") {
                 std::ostringstream streamFull;
@@ -535,7 +533,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.nPingRetries;
                 std::string strFull = streamFull.str();
                 if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strFull);
             } else if (strMode == "info") {
                 std::ostringstream streamInfo;
@@ -551,7 +549,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.nPingRetries;
                 std::string strInfo = streamInfo.str();
                 if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strInfo);
             } else if (strMode == "json") {
                 std::ostringstream streamInfo;
@@ -569,7 +567,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                                mn.nPingRetries;
                 std::string strInfo = streamInfo.str();
                 if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 UniValue objMN(UniValue::VOBJ);
                 objMN.pushKV("address", mn.addr.ToString());
                 objMN.pushKV("payee", EncodeDestination(PKHash(mn.pubKeyCollateralAddress)));
@@ -589,33 +587,33 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 objMN.pushKV("pingretries", mn.nPingRetries);
                 obj.pushKV(strOutpoint, objMN);
             } else if (strMode == "lastpaidblock") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, mn.GetLastPaidBlock());
             } else if (strMode == "lastpaidtime") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, mn.GetLastPaidTime());
             } else if (strMode == "lastseen") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, (int64_t)mn.lastPing.sigTime);
             } else if (strMode == "payee") {
                 std::string strPayee = EncodeDestination(PKHash(mn.pubKeyCollateralAddress));
                 if (strFilter !="" && strPayee.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strPayee);
             } else if (strMode == "protocol") {
                 if (strFilter !="" && strFilter != strprintf("%d", mn.nProtocolVersion) &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, mn.nProtocolVersion);
             } else if (strMode == "pubkey") {
-                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
+                if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, HexStr(mn.pubKeyMasternode));
             } else if (strMode == "status") {
                 std::string strStatus = mn.GetStatus();
                 if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
-                    strOutpoint.find(strFilter) == std::string::npos) continue;
+                    strOutpoint.find(strFilter) == std::string::npos) return;
                 obj.pushKV(strOutpoint, strStatus);
             }
-        }
+        });
     }
     return obj;
 }
@@ -7,25 +7,20 @@
 #include <services/assetconsensus.h>
 #include <validationinterface.h>
 #include <boost/thread.hpp>
+#include <set>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif
 #include <services/rpc/assetrpc.h>
+#include <index/assetindex.h>
 #include <rpc/server.h>
 extern std::string EncodeDestination(const CTxDestination& dest);
 extern CTxDestination DecodeDestination(const std::string& str);
 extern UniValue ValueFromAmount(const CAmount& amount);
-extern UniValue DescribeAddress(const CTxDestination& dest);
 extern CAmount AmountFromValue(const UniValue& value);
-extern UniValue convertaddress(const JSONRPCRequest& request);
-extern AssetBalanceMap mempoolMapAssetBalances;
-extern ArrivalTimesMapImpl arrivalTimesMap;
-extern CCriticalSection cs_assetallocation;
-extern CCriticalSection cs_assetallocationarrival;
 std::unique_ptr<CAssetDB> passetdb;
 std::unique_ptr<CAssetAllocationDB> passetallocationdb;
 std::unique_ptr<CAssetAllocationMempoolDB> passetallocationmempooldb;
-std::unique_ptr<CAssetIndexDB> passetindexdb;
 
 
 using namespace std;
@@ -225,8 +220,8 @@ bool CAsset::UnserializeFromData(const vector<unsigned char> &vchData) {
 }
 bool CMintPaydayCoin::UnserializeFromData(const vector<unsigned char> &vchData) {
     try {
-        CDataStream dsMS(vchData, SER_NETWORK, PROTOCOL_VERSION);
-        dsMS >> *this;
+        // mints carry whole proofs, read them in place rather than through a copy of the payload
+        VectorReader(SER_NETWORK, PROTOCOL_VERSION, vchData, 0) >> *this;
     } catch (std::exception &e) {
         SetNull();
         return false;
@@ -268,19 +263,7 @@ bool FlushPaydayCoinDBs() {
         if (passetallocationmempooldb != nullptr)
         {
             ResyncAssetAllocationStates();
-            {
-                LOCK(cs_assetallocation);
-                LogPrintf("Flushing Asset Allocation Mempool Balances...size %d\n", mempoolMapAssetBalances.size());
-                passetallocationmempooldb->WriteAssetAllocationMempoolBalances(mempoolMapAssetBalances);
-                mempoolMapAssetBalances.clear();
-            }
-            {
-                LOCK(cs_assetallocationarrival);
-                LogPrintf("Flushing Asset Allocation Arrival Times...size %d\n", arrivalTimesMap.size());
-                passetallocationmempooldb->WriteAssetAllocationMempoolArrivalTimes(arrivalTimesMap);
-                arrivalTimesMap.clear();
-            }
-            if (!passetallocationmempooldb->Flush()) {
+            if (!passetallocationmempooldb->FlushZDAGState(zdagState) || !passetallocationmempooldb->Flush()) {
                 LogPrintf("Failed to write to asset allocation mempool database!\n");
                 ret = false;
             }            
@@ -309,7 +292,7 @@ void CTxMemPool::removeExpiredMempoolBalances(setEntries& stage){
             CAssetAllocation allocation(tx);
             if(allocation.assetAllocationTuple.IsNull())
                 continue;
-            if(ResetAssetAllocation(allocation.assetAllocationTuple.ToString(), tx.GetHash())){
+            if(ResetAssetAllocation(CAssetAllocationTupleKey(allocation.assetAllocationTuple), tx.GetHash())){
                 count++;
             }
         }
@@ -317,6 +300,19 @@ void CTxMemPool::removeExpiredMempoolBalances(setEntries& stage){
     if(count > 0)
          LogPrint(BCLog::PDAY, "removeExpiredMempoolBalances removed %d expired asset allocation transactions from mempool balances\n", count);  
 }
+void CTxMemPool::removeZDAGSenderIndex(const CTxMemPoolEntry& entry){
+    const CTransaction& tx = entry.GetTx();
+    if(!IsAssetAllocationTx(tx.nVersion) || tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_LOCK)
+        return;
+    // the arrival time stays until it expires, only the conflict index must not count sends that left the mempool
+    const PaydayCoinTxPayloadRef payload = entry.GetPaydayCoinPayload()? entry.GetPaydayCoinPayload(): MakePaydayCoinTxPayload(tx);
+    const CAssetAllocationTupleKey senderTupleKey(payload->assetAllocation.assetAllocationTuple);
+    CZDAGShard& shard = zdagState.GetShard(senderTupleKey);
+    LOCK_ZDAG_SHARD(shard);
+    auto senderIndex = shard.mapSenderIndexes.find(senderTupleKey);
+    if(senderIndex != shard.mapSenderIndexes.end())
+        senderIndex->second.Remove(tx.GetHash());
+}
 bool FindAssetOwnerInTx(const CCoinsViewCache &inputs, const CTransaction& tx, const CWitnessAddress &witnessAddressToMatch) {
 	CTxDestination dest;
 	int witnessversion;
@@ -491,44 +487,18 @@ void CMintPaydayCoin::Serialize( vector<unsigned char> &vchData) {
     vchData = vector<unsigned char>(dsMint.begin(), dsMint.end());
 
 }
-void WriteAssetIndexTXID(const uint32_t& nAsset, const uint256& txid){
-    int64_t page;
-    if(!passetindexdb->ReadAssetPage(page)){
-        page = 0;
-        if(!passetindexdb->WriteAssetPage(page))
-           LogPrint(BCLog::PDAY, "Failed to write asset page\n");                  
-    }
-    std::vector<uint256> TXIDS;
-    passetindexdb->ReadIndexTXIDs(nAsset, page, TXIDS);
-    // new page needed
-    if(((int)TXIDS.size()) >= fAssetIndexPageSize){
-        TXIDS.clear();
-        page++;
-        if(!passetindexdb->WriteAssetPage(page))
-            LogPrint(BCLog::PDAY, "Failed to write asset page\n");
-    }
-    TXIDS.push_back(txid);
-    if(!passetindexdb->WriteIndexTXIDs(nAsset, page, TXIDS))
-        LogPrint(BCLog::PDAY, "Failed to write asset index txids\n");
-}
-void CAssetDB::WriteAssetIndex(const CTransaction& tx, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash) {
-	if (fZMQAsset || fAssetIndex) {
+void CAssetDB::NotifyAssetUpdate(const CTransaction& tx, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash) {
+	if (fZMQAsset) {
         if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(),fAssetIndexGuids.end(),dbAsset.nAsset) == fAssetIndexGuids.end()){
-            LogPrint(BCLog::PDAY, "Asset cannot be indexed because it is not set in -assetindexguids list\n");
+            LogPrint(BCLog::PDAY, "Asset update is not notified because it is not set in -assetindexguids list\n");
             return;
         }
-		UniValue oName(UniValue::VOBJ);
-        // assetsends write allocation indexes
-        if(tx.nVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND && AssetTxToJSON(tx, nHeight, blockhash, oName)){
-            if(fZMQAsset)
+        // assetsends notify allocation updates
+        CAssetIndexTxRecord record;
+        if(tx.nVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND && record.FromAssetTx(tx, nHeight, blockhash)){
+            UniValue oName(UniValue::VOBJ);
+            if(record.ToJSON(tx.GetHash(), oName))
                 GetMainSignals().NotifyPaydayCoinUpdate(oName.write().c_str(), "assetrecord");
-            if(fAssetIndex)
-            {
-                const uint256& txid = tx.GetHash();
-                WriteAssetIndexTXID(dbAsset.nAsset, txid);
-                if(!passetindexdb->WritePayload(txid, oName))
-                    LogPrint(BCLog::PDAY, "Failed to write asset index payload\n");
-            }
         }
 	}
 }
@@ -610,13 +580,17 @@ bool AssetTxToJSON(const CTransaction& tx, UniValue &entry)
 }
 bool AssetTxToJSON(const CTransaction& tx, const int& nHeight, const uint256& blockhash, UniValue &entry)
 {
-    CAsset asset(tx);
+    const CAsset asset(tx);
+    return AssetTxToJSON(tx.nVersion, tx.GetHash(), asset, nHeight, blockhash, entry);
+}
+bool AssetTxToJSON(const int& nTxVersion, const uint256& txid, const CAsset& asset, const int& nHeight, const uint256& blockhash, UniValue &entry)
+{
     if(asset.IsNull())
         return false;
-    entry.__pushKV("txtype", assetFromTx(tx.nVersion));
+    entry.__pushKV("txtype", assetFromTx(nTxVersion));
     entry.__pushKV("asset_guid", (int)asset.nAsset);
     entry.__pushKV("symbol", asset.strSymbol);
-    entry.__pushKV("txid", tx.GetHash().GetHex());
+    entry.__pushKV("txid", txid.GetHex());
     entry.__pushKV("height", nHeight);
 
     if(!asset.vchPubData.empty())
@@ -637,7 +611,7 @@ bool AssetTxToJSON(const CTransaction& tx, const int& nHeight, const uint256& bl
     if (asset.nBalance > 0)
         entry.__pushKV("balance", ValueFromAssetAmount(asset.nBalance, asset.nPrecision));
 
-    if (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ACTIVATE){
+    if (nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ACTIVATE){
         entry.__pushKV("total_supply", ValueFromAssetAmount(asset.nTotalSupply, asset.nPrecision));
         entry.__pushKV("max_supply", ValueFromAssetAmount(asset.nMaxSupply, asset.nPrecision));
         entry.__pushKV("precision", asset.nPrecision);  
@@ -645,72 +619,129 @@ bool AssetTxToJSON(const CTransaction& tx, const int& nHeight, const uint256& bl
     entry.__pushKV("blockhash", blockhash.GetHex()); 
     return true;
 }
-bool CAssetDB::Flush(const AssetMap &mapAssets){
-    if(mapAssets.empty())
+bool CAssetIndexTxRecord::FromAssetTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn) {
+    nTxVersion = tx.nVersion;
+    nHeight = nHeightIn;
+    blockhash = blockhashIn;
+    return asset.UnserializeFromTx(tx) && !asset.IsNull();
+}
+bool CAssetIndexTxRecord::FromAssetAllocationTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn) {
+    nTxVersion = tx.nVersion;
+    nHeight = nHeightIn;
+    blockhash = blockhashIn;
+    if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN){
+        if(!GetPaydayCoinBurnData(tx, &assetAllocation, vchEthAddress))
+            return false;
+    }
+    else
+        assetAllocation.UnserializeFromTx(tx);
+    return !assetAllocation.assetAllocationTuple.IsNull();
+}
+bool CAssetIndexTxRecord::FromMintTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn) {
+    nTxVersion = tx.nVersion;
+    nHeight = nHeightIn;
+    blockhash = blockhashIn;
+    if(!mintPaydayCoin.UnserializeFromTx(tx) || tx.vout.empty())
+        return false;
+    if(tx.nVersion == PAYDAYCOIN_TX_VERSION_MINT)
+        txOutMint = tx.vout[0];
+    return true;
+}
+bool CAssetIndexTxRecord::ToJSON(const uint256& txid, UniValue& entry) const {
+    if(IsPaydayCoinMintTx(nTxVersion))
+        return AssetMintTxToJson(nTxVersion, txid, mintPaydayCoin, txOutMint, nHeight, blockhash, entry);
+    if(IsAssetTx(nTxVersion) && nTxVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+        return AssetTxToJSON(nTxVersion, txid, asset, nHeight, blockhash, entry);
+    CAsset dbAsset;
+    GetAsset(assetAllocation.assetAllocationTuple.nAsset, dbAsset);
+    return AssetAllocationTxToJSON(nTxVersion, txid, assetAllocation, vchEthAddress, dbAsset, nHeight, blockhash, entry);
+}
+void CAssetCacheTraits::Copy(const CAsset& from, CAsset& to){
+    to.nAsset = from.nAsset;
+    to.witnessAddress = from.witnessAddress;
+    to.witnessAddressTransfer = from.witnessAddressTransfer;
+    to.vchContract = from.vchContract;
+    to.strSymbol = from.strSymbol;
+    to.txHash = from.txHash;
+    to.nHeight = from.nHeight;
+    to.vchPubData = from.vchPubData;
+    to.nBalance = from.nBalance;
+    to.nTotalSupply = from.nTotalSupply;
+    to.nMaxSupply = from.nMaxSupply;
+    to.nPrecision = from.nPrecision;
+    to.nUpdateFlags = from.nUpdateFlags;
+    to.nDumurrageOrInterest = from.nDumurrageOrInterest;
+}
+size_t CAssetCacheTraits::DynamicUsage(const CAsset& asset){
+    return memusage::DynamicUsage(asset.witnessAddress.vchWitnessProgram) + memusage::DynamicUsage(asset.witnessAddressTransfer.vchWitnessProgram) +
+        memusage::DynamicUsage(asset.vchContract) + memusage::DynamicUsage(asset.vchPubData) + memusage::MallocUsage(asset.strSymbol.capacity());
+}
+bool CAssetDB::ReadAsset(const uint32_t& nAsset, CAsset& asset){
+    uint64_t nGeneration;
+    const int nCached = cache.Get(nAsset, asset, nGeneration);
+    if(nCached >= 0)
+        return nCached == 1;
+    if(!Read(std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(nAsset, CWitnessAddress())), asset)){
+        cache.Add(nAsset, nullptr, nGeneration);
+        return false;
+    }
+    cache.Add(nAsset, &asset, nGeneration);
+    return true;
+}
+bool CAssetDB::Flush(const AssetMap &mapAssets, const bool fSync, const uint256 &hashBestBlock){
+    if(mapAssets.empty() && hashBestBlock.IsNull())
         return true;
 	int write = 0;
 	int erase = 0;
     CDBBatch batch(*this);
-    std::map<std::string, std::vector<uint32_t> > mapGuids;
-    std::vector<uint32_t> emptyVec;
-    if(fAssetIndex){
-        for (const auto &key : mapAssets) {
-            if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), key.first) == fAssetIndexGuids.end())
-                continue;
-            auto it = mapGuids.emplace(std::piecewise_construct,  std::forward_as_tuple(key.second.witnessAddress.ToString()),  std::forward_as_tuple(emptyVec));
-            std::vector<uint32_t> &assetGuids = it.first->second;
-            // if wasn't found and was added to the map
-            if(it.second)
-                ReadAssetsByAddress(key.second.witnessAddress, assetGuids);
-            // erase asset address association
-            if (key.second.IsNull()) {
-                auto itVec = std::find(assetGuids.begin(), assetGuids.end(),  key.first);
-                if(itVec != assetGuids.end()){
-                    assetGuids.erase(itVec);  
-                    // ensure we erase only the ones that are actually being cleared
-                    if(assetGuids.empty())
-                        assetGuids.emplace_back(0);
-                }
-            }
-            else{
-                // add asset address association
-                auto itVec = std::find(assetGuids.begin(), assetGuids.end(),  key.first);
-                if(itVec == assetGuids.end()){
-                    // if we had the special erase flag we remove that and add the real guid
-                    if(assetGuids.size() == 1 && assetGuids[0] == 0)
-                        assetGuids.clear();
-                    assetGuids.emplace_back(key.first);
-                }
-            }      
-        }
-    }
+    CAsset dbAsset;
     for (const auto &key : mapAssets) {
+        const auto recordKey = std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(key.first, CWitnessAddress()));
+        // only the stored record knows the previous owner, a transfer moves the asset to another owner range
+        if (Read(recordKey, dbAsset) && !dbAsset.IsNull() && (key.second.IsNull() || dbAsset.witnessAddress != key.second.witnessAddress))
+            batch.Erase(std::make_pair(DB_ASSET_OWNER, CAssetOwnerKey(dbAsset.witnessAddress, key.first)));
 		if (key.second.IsNull()) {
 			erase++;
-			batch.Erase(key.first);
+			batch.Erase(recordKey);
 		}
 		else {
 			write++;
-			batch.Write(key.first, key.second);
+			batch.Write(recordKey, key.second);
+            batch.Write(std::make_pair(DB_ASSET_OWNER, CAssetOwnerKey(key.second.witnessAddress, key.first)), '\0');
 		}
-        if(fAssetIndex){
-            if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), key.first) == fAssetIndexGuids.end())
-                continue;
-            auto it = mapGuids.find(key.second.witnessAddress.ToString());
-            if(it == mapGuids.end())
-                continue;
-            const std::vector<uint32_t>& assetGuids = it->second;
-            // check for special clearing flag before batch erase
-            if(assetGuids.size() == 1 && assetGuids[0] == 0)
-                batch.Erase(key.second.witnessAddress);   
-            else
-                batch.Write(key.second.witnessAddress, assetGuids); 
-            // we have processed this address so don't process again
-            mapGuids.erase(it);        
-        }
     }
+    if (!hashBestBlock.IsNull())
+        batch.Write(DB_ASSET_BEST_BLOCK, hashBestBlock);
     LogPrint(BCLog::PDAY, "Flushing %d assets (erased %d, written %d)\n", mapAssets.size(), erase, write);
-    return WriteBatch(batch);
+    return WriteBatch(batch, fSync);
+}
+bool CAssetDB::ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids){
+    ReadAssetGuidsByOwner(*this, address, assetGuids);
+    // the owner index is written on flush, transfers of the blocks connected since then are only in the cache
+    std::set<uint32_t> setGuids(assetGuids.begin(), assetGuids.end());
+    cache.ForEachDirty([&](const int& nAsset, const CAsset& asset) {
+        if (!asset.IsNull() && asset.witnessAddress == address)
+            setGuids.insert(nAsset);
+        else
+            setGuids.erase(nAsset);
+    });
+    assetGuids.assign(setGuids.begin(), setGuids.end());
+    return !assetGuids.empty();
+}
+bool WitnessAddressFromString(const std::string& strAddress, CWitnessAddress& witnessAddress) {
+    const CTxDestination &dest = DecodeDestination(strAddress);
+    // PaydayCoin 3 P2PKH addresses stand for their P2WPKH equivalent, like in convertaddress
+    if (auto key_id = boost::get<PKHash>(&dest))
+        witnessAddress = CWitnessAddress(0, std::vector<unsigned char>(key_id->begin(), key_id->end()));
+    else if (auto witness_id = boost::get<WitnessV0KeyHash>(&dest))
+        witnessAddress = CWitnessAddress(0, std::vector<unsigned char>(witness_id->begin(), witness_id->end()));
+    else if (auto script_id = boost::get<WitnessV0ScriptHash>(&dest))
+        witnessAddress = CWitnessAddress(0, std::vector<unsigned char>(script_id->begin(), script_id->end()));
+    else if (auto witness_unknown = boost::get<WitnessUnknown>(&dest))
+        witnessAddress = CWitnessAddress((unsigned char)witness_unknown->version, std::vector<unsigned char>(witness_unknown->program, witness_unknown->program + witness_unknown->length));
+    else
+        return false;
+    return true;
 }
 bool CAssetDB::ScanAssets(const int count, const int from, const UniValue& oOptions, UniValue& oRes) {
 	string strTxid = "";
@@ -730,69 +761,92 @@ bool CAssetDB::ScanAssets(const int count, const int from, const UniValue& oOpti
 		if (owners.isArray()) {
 			const UniValue &ownersArray = owners.get_array();
 			for (unsigned int i = 0; i < ownersArray.size(); i++) {
-				const UniValue &owner = ownersArray[i].get_obj();
-                const CTxDestination &dest = DecodeDestination(owner.get_str());
-                UniValue detail = DescribeAddress(dest);
-                if(find_value(detail.get_obj(), "iswitness").get_bool() == false)
-                    throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2501 - " + _("Address must be a segwit based address"));
-                string witnessProgramHex = find_value(detail.get_obj(), "witness_program").get_str();
-                unsigned char witnessVersion = (unsigned char)find_value(detail.get_obj(), "witness_version").get_int();   
-				const UniValue &ownerStr = find_value(owner, "address");
-				if (ownerStr.isStr()) 
-					vecWitnessAddresses.push_back(CWitnessAddress(witnessVersion, ParseHex(witnessProgramHex)));
+				const UniValue &ownerStr = find_value(ownersArray[i].get_obj(), "address");
+				if (ownerStr.isStr()) {
+                    CWitnessAddress witnessAddress;
+                    if(!WitnessAddressFromString(ownerStr.get_str(), witnessAddress))
+                        throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2501 - " + _("Address must be a segwit based address"));
+					vecWitnessAddresses.push_back(std::move(witnessAddress));
+                }
 			}
 		}
 	}
-	boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
-	pcursor->SeekToFirst();
-	CAsset txPos;
-	uint32_t key = 0;
 	int index = 0;
+    // false once the page is full
+    auto addAsset = [&](const CAsset& txPos) {
+        if (txPos.IsNull() || (!strTxid.empty() && strTxid != txPos.txHash.GetHex()))
+            return true;
+        UniValue oAsset(UniValue::VOBJ);
+        if (!BuildAssetJson(txPos, oAsset))
+            return true;
+        index += 1;
+        if (index <= from)
+            return true;
+        oRes.push_back(oAsset);
+        return index < count + from;
+    };
+    CAsset txPos;
+    // guid and owner filters are point reads and owner range seeks instead of a scan of every asset
+    if (nAsset != 0 || !vecWitnessAddresses.empty()) {
+        std::vector<uint32_t> vecGuids;
+        if (vecWitnessAddresses.empty())
+            vecGuids.push_back(nAsset);
+        for (const CWitnessAddress &witnessAddress : vecWitnessAddresses) {
+            std::vector<uint32_t> vecOwnerGuids;
+            ReadAssetsByAddress(witnessAddress, vecOwnerGuids);
+            for (const uint32_t &nOwnerAsset : vecOwnerGuids) {
+                if (nAsset == 0 || nAsset == nOwnerAsset)
+                    vecGuids.push_back(nOwnerAsset);
+            }
+        }
+        // same guid order as the unfiltered listing
+        std::sort(vecGuids.begin(), vecGuids.end());
+        vecGuids.erase(std::unique(vecGuids.begin(), vecGuids.end()), vecGuids.end());
+        for (const uint32_t &nGuid : vecGuids) {
+            if (ReadAsset(nGuid, txPos) && !addAsset(txPos))
+                break;
+        }
+        return true;
+    }
+    // assets changed by the blocks connected since the last flush are only in the cache, they are merged into the scan in db key order
+    std::map<std::vector<unsigned char>, CAsset> mapDirty;
+    cache.ForEachDirty([&](const int& nGuid, const CAsset& asset) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(nGuid, CWitnessAddress()));
+        CAssetCacheTraits::Copy(asset, mapDirty[std::vector<unsigned char>(ssKey.begin(), ssKey.end())]);
+    });
+    auto itDirty = mapDirty.begin();
+	boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+	pcursor->Seek(DB_ASSET_RECORD);
+	std::pair<char, CAssetRecordKey> key;
 	while (pcursor->Valid()) {
 		boost::this_thread::interruption_point();
-		try {
-            key = 0;
-			if (pcursor->GetKey(key) && key != 0 && (nAsset == 0 || nAsset != key)) {
-				pcursor->GetValue(txPos);
-                if(txPos.IsNull()){
-                    pcursor->Next();
-                    continue;
-                }
-				if (!strTxid.empty() && strTxid != txPos.txHash.GetHex())
-				{
-					pcursor->Next();
-					continue;
-				}
-				if (!vecWitnessAddresses.empty() && std::find(vecWitnessAddresses.begin(), vecWitnessAddresses.end(), txPos.witnessAddress) == vecWitnessAddresses.end())
-				{
-					pcursor->Next();
-					continue;
-				}
-				UniValue oAsset(UniValue::VOBJ);
-				if (!BuildAssetJson(txPos, oAsset))
-				{
-					pcursor->Next();
-					continue;
-				}
-				index += 1;
-				if (index <= from) {
-					pcursor->Next();
-					continue;
-				}
-				oRes.push_back(oAsset);
-				if (index >= count + from)
-					break;
-			}
-			pcursor->Next();
-		}
-		catch (std::exception &e) {
-			return error("%s() : deserialize error", __PRETTY_FUNCTION__);
-		}
+        if (!pcursor->GetKey(key) || key.first != DB_ASSET_RECORD)
+            break;
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << key;
+        const std::vector<unsigned char> vchKey(ssKey.begin(), ssKey.end());
+        for (; itDirty != mapDirty.end() && itDirty->first < vchKey; ++itDirty) {
+            if (!addAsset(itDirty->second))
+                return true;
+        }
+        // a dirty record replaces the one in the db, erased ones are skipped by addAsset
+        if (itDirty != mapDirty.end() && itDirty->first == vchKey)
+            txPos = std::move((itDirty++)->second);
+        else if (!pcursor->GetValue(txPos))
+            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+        if (!addAsset(txPos))
+            return true;
+        pcursor->Next();
 	}
+    for (; itDirty != mapDirty.end(); ++itDirty) {
+        if (!addAsset(itDirty->second))
+            break;
+    }
 	return true;
 }
 
-bool CAssetIndexDB::ScanAssetIndex(int64_t page, const UniValue& oOptions, UniValue& oRes) {
+bool ScanAssetIndex(int64_t page, const UniValue& oOptions, UniValue& oRes) {
     CAssetAllocationTuple assetTuple;
     uint32_t nAsset = 0;
     if (!oOptions.isNull()) {
@@ -808,19 +862,10 @@ bool CAssetIndexDB::ScanAssetIndex(int64_t page, const UniValue& oOptions, UniVa
 
         const UniValue &addressObj = find_value(oOptions, "address");
         if (addressObj.isStr()) {
-            UniValue requestParam(UniValue::VARR);
-            requestParam.push_back(addressObj.get_str());
-            JSONRPCRequest jsonRequest;
-            jsonRequest.params = requestParam;
-            const UniValue &convertedAddressValue = convertaddress(jsonRequest);     
-            const std::string & v4address = find_value(convertedAddressValue.get_obj(), "v4address").get_str();              
-            const CTxDestination &dest = DecodeDestination(v4address);
-            UniValue detail = DescribeAddress(dest);
-            if(find_value(detail.get_obj(), "iswitness").get_bool() == false)
+            CWitnessAddress witnessAddress;
+            if(!WitnessAddressFromString(addressObj.get_str(), witnessAddress))
                 throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2501 - " + _("Address must be a segwit based address"));
-            string witnessProgramHex = find_value(detail.get_obj(), "witness_program").get_str();
-            unsigned char witnessVersion = (unsigned char)find_value(detail.get_obj(), "witness_version").get_int();   
-            assetTuple = CAssetAllocationTuple(nAsset, CWitnessAddress(witnessVersion, ParseHex(witnessProgramHex)));
+            assetTuple = CAssetAllocationTuple(nAsset, witnessAddress);
         }
     }
     else{
@@ -828,37 +873,22 @@ bool CAssetIndexDB::ScanAssetIndex(int64_t page, const UniValue& oOptions, UniVa
         return false;
     }
     vector<uint256> vecTX;
-    int64_t pageFound;
     bool scanAllocation = !assetTuple.IsNull();
     if(scanAllocation){
-        if(!ReadAssetAllocationPage(pageFound))
-            return true;
-    }
-    else{
-        if(!ReadAssetPage(pageFound))
-            return true;
-    }
-    if(pageFound < page){
-        LogPrint(BCLog::PDAY, "ScanAssetIndex: failed, no entries found in the page table pageFound %d vs %d page\n",pageFound, page);
-        return false;
-    }
-    // order by highest page first
-    page = pageFound - page;
-    if(scanAllocation){
-        if(!ReadIndexTXIDs(assetTuple, page, vecTX)){
-            LogPrint(BCLog::PDAY, "ScanAssetIndex: failed, cannot read TXIDs of allocation\n");
+        if(!g_assetindex->ReadIndexTXIDs(assetTuple, page, vecTX)){
+            LogPrint(BCLog::PDAY, "ScanAssetIndex: failed, page %d is past the oldest page of the allocation\n", page);
             return false;
         }
     }
     else{
-        if(!ReadIndexTXIDs(nAsset, page, vecTX)){
-            LogPrint(BCLog::PDAY, "ScanAssetIndex: failed, cannot read TXIDs of asset\n");
+        if(!g_assetindex->ReadIndexTXIDs(nAsset, page, vecTX)){
+            LogPrint(BCLog::PDAY, "ScanAssetIndex: failed, page %d is past the oldest page of the asset\n", page);
             return false;
         }
     }
     for(const uint256& txid: vecTX){
         UniValue oObj(UniValue::VOBJ);
-        if(!ReadPayload(txid, oObj))
+        if(!g_assetindex->ReadPayload(txid, oObj))
             continue;
            
         oRes.push_back(oObj);
@@ -866,16 +896,4 @@ bool CAssetIndexDB::ScanAssetIndex(int64_t page, const UniValue& oOptions, UniVa
     
     return true;
 }
-bool CAssetIndexDB::FlushErase(const std::vector<uint256> &vecTXIDs){
-    if(vecTXIDs.empty() || !fAssetIndex)
-        return true;
-
-    CDBBatch batch(*this);
-    for (const uint256 &txid : vecTXIDs) {
-        // erase payload
-        batch.Erase(txid);
-    }
-    LogPrint(BCLog::PDAY, "Flushing %d asset index removals\n", vecTXIDs.size());
-    return WriteBatch(batch);
-}
 
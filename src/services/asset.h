@@ -11,6 +11,7 @@
 #include <serialize.h>
 #include <primitives/transaction.h>
 #include <services/assetallocation.h>
+#include <services/assetcache.h>
 #include <sys/types.h>
 #include <univalue.h>
 #ifdef ENABLE_WALLET
@@ -70,6 +71,7 @@ int GeneratePaydayCoinGuid();
 
 bool AssetTxToJSON(const CTransaction& tx, UniValue &entry);
 bool AssetTxToJSON(const CTransaction& tx, const int& nHeight, const uint256& blockhash, UniValue &entry);
+bool AssetTxToJSON(const int& nTxVersion, const uint256& txid, const CAsset& asset, const int& nHeight, const uint256& blockhash, UniValue &entry);
 std::string assetFromTx(const int &nVersion);
 enum {
     ASSET_UPDATE_ADMIN=1, // god mode flag, governs flags field below
@@ -195,146 +197,118 @@ public:
     void Serialize(std::vector<unsigned char>& vchData);
 };
 typedef std::unordered_map<int, CAsset > AssetMap;
+struct CAssetCacheTraits {
+    static bool IsErased(const CAsset& asset) { return asset.IsNull(); }
+    static void Copy(const CAsset& from, CAsset& to);
+    static size_t DynamicUsage(const CAsset& asset);
+};
 class CAssetDB : public CDBWrapper {
+private:
+    CServiceRecordCache<int, CAsset, CAssetCacheTraits> cache;
 public:
     CAssetDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "assets", nCacheSize, fMemory, fWipe) {}
     bool EraseAsset(const uint32_t& nAsset) {
-        return Erase(nAsset);
+        return Erase(std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(nAsset, CWitnessAddress())));
     }   
-    bool ReadAsset(const uint32_t& nAsset, CAsset& asset) {
-        return Read(nAsset, asset);
-    } 
-    bool ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids){
-        return Read(address, assetGuids);
+    bool ReadAsset(const uint32_t& nAsset, CAsset& asset);
+    void WriteCache(AssetMap &mapAssets) {
+        cache.Write(mapAssets);
     }
-     bool ExistsAssetsByAddress(const CWitnessAddress &address){
-        return Exists(address);
-    }   
-	void WriteAssetIndex(const CTransaction& tx, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash);
-	bool ScanAssets(const int count, const int from, const UniValue& oOptions, UniValue& oRes);
-    bool Flush(const AssetMap &mapAssets);
-};
-static std::string assetindexpage = std::string("assetindexpage");
-static std::string assetallocationindexpage = std::string("assetallocationindexpage");
-class CAssetIndexDB : public CDBWrapper {
-public:
-    CAssetIndexDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "assetindex", nCacheSize, fMemory, fWipe) {
+    void GetDirtyCache(AssetMap &mapAssets) {
+        cache.GetDirty(mapAssets);
     }
-    bool ReadIndexTXIDs(const CAssetAllocationTuple& allocationTuple, const int64_t &page, std::vector<uint256> &TXIDS) {
-        return Read(std::make_pair(allocationTuple.ToString(), page), TXIDS);
+    void EndFlushCache(const bool fWritten) {
+        cache.EndFlush(fWritten);
     }
-    bool WriteIndexTXIDs(const CAssetAllocationTuple& allocationTuple, const int64_t &page, const std::vector<uint256> &TXIDS) {
-        return Write(std::make_pair(allocationTuple.ToString(), page), TXIDS);
+    size_t DynamicMemoryUsage() const {
+        return cache.DynamicMemoryUsage();
     }
-    bool ReadIndexTXIDs(const uint32_t &assetGuid, const int64_t &page, std::vector<uint256> &TXIDS){
-        return Read(std::make_pair(assetGuid, page), TXIDS);
+    bool ReadBestBlock(uint256 &hashBlock) {
+        return Read(DB_ASSET_BEST_BLOCK, hashBlock);
     }
-    bool WriteIndexTXIDs(const uint32_t &assetGuid, const int64_t &page, const std::vector<uint256> &TXIDS) {
-        return Write(std::make_pair(assetGuid, page), TXIDS);
-    }
-   bool EraseIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256 &txid) {
-        int64_t page=0;
-        std::vector<uint256> TXIDS;
-        if(!ReadAssetAllocationPage(page))
-            return false;
-        int64_t walkBackPage = page;
-        while(walkBackPage >= 0){
-            if(!ReadIndexTXIDs(allocationTuple, walkBackPage, TXIDS)){
-                walkBackPage--;
-                continue;
-            }
-            if(TXIDS.empty()){
-                Erase(std::make_pair(allocationTuple.ToString(), walkBackPage));
-                walkBackPage--;
-                continue;
-            }
-            std::vector<uint256>::iterator it = std::find(TXIDS.begin(), TXIDS.end(), txid);
-            if(it == TXIDS.end()){
-                walkBackPage--;
-                continue;
-            }
-            TXIDS.erase(it);
-            break;
+    /** Guids owned by address, the owner index of the db with the assets changed since the last flush applied */
+    bool ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids);
+    bool ExistsAssetsByAddress(const CWitnessAddress &address){
+        std::vector<uint32_t> assetGuids;
+        return ReadAssetsByAddress(address, assetGuids);
+    }   
+	void NotifyAssetUpdate(const CTransaction& tx, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash);
+	bool ScanAssets(const int count, const int from, const UniValue& oOptions, UniValue& oRes);
+    /** Write the assets in one batch, a non-null hashBestBlock is recorded as the block the asset dbs are complete up to */
+    bool Flush(const AssetMap &mapAssets, const bool fSync = false, const uint256 &hashBestBlock = uint256());
+};
+/**
+ * Asset index record of a transaction: the decoded service object with its block position. It is written when the
+ * block is connected and only rendered to JSON when listassetindex reads it back.
+ */
+class CAssetIndexTxRecord {
+public:
+    static const unsigned char CURRENT_VERSION = 1;
+    int32_t nTxVersion;
+    int nHeight;
+    uint256 blockhash;
+    // asset transactions other than asset sends
+    CAsset asset;
+    // allocation transactions and asset sends, burns also carry the ethereum destination
+    CAssetAllocation assetAllocation;
+    std::vector<unsigned char> vchEthAddress;
+    // mints, paydaycoin mints also carry the minted output
+    CMintPaydayCoin mintPaydayCoin;
+    CTxOut txOutMint;
+
+    CAssetIndexTxRecord() : nTxVersion(0), nHeight(0) {}
+    bool FromAssetTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn);
+    bool FromAssetAllocationTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn);
+    bool FromMintTx(const CTransaction& tx, const int& nHeightIn, const uint256& blockhashIn);
+    bool ToJSON(const uint256& txid, UniValue& entry) const;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        s << CURRENT_VERSION << nTxVersion << VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED) << blockhash;
+        if (IsPaydayCoinMintTx(nTxVersion)) {
+            s << mintPaydayCoin;
+            if (nTxVersion == PAYDAYCOIN_TX_VERSION_MINT)
+                s << txOutMint;
         }
-        if(walkBackPage < 0)
-            return false;
-        if(TXIDS.empty() && walkBackPage == page){
-            bool res = Erase(std::make_pair(allocationTuple.ToString(), page));
-            if(page <= 0)
-                return res;
-            page--;
-            return res && WriteAssetAllocationPage(page);
+        else if (IsAssetTx(nTxVersion) && nTxVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+            s << asset;
+        else {
+            s << assetAllocation;
+            if (nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN)
+                s << vchEthAddress;
         }
-        return Write(std::make_pair(allocationTuple.ToString(), page), TXIDS);
-    }    
-    bool EraseIndexTXID(const uint32_t &assetGuid, const uint256 &txid) {
-        int64_t page=0;
-        std::vector<uint256> TXIDS;
-        if(!ReadAssetPage(page))
-            return false;
-        int64_t walkBackPage = page;
-        while(walkBackPage >= 0){
-            if(!ReadIndexTXIDs(assetGuid, walkBackPage, TXIDS)){
-                walkBackPage--;
-                continue;
-            }
-            if(TXIDS.empty()){
-                Erase(std::make_pair(assetGuid, walkBackPage));
-                walkBackPage--;
-                continue;
-            }            
-            std::vector<uint256>::iterator it = std::find(TXIDS.begin(), TXIDS.end(), txid);
-            if(it == TXIDS.end()){
-                walkBackPage--;
-                continue;
-            }
-            TXIDS.erase(it);
-            break;
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        unsigned char nVersion;
+        s >> nVersion;
+        if (nVersion != CURRENT_VERSION)
+            throw std::ios_base::failure("CAssetIndexTxRecord: unknown version");
+        s >> nTxVersion >> VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED) >> blockhash;
+        if (IsPaydayCoinMintTx(nTxVersion)) {
+            s >> mintPaydayCoin;
+            if (nTxVersion == PAYDAYCOIN_TX_VERSION_MINT)
+                s >> txOutMint;
         }
-        if(walkBackPage < 0)
-            return false;
-        if(TXIDS.empty() && walkBackPage == page){
-            bool res = Erase(std::make_pair(assetGuid, page));
-            if(page <= 0)
-                return res;
-            page--;
-            return res && WriteAssetPage(page);
+        else if (IsAssetTx(nTxVersion) && nTxVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+            s >> asset;
+        else {
+            s >> assetAllocation;
+            if (nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN)
+                s >> vchEthAddress;
         }
-        return Write(std::make_pair(assetGuid, page), TXIDS);
-    }    
-    bool ReadAssetPage(int64_t& page) {
-        return Read(assetindexpage, page);
-    }
-    bool WriteAssetPage(const int64_t &page) {
-        return Write(assetindexpage, page);
-    }
-    bool ReadAssetAllocationPage(int64_t& page) {
-        return Read(assetallocationindexpage, page);
-    }
-    bool WriteAssetAllocationPage(const int64_t &page) {
-        return Write(assetallocationindexpage, page);
-    }
-    bool WritePayload(const uint256& txid, const UniValue& payload) {
-        return Write(txid, payload.write());
     }
-    bool ReadPayload(const uint256& txid, UniValue& payload) {
-        std::string strPayload;
-        bool res = Read(txid, strPayload);
-        return res && payload.read(strPayload);
-    }        
-    bool ScanAssetIndex(int64_t page, const UniValue& oOptions, UniValue& oRes);
-    bool FlushErase(const std::vector<uint256> &vecTXIDs);
 };
-static CAsset emptyAsset;
 bool GetAsset(const int &nAsset,CAsset& txPos);
 bool BuildAssetJson(const CAsset& asset, UniValue& oName);
 #ifdef ENABLE_WALLET
 bool DecodePaydayCoinRawtransaction(const CTransaction& rawTx, UniValue& output, CWallet* const pwallet, const isminefilter* filter_ismine);
 #endif
 bool DecodePaydayCoinRawtransaction(const CTransaction& rawTx, UniValue& output);
-void WriteAssetIndexTXID(const uint32_t& nAsset, const uint256& txid);
+bool ScanAssetIndex(int64_t page, const UniValue& oOptions, UniValue& oRes);
+/** Witness address of a segwit address, or of the P2WPKH equivalent of a P2PKH address */
+bool WitnessAddressFromString(const std::string& strAddress, CWitnessAddress& witnessAddress);
 extern std::unique_ptr<CAssetDB> passetdb;
 extern std::unique_ptr<CAssetAllocationDB> passetallocationdb;
 extern std::unique_ptr<CAssetAllocationMempoolDB> passetallocationmempooldb;
-extern std::unique_ptr<CAssetIndexDB> passetindexdb;
 #endif // PAYDAYCOIN_SERVICES_ASSET_H
@@ -4,6 +4,7 @@
 
 #include <validation.h>
 #include <boost/thread.hpp>
+#include <set>
 #include <boost/algorithm/string.hpp>
 #include <future>
 #include <validationinterface.h>
@@ -16,15 +17,194 @@
 extern std::string EncodeDestination(const CTxDestination& dest);
 extern CTxDestination DecodeDestination(const std::string& str);
 extern UniValue ValueFromAmount(const CAmount& amount);
-extern UniValue DescribeAddress(const CTxDestination& dest);
 extern void ScriptPubKeyToUniv(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
-extern UniValue convertaddress(const JSONRPCRequest& request);
-CCriticalSection cs_assetallocation;
-CCriticalSection cs_assetallocationarrival;
 using namespace std;
-AssetBalanceMap mempoolMapAssetBalances GUARDED_BY(cs_assetallocation);
-ArrivalTimesMapImpl arrivalTimesMap GUARDED_BY(cs_assetallocationarrival);
-std::unordered_set<std::string> assetAllocationConflicts;
+CZDAGState zdagState;
+const unsigned int CAssetAllocationTupleKey::MAX_PROGRAM_SIZE;
+const unsigned char CAssetAllocationTupleKey::HASHED_PROGRAM;
+CAssetAllocationTupleKey::CAssetAllocationTupleKey(const CAssetAllocationTuple& assetAllocationTuple) {
+    SetNull();
+    nAsset = assetAllocationTuple.nAsset;
+    nVersion = assetAllocationTuple.witnessAddress.nVersion;
+    const std::vector<unsigned char> &vchWitnessProgram = assetAllocationTuple.witnessAddress.vchWitnessProgram;
+    if (vchWitnessProgram.size() <= MAX_PROGRAM_SIZE) {
+        nProgramSize = vchWitnessProgram.size();
+        if (!vchWitnessProgram.empty())
+            memcpy(vchProgram, vchWitnessProgram.data(), nProgramSize);
+    }
+    else {
+        nProgramSize = HASHED_PROGRAM;
+        CSHA256().Write(vchWitnessProgram.data(), vchWitnessProgram.size()).Finalize(vchProgram);
+    }
+}
+CAssetAllocationTuple CAssetAllocationTupleKey::ToTuple() const {
+    return CAssetAllocationTuple(nAsset, CWitnessAddress(nVersion, std::vector<unsigned char>(vchProgram, vchProgram + ProgramLength())));
+}
+string CAssetAllocationTupleKey::ToString() const {
+    return ToTuple().ToString();
+}
+CAmount CZDAGSenderIndex::PrefixSum(size_t nCount) const {
+    CAmount nSum = 0;
+    for (size_t i = nCount; i > 0; i &= i - 1)
+        nSum += vecTree[i];
+    return nSum;
+}
+void CZDAGSenderIndex::Rebuild() {
+    std::vector<CArrival> vecLive;
+    vecLive.reserve(vecArrivals.size() - nRemoved);
+    for (const CArrival& arrival : vecArrivals) {
+        if (!arrival.fRemoved)
+            vecLive.push_back(arrival);
+    }
+    std::stable_sort(vecLive.begin(), vecLive.end(), [](const CArrival& a, const CArrival& b) { return a.nArrivalTime < b.nArrivalTime; });
+    vecArrivals.swap(vecLive);
+    nRemoved = 0;
+    mapPositions.clear();
+    vecTree.assign(vecArrivals.size() + 1, 0);
+    for (size_t i = 1; i <= vecArrivals.size(); i++) {
+        mapPositions.emplace(vecArrivals[i - 1].txHash, i - 1);
+        vecTree[i] += vecArrivals[i - 1].nAmount;
+        const size_t nParent = i + (i & (~i + 1));
+        if (nParent <= vecArrivals.size())
+            vecTree[nParent] += vecTree[i];
+    }
+}
+void CZDAGSenderIndex::Add(const uint256& txHash, const int64_t& nArrivalTime, const CAmount& nAmount) {
+    Remove(txHash);
+    mapPositions.emplace(txHash, vecArrivals.size());
+    vecArrivals.push_back(CArrival{nArrivalTime, txHash, nAmount, false});
+    nTotal += nAmount;
+    // arrivals are stamped with the local clock so they almost always append, only resort if the clock went back
+    if (vecArrivals.size() > 1 && nArrivalTime < vecArrivals[vecArrivals.size() - 2].nArrivalTime) {
+        Rebuild();
+        return;
+    }
+    // the new node covers the nLow lowest positions ending at itself
+    const size_t i = vecArrivals.size();
+    const size_t nLow = i & (~i + 1);
+    if (vecTree.empty())
+        vecTree.push_back(0);
+    vecTree.push_back(nAmount + PrefixSum(i - 1) - PrefixSum(i - nLow));
+}
+void CZDAGSenderIndex::Remove(const uint256& txHash) {
+    auto it = mapPositions.find(txHash);
+    if (it == mapPositions.end())
+        return;
+    CArrival& arrival = vecArrivals[it->second];
+    for (size_t i = it->second + 1; i < vecTree.size(); i += i & (~i + 1))
+        vecTree[i] -= arrival.nAmount;
+    nTotal -= arrival.nAmount;
+    arrival.fRemoved = true;
+    mapPositions.erase(it);
+    nRemoved++;
+    if (nRemoved > 16 && nRemoved > mapPositions.size())
+        Rebuild();
+}
+void CZDAGSenderIndex::clear() {
+    vecArrivals.clear();
+    vecTree.clear();
+    mapPositions.clear();
+    nTotal = 0;
+    nRemoved = 0;
+}
+bool CZDAGSenderIndex::GetSentUntil(const uint256& txHash, int64_t& nArrivalTime, CAmount& nSent) const {
+    auto it = mapPositions.find(txHash);
+    if (it == mapPositions.end())
+        return false;
+    nArrivalTime = vecArrivals[it->second].nArrivalTime;
+    nSent = PrefixSum(it->second + 1);
+    return true;
+}
+bool CZDAGSenderIndex::GetLastArrivalTime(int64_t& nArrivalTime) const {
+    for (auto it = vecArrivals.rbegin(); it != vecArrivals.rend(); ++it) {
+        if (!it->fRemoved) {
+            nArrivalTime = it->nArrivalTime;
+            return true;
+        }
+    }
+    return false;
+}
+CZDAGSenderRecord CZDAGShard::GetSenderRecord(const CAssetAllocationTupleKey& senderTupleKey) const {
+    CZDAGSenderRecord record;
+    auto itBalance = mapBalances.find(senderTupleKey);
+    if (itBalance != mapBalances.end()) {
+        record.fBalance = true;
+        record.nBalance = itBalance->second;
+    }
+    auto itArrivalTimes = mapArrivalTimes.find(senderTupleKey);
+    if (itArrivalTimes != mapArrivalTimes.end())
+        record.vecArrivalTimes.assign(itArrivalTimes->second.begin(), itArrivalTimes->second.end());
+    return record;
+}
+void CZDAGState::LoadSender(const CAssetAllocationTupleKey& senderTupleKey, CZDAGSenderRecord& record) {
+    CZDAGShard& shard = GetShard(senderTupleKey);
+    LOCK_ZDAG_SHARD(shard);
+    if (record.fBalance)
+        shard.mapBalances[senderTupleKey] = record.nBalance;
+    if (!record.vecArrivalTimes.empty()) {
+        ArrivalTimesMap& arrivalTimes = shard.mapArrivalTimes[senderTupleKey];
+        for (const auto& arrivalTime : record.vecArrivalTimes) {
+            arrivalTimes[arrivalTime.first] = arrivalTime.second;
+            shard.QueueExpiry(senderTupleKey, arrivalTime.first, arrivalTime.second);
+        }
+    }
+}
+void CZDAGState::ClearArrivalTimes() {
+    for (CZDAGShard& shard : shards) {
+        LOCK_ZDAG_SHARD(shard);
+        for (const auto& entry : shard.mapArrivalTimes)
+            shard.MarkDirty(entry.first);
+        shard.mapArrivalTimes.clear();
+        shard.mapSenderIndexes.clear();
+        shard.expiryWheel.clear();
+    }
+}
+bool CZDAGShard::ExpireArrivalTimes(const int64_t& nExpiredBefore, unsigned int nMaxEntries, int& nExpired) {
+    while (!expiryWheel.empty()) {
+        auto itBucket = expiryWheel.begin();
+        // only drain buckets whose every arrival is past the window
+        if ((itBucket->first + 1) * ZDAG_EXPIRY_BUCKET_MILLIS > nExpiredBefore)
+            return false;
+        std::vector<std::pair<CAssetAllocationTupleKey, uint256> >& vecBucket = itBucket->second;
+        while (!vecBucket.empty()) {
+            if (nMaxEntries-- == 0)
+                return true;
+            const CAssetAllocationTupleKey senderTupleKey = vecBucket.back().first;
+            const uint256 txHash = vecBucket.back().second;
+            vecBucket.pop_back();
+            auto arrivalTimes = mapArrivalTimes.find(senderTupleKey);
+            if (arrivalTimes == mapArrivalTimes.end())
+                continue;
+            auto arrivalTime = arrivalTimes->second.find(txHash);
+            if (arrivalTime == arrivalTimes->second.end() || arrivalTime->second >= nExpiredBefore)
+                continue;
+            arrivalTimes->second.erase(arrivalTime);
+            MarkDirty(senderTupleKey);
+            nExpired++;
+            if (arrivalTimes->second.empty()) {
+                mapArrivalTimes.erase(arrivalTimes);
+                mapSenderIndexes.erase(senderTupleKey);
+                mapBalances.erase(senderTupleKey);
+                setConflicts.erase(senderTupleKey);
+            }
+            else {
+                auto senderIndex = mapSenderIndexes.find(senderTupleKey);
+                if (senderIndex != mapSenderIndexes.end())
+                    senderIndex->second.Remove(txHash);
+            }
+        }
+        expiryWheel.erase(itBucket);
+    }
+    return false;
+}
+void CZDAGState::GetLockStats(uint64_t& nLocks, uint64_t& nLocksContended) const {
+    nLocks = nLocksContended = 0;
+    for (const CZDAGShard& shard : shards) {
+        nLocks += shard.nLocks;
+        nLocksContended += shard.nLocksContended;
+    }
+}
+SaltedAssetAllocationTupleKeyHasher::SaltedAssetAllocationTupleKeyHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 string CWitnessAddress::ToString() const {
     if (vchWitnessProgram.size() <= 4 && stringFromVch(vchWitnessProgram) == "burn")
         return "burn";
@@ -152,99 +332,34 @@ void CAssetAllocation::Serialize( vector<unsigned char> &vchData) {
 	vchData = vector<unsigned char>(dsAsset.begin(), dsAsset.end());
 
 }
-void CAssetAllocationDB::WriteMintIndex(const CTransaction& tx, const CMintPaydayCoin& mintPaydayCoin, const int &nHeight, const uint256& blockhash){
-    if (fZMQAssetAllocation || fAssetIndex) {
+void CAssetAllocationDB::NotifyMintUpdate(const CTransaction& tx, const CMintPaydayCoin& mintPaydayCoin, const int &nHeight, const uint256& blockhash){
+    if (fZMQAssetAllocation) {
         if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(),fAssetIndexGuids.end(), mintPaydayCoin.assetAllocationTuple.nAsset) == fAssetIndexGuids.end()){
-            LogPrint(BCLog::PDAY, "Asset allocation cannot be indexed because it is not set in -assetindexguids list\n");
+            LogPrint(BCLog::PDAY, "Asset allocation update is not notified because it is not set in -assetindexguids list\n");
             return;
         }
-        UniValue output(UniValue::VOBJ);
-        if(AssetMintTxToJson(tx, mintPaydayCoin, nHeight, blockhash, output)){
-            if(fZMQAssetAllocation)
+        CAssetIndexTxRecord record;
+        if(record.FromMintTx(tx, nHeight, blockhash)){
+            UniValue output(UniValue::VOBJ);
+            if(record.ToJSON(tx.GetHash(), output))
                 GetMainSignals().NotifyPaydayCoinUpdate(output.write().c_str(), "assetallocation");
-            if(fAssetIndex)
-                WriteAssetIndexForAllocation(mintPaydayCoin, tx.GetHash(), output); 
         }
     }
 }
-void CAssetAllocationDB::WriteAssetAllocationIndex(const CTransaction &tx, const CAsset& dbAsset, const int &nHeight, const uint256& blockhash) {
-	if (fZMQAssetAllocation || fAssetIndex) {
+void CAssetAllocationDB::NotifyAssetAllocationUpdate(const CTransaction &tx, const CAsset& dbAsset, const int &nHeight, const uint256& blockhash) {
+	if (fZMQAssetAllocation) {
         if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(),fAssetIndexGuids.end(),dbAsset.nAsset) == fAssetIndexGuids.end()){
-            LogPrint(BCLog::PDAY, "Asset allocation cannot be indexed because it is not set in -assetindexguids list\n");
+            LogPrint(BCLog::PDAY, "Asset allocation update is not notified because it is not set in -assetindexguids list\n");
             return;
         }
-		UniValue oName(UniValue::VOBJ);
-        CAssetAllocation allocation;
-        if(AssetAllocationTxToJSON(tx, dbAsset, nHeight, blockhash, oName, allocation)){
-            if(fZMQAssetAllocation)
+        CAssetIndexTxRecord record;
+        if(record.FromAssetAllocationTx(tx, nHeight, blockhash) && !dbAsset.IsNull()){
+            UniValue oName(UniValue::VOBJ);
+            if(AssetAllocationTxToJSON(tx.nVersion, tx.GetHash(), record.assetAllocation, record.vchEthAddress, dbAsset, nHeight, blockhash, oName))
                 GetMainSignals().NotifyPaydayCoinUpdate(oName.write().c_str(), "assetallocation");
-            if(fAssetIndex)
-                WriteAssetIndexForAllocation(allocation, tx.GetHash(), oName);          
         }
 	}
 
-}
-void WriteAssetIndexForAllocation(const CAssetAllocation& assetallocation, const uint256& txid, const UniValue& oName){
-    if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(),fAssetIndexGuids.end(), assetallocation.assetAllocationTuple.nAsset) == fAssetIndexGuids.end()){
-        LogPrint(BCLog::PDAY, "Asset allocation cannot be indexed because asset is not set in -assetindexguids list\n");
-        return;
-    }
-    // sender
-    WriteAssetAllocationIndexTXID(assetallocation.assetAllocationTuple, txid);
-    
-    // receivers
-    for (auto& amountTuple : assetallocation.listSendingAllocationAmounts) {
-         WriteAssetAllocationIndexTXID(CAssetAllocationTuple(assetallocation.assetAllocationTuple.nAsset, amountTuple.first), txid);
-    }
-    // index into the asset as well     
-    WriteAssetIndexTXID(assetallocation.assetAllocationTuple.nAsset, txid);
-         
-    // write payload only once for txid
-    if(!passetindexdb->WritePayload(txid, oName))
-        LogPrint(BCLog::PDAY, "Failed to write asset index payload\n");        
-    
-}
-void WriteAssetIndexForAllocation(const CMintPaydayCoin& mintPaydayCoin, const uint256& txid, const UniValue& oName){
-    const CAssetAllocationTuple senderAllocationTuple(mintPaydayCoin.assetAllocationTuple.nAsset, CWitnessAddress(0, vchFromString("burn")));
-    if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(),fAssetIndexGuids.end(), senderAllocationTuple.nAsset) == fAssetIndexGuids.end()){
-        LogPrint(BCLog::PDAY, "Mint Asset allocation cannot be indexed because asset is not set in -assetindexguids list\n");
-        return;
-    }
-     // sender
-    WriteAssetAllocationIndexTXID(senderAllocationTuple, txid);
-      
-    // receiver
-    WriteAssetAllocationIndexTXID(mintPaydayCoin.assetAllocationTuple, txid);
-    
-    // index into the asset as well     
-    WriteAssetIndexTXID(mintPaydayCoin.assetAllocationTuple.nAsset, txid);
-    
-    if(!passetindexdb->WritePayload(txid, oName))
-        LogPrint(BCLog::PDAY, "Failed to write asset index payload\n");        
-
-}
-void WriteAssetAllocationIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid){
-    // index the allocation
-    int64_t page;
-    if(!passetindexdb->ReadAssetAllocationPage(page)){
-        page = 0;
-        if(!passetindexdb->WriteAssetAllocationPage(page))
-            LogPrint(BCLog::PDAY, "Failed to write asset allocation page\n");           
-    }
-   
-    std::vector<uint256> TXIDS;
-    passetindexdb->ReadIndexTXIDs(allocationTuple, page, TXIDS);
-    // new page needed
-    if(((int)TXIDS.size()) >= fAssetIndexPageSize){
-        TXIDS.clear();
-        page++;
-        if(!passetindexdb->WriteAssetAllocationPage(page))
-            LogPrint(BCLog::PDAY, "Failed to write asset allocation page\n");        
-    }
-    TXIDS.push_back(txid);
-    if(!passetindexdb->WriteIndexTXIDs(allocationTuple, page, TXIDS))
-        LogPrint(BCLog::PDAY, "Failed to write asset allocation index txids\n");
-        
 }
 bool GetAssetAllocation(const CAssetAllocationTuple &assetAllocationTuple, CAssetAllocation& txPos) {
     if (passetallocationdb == nullptr || !passetallocationdb->ReadAssetAllocation(assetAllocationTuple, txPos))
@@ -257,9 +372,11 @@ bool BuildAssetAllocationJson(const CAssetAllocation& assetallocation, const CAs
     CAmount nBalanceZDAG = assetallocation.nBalance;
     const string &allocationTupleStr = assetallocation.assetAllocationTuple.ToString();
     {
-        LOCK(cs_assetallocation);
-        AssetBalanceMap::iterator mapIt =  mempoolMapAssetBalances.find(allocationTupleStr);
-        if(mapIt != mempoolMapAssetBalances.end())
+        const CAssetAllocationTupleKey allocationTupleKey(assetallocation.assetAllocationTuple);
+        CZDAGShard& shard = zdagState.GetShard(allocationTupleKey);
+        LOCK_ZDAG_SHARD(shard);
+        AssetBalanceMap::iterator mapIt =  shard.mapBalances.find(allocationTupleKey);
+        if(mapIt != shard.mapBalances.end())
             nBalanceZDAG = mapIt->second;
     }
     oAssetAllocation.__pushKV("asset_allocation", allocationTupleStr);
@@ -407,14 +524,17 @@ bool AssetAllocationTxToJSON(const CTransaction &tx, const CAsset& dbAsset, cons
     }
     else
         assetallocation = CAssetAllocation(tx);
-
+    return AssetAllocationTxToJSON(tx.nVersion, tx.GetHash(), assetallocation, vchEthAddress, dbAsset, nHeight, blockhash, entry);
+}
+bool AssetAllocationTxToJSON(const int& nTxVersion, const uint256& txid, const CAssetAllocation& assetallocation, const std::vector<unsigned char>& vchEthAddress, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash, UniValue &entry)
+{
     if(assetallocation.assetAllocationTuple.IsNull() || dbAsset.IsNull())
         return false;
-    entry.__pushKV("txtype", assetAllocationFromTx(tx.nVersion));
+    entry.__pushKV("txtype", assetAllocationFromTx(nTxVersion));
     entry.__pushKV("asset_allocation", assetallocation.assetAllocationTuple.ToString());
     entry.__pushKV("asset_guid", (int)assetallocation.assetAllocationTuple.nAsset);
     entry.__pushKV("symbol", dbAsset.strSymbol);
-    entry.__pushKV("txid", tx.GetHash().GetHex());
+    entry.__pushKV("txid", txid.GetHex());
     entry.__pushKV("height", nHeight);
     entry.__pushKV("sender", assetallocation.assetAllocationTuple.witnessAddress.ToString());
     UniValue oAssetAllocationReceiversArray(UniValue::VARR);
@@ -433,7 +553,7 @@ bool AssetAllocationTxToJSON(const CTransaction &tx, const CAsset& dbAsset, cons
     entry.__pushKV("allocations", oAssetAllocationReceiversArray);
     entry.__pushKV("total", ValueFromAssetAmount(nTotal, dbAsset.nPrecision));
     entry.__pushKV("blockhash", blockhash.GetHex()); 
-    if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN)
+    if(nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN)
          entry.__pushKV("ethereum_destination", "0x" + HexStr(vchEthAddress));
     return true;
 }
@@ -497,11 +617,16 @@ bool AssetMintTxToJson(const CTransaction& tx, UniValue &entry){
     return false;
 }
 bool AssetMintTxToJson(const CTransaction& tx, const CMintPaydayCoin& mintpaydaycoin, const int& nHeight, const uint256& blockhash, UniValue &entry){
-    if (!mintpaydaycoin.IsNull() && ((tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT && !mintpaydaycoin.assetAllocationTuple.IsNull()) || tx.nVersion == PAYDAYCOIN_TX_VERSION_MINT)) {
-        entry.__pushKV("txtype", tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT? "assetallocationmint": "paydaycoinmint");
-        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT)
+    if(tx.vout.empty())
+        return false;
+    return AssetMintTxToJson(tx.nVersion, tx.GetHash(), mintpaydaycoin, tx.vout[0], nHeight, blockhash, entry);
+}
+bool AssetMintTxToJson(const int& nTxVersion, const uint256& txid, const CMintPaydayCoin& mintpaydaycoin, const CTxOut& txOutMint, const int& nHeight, const uint256& blockhash, UniValue &entry){
+    if (!mintpaydaycoin.IsNull() && ((nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT && !mintpaydaycoin.assetAllocationTuple.IsNull()) || nTxVersion == PAYDAYCOIN_TX_VERSION_MINT)) {
+        entry.__pushKV("txtype", nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT? "assetallocationmint": "paydaycoinmint");
+        if(nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT)
             entry.__pushKV("asset_allocation", mintpaydaycoin.assetAllocationTuple.ToString());
-        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT){
+        if(nTxVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT){
             CAsset dbAsset;
             GetAsset(mintpaydaycoin.assetAllocationTuple.nAsset, dbAsset);
             entry.__pushKV("asset_guid", (int)mintpaydaycoin.assetAllocationTuple.nAsset);
@@ -519,11 +644,11 @@ bool AssetMintTxToJson(const CTransaction& tx, const CMintPaydayCoin& mintpayday
         }
         else{
             UniValue o(UniValue::VOBJ);
-            ScriptPubKeyToUniv(tx.vout[0].scriptPubKey, o, true);
+            ScriptPubKeyToUniv(txOutMint.scriptPubKey, o, true);
             entry.__pushKV("scriptPubKey", o);
-            entry.__pushKV("total", ValueFromAmount(tx.vout[0].nValue));
+            entry.__pushKV("total", ValueFromAmount(txOutMint.nValue));
         }
-        entry.__pushKV("txid", tx.GetHash().GetHex());
+        entry.__pushKV("txid", txid.GetHex());
         entry.__pushKV("height", nHeight);
         entry.__pushKV("blockhash", blockhash.GetHex());
         UniValue oSPVProofObj(UniValue::VOBJ);
@@ -541,6 +666,61 @@ bool AssetMintTxToJson(const CTransaction& tx, const CMintPaydayCoin& mintpayday
     return false;                   
 }
 
+bool CAssetAllocationMempoolDB::FlushZDAGState(CZDAGState& state) {
+    int nWritten = 0, nErased = 0;
+    for (unsigned int nShard = 0; nShard < ZDAG_SHARDS; nShard++) {
+        CZDAGShard& shard = state.GetShard(nShard);
+        CDBBatch batch(*this);
+        {
+            LOCK_ZDAG_SHARD(shard);
+            for (const auto& entry : shard.setDirty) {
+                const CZDAGSenderRecord& record = shard.GetSenderRecord(entry.first);
+                if (record.IsNull()) {
+                    batch.Erase(std::make_pair(std::string("zdagsender"), entry.first));
+                    nErased++;
+                }
+                else {
+                    batch.Write(std::make_pair(std::string("zdagsender"), entry.first), record);
+                    nWritten++;
+                }
+            }
+            shard.setDirty.clear();
+        }
+        if (!WriteBatch(batch, true))
+            return false;
+    }
+    LogPrintf("Flushing Asset Allocation Mempool senders...%d written %d erased\n", nWritten, nErased);
+    return true;
+}
+bool CAssetAllocationMempoolDB::LoadZDAGState(CZDAGState& state) {
+    // whole map snapshots written by older versions are not read back, ZDAG state is rebuilt as transactions arrive
+    if (Exists(std::string("assetallocationtxbalance")) || Exists(std::string("assetallocationtxbalancekey"))) {
+        CDBBatch batch(*this);
+        batch.Erase(std::string("assetallocationtxbalance"));
+        batch.Erase(std::string("assetallocationtxarrival"));
+        batch.Erase(std::string("assetallocationtxbalancekey"));
+        batch.Erase(std::string("assetallocationtxarrivalkey"));
+        if (!WriteBatch(batch, true))
+            return false;
+    }
+    int nLoaded = 0;
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::string("zdagsender"));
+    std::pair<std::string, CAssetAllocationTupleKey> key;
+    CZDAGSenderRecord record;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        if (!pcursor->GetKey(key) || key.first != "zdagsender")
+            break;
+        if (!pcursor->GetValue(record))
+            return error("LoadZDAGState: unable to read sender %s", key.second.ToString());
+        state.LoadSender(key.second, record);
+        nLoaded++;
+        pcursor->Next();
+    }
+    LogPrintf("Loaded %d Asset Allocation Mempool senders\n", nLoaded);
+    return true;
+}
 bool CAssetAllocationMempoolDB::ScanAssetAllocationMempoolBalances(const int count, const int from, const UniValue& oOptions, UniValue& oRes) {
     string strTxid = "";
     vector<string> vecSenders;
@@ -561,18 +741,19 @@ bool CAssetAllocationMempoolDB::ScanAssetAllocationMempoolBalances(const int cou
         }
     }
     int index = 0;
-    {
-        LOCK(cs_assetallocation);
-        for (auto&indexObj : mempoolMapAssetBalances) {
-            
-            if (!vecSenders.empty() && std::find(vecSenders.begin(), vecSenders.end(), indexObj.first) == vecSenders.end())
+    for (unsigned int nShard = 0; nShard < ZDAG_SHARDS && index < count + from; nShard++) {
+        CZDAGShard& shard = zdagState.GetShard(nShard);
+        LOCK_ZDAG_SHARD(shard);
+        for (auto&indexObj : shard.mapBalances) {
+            const string &strSenderTuple = indexObj.first.ToString();
+            if (!vecSenders.empty() && std::find(vecSenders.begin(), vecSenders.end(), strSenderTuple) == vecSenders.end())
                 continue;
             index += 1;
             if (index <= from) {
                 continue;
             }
             UniValue resultObj(UniValue::VOBJ);
-            resultObj.__pushKV(indexObj.first, ValueFromAmount(indexObj.second));
+            resultObj.__pushKV(strSenderTuple, ValueFromAmount(indexObj.second));
             oRes.push_back(resultObj);
             if (index >= count + from)
                 break;
@@ -581,75 +762,96 @@ bool CAssetAllocationMempoolDB::ScanAssetAllocationMempoolBalances(const int cou
     return true;
 }
 
-bool CAssetAllocationDB::Flush(const AssetAllocationMap &mapAssetAllocations){
+void CAssetAllocationCacheTraits::Copy(const CAssetAllocation& from, CAssetAllocation& to){
+    to.assetAllocationTuple = CAssetAllocationTuple(from.assetAllocationTuple.nAsset, from.assetAllocationTuple.witnessAddress);
+    to.listSendingAllocationAmounts.clear();
+    to.listSendingAllocationAmounts.reserve(from.listSendingAllocationAmounts.size());
+    for(const auto& amountTuple: from.listSendingAllocationAmounts)
+        to.listSendingAllocationAmounts.emplace_back(CWitnessAddress(amountTuple.first.nVersion, amountTuple.first.vchWitnessProgram), amountTuple.second);
+    to.nBalance = from.nBalance;
+    to.lockedOutpoint = from.lockedOutpoint;
+}
+size_t CAssetAllocationCacheTraits::DynamicUsage(const CAssetAllocation& assetallocation){
+    size_t nUsage = memusage::DynamicUsage(assetallocation.assetAllocationTuple.witnessAddress.vchWitnessProgram) + memusage::DynamicUsage(assetallocation.listSendingAllocationAmounts);
+    for(const auto& amountTuple: assetallocation.listSendingAllocationAmounts)
+        nUsage += memusage::DynamicUsage(amountTuple.first.vchWitnessProgram);
+    return nUsage;
+}
+bool CAssetAllocationDB::ReadAssetAllocation(const CAssetAllocationTuple& assetAllocationTuple, CAssetAllocation& assetallocation){
+    const std::string &strTuple = assetAllocationTuple.ToString();
+    uint64_t nGeneration;
+    const int nCached = cache.Get(strTuple, assetallocation, nGeneration);
+    if(nCached >= 0)
+        return nCached == 1;
+    if(!Read(std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(assetAllocationTuple.nAsset, assetAllocationTuple.witnessAddress)), assetallocation)){
+        cache.Add(strTuple, nullptr, nGeneration);
+        return false;
+    }
+    cache.Add(strTuple, &assetallocation, nGeneration);
+    return true;
+}
+bool CheckAssetKeyLayout(CDBWrapper& db){
+    int nVersion = 0;
+    if(db.Read(DB_ASSET_KEY_LAYOUT, nVersion))
+        return nVersion == ASSET_KEY_LAYOUT_VERSION;
+    // records written before the layout was stamped were keyed by the raw guid and tuple
+    if(!db.IsEmpty())
+        return false;
+    return db.Write(DB_ASSET_KEY_LAYOUT, ASSET_KEY_LAYOUT_VERSION);
+}
+bool ReadAssetGuidsByOwner(CDBWrapper& db, const CWitnessAddress& address, std::vector<uint32_t>& assetGuids, const size_t nMax){
+    assetGuids.clear();
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(std::make_pair(DB_ASSET_OWNER, CAssetOwnerKey(address, 0)));
+    std::pair<char, CAssetOwnerKey> key;
+    for (; pcursor->Valid() && assetGuids.size() < nMax; pcursor->Next()) {
+        if(!pcursor->GetKey(key) || key.first != DB_ASSET_OWNER || key.second.witnessAddress != address)
+            break;
+        assetGuids.push_back(key.second.nAsset);
+    }
+    return !assetGuids.empty();
+}
+bool CAssetAllocationDB::ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids){
+    ReadAssetGuidsByOwner(*this, address, assetGuids);
+    // the owner index is written on flush, allocations of the blocks connected since then are only in the cache
+    std::set<uint32_t> setGuids(assetGuids.begin(), assetGuids.end());
+    cache.ForEachDirty([&](const std::string&, const CAssetAllocation& assetallocation) {
+        const CAssetAllocationTuple &tuple = assetallocation.assetAllocationTuple;
+        if (tuple.witnessAddress != address)
+            return;
+        if (assetallocation.nBalance > 0)
+            setGuids.insert(tuple.nAsset);
+        else
+            setGuids.erase(tuple.nAsset);
+    });
+    assetGuids.assign(setGuids.begin(), setGuids.end());
+    return !assetGuids.empty();
+}
+bool CAssetAllocationDB::Flush(const AssetAllocationMap &mapAssetAllocations, const bool fSync){
     if(mapAssetAllocations.empty())
         return true;
     CDBBatch batch(*this);
 	int write = 0;
 	int erase = 0;
-    std::map<std::string, std::vector<uint32_t> > mapGuids;
-    std::vector<uint32_t> emptyVec;
-    if(fAssetIndex){
-        for (const auto &key : mapAssetAllocations) {
-            auto it = mapGuids.emplace(std::piecewise_construct,  std::forward_as_tuple(key.second.assetAllocationTuple.witnessAddress.ToString()),  std::forward_as_tuple(emptyVec));
-            std::vector<uint32_t> &assetGuids = it.first->second;
-            if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), key.second.assetAllocationTuple.nAsset) == fAssetIndexGuids.end())
-                continue;
-            // if wasn't found and was added to the map
-            if(it.second)
-                ReadAssetsByAddress(key.second.assetAllocationTuple.witnessAddress, assetGuids);
-            // erase asset address association
-            if(key.second.nBalance <= 0){
-                auto itVec = std::find(assetGuids.begin(), assetGuids.end(),  key.second.assetAllocationTuple.nAsset);
-                if(itVec != assetGuids.end()){
-                    assetGuids.erase(itVec);  
-                    // ensure we erase only the ones that are actually being cleared
-                    if(assetGuids.empty())
-                        assetGuids.emplace_back(0);
-                }
-            }
-            else{
-                // add asset address association
-                auto itVec = std::find(assetGuids.begin(), assetGuids.end(),  key.second.assetAllocationTuple.nAsset);
-                if(itVec == assetGuids.end()){
-                    // if we had the special erase flag we remove that and add the real guid
-                    if(assetGuids.size() == 1 && assetGuids[0] == 0)
-                        assetGuids.clear();
-                    assetGuids.emplace_back(key.second.assetAllocationTuple.nAsset);
-                }
-            }      
-        }
-    }
     for (const auto &key : mapAssetAllocations) {
+        const CAssetAllocationTuple &tuple = key.second.assetAllocationTuple;
+        const auto recordKey = std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(tuple.nAsset, tuple.witnessAddress));
+        const auto ownerKey = std::make_pair(DB_ASSET_OWNER, CAssetOwnerKey(tuple.witnessAddress, tuple.nAsset));
         if(key.second.nBalance <= 0){
 			erase++;
-            batch.Erase(key.second.assetAllocationTuple);
+            batch.Erase(recordKey);
+            batch.Erase(ownerKey);
         }
         else{
 			write++;
-            batch.Write(key.second.assetAllocationTuple, key.second);
-        }
-        if(fAssetIndex){
-            if(!fAssetIndexGuids.empty() && std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), key.second.assetAllocationTuple.nAsset) == fAssetIndexGuids.end())
-                continue;
-            auto it = mapGuids.find(key.second.assetAllocationTuple.witnessAddress.ToString());
-            if(it == mapGuids.end())
-                continue;
-            const std::vector<uint32_t>& assetGuids = it->second;
-            // check for special clearing flag before batch erase
-            if(assetGuids.size() == 1 && assetGuids[0] == 0)
-                batch.Erase(key.second.assetAllocationTuple.witnessAddress);   
-            else
-                batch.Write(key.second.assetAllocationTuple.witnessAddress, assetGuids); 
-            // we have processed this address so don't process again
-            mapGuids.erase(it);        
+            batch.Write(recordKey, key.second);
+            batch.Write(ownerKey, '\0');
         }
     }
 	LogPrint(BCLog::PDAY, "Flushing %d assets allocations (erased %d, written %d)\n", mapAssetAllocations.size(), erase, write);
-    return WriteBatch(batch);
+    return WriteBatch(batch, fSync);
 }
 bool CAssetAllocationDB::ScanAssetAllocations(const int count, const int from, const UniValue& oOptions, UniValue& oRes) {
-	string strTxid = "";
 	vector<CWitnessAddress> vecWitnessAddresses;
 	uint32_t nAsset = 0;
 	if (!oOptions.isNull()) {
@@ -665,76 +867,103 @@ bool CAssetAllocationDB::ScanAssetAllocations(const int count, const int from, c
 				const UniValue &owner = ownersArray[i].get_obj();
 				const UniValue &ownerStr = find_value(owner, "address");
 				if (ownerStr.isStr()) {
-                    UniValue requestParam(UniValue::VARR);
-                    requestParam.push_back(ownerStr.get_str());
-                    JSONRPCRequest jsonRequest;
-                    jsonRequest.params = requestParam;
-                    const UniValue &convertedAddressValue = convertaddress(jsonRequest);
-                    const std::string & v4address = find_value(convertedAddressValue.get_obj(), "v4address").get_str();
-                    const CTxDestination &dest = DecodeDestination(v4address);                   
-                    UniValue detail = DescribeAddress(dest);
-                    if(find_value(detail.get_obj(), "iswitness").get_bool() == false)
+                    CWitnessAddress witnessAddress;
+                    if(!WitnessAddressFromString(ownerStr.get_str(), witnessAddress))
                         throw runtime_error("PAYDAYCOIN_ASSET_ALLOCATION_RPC_ERROR: ERRCODE: 2501 - " + _("Address must be a segwit based address"));
-                    string witnessProgramHex = find_value(detail.get_obj(), "witness_program").get_str();
-                    unsigned char witnessVersion = (unsigned char)find_value(detail.get_obj(), "witness_version").get_int();
-					vecWitnessAddresses.push_back(CWitnessAddress(witnessVersion, ParseHex(witnessProgramHex)));
+					vecWitnessAddresses.push_back(std::move(witnessAddress));
 				}
 			}
 		}
 	}
-
-	boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
-	pcursor->SeekToFirst();
-	CAssetAllocation txPos;
-    CAssetAllocationTuple key;
 	CAsset theAsset;
 	int index = 0;
+    // false once the page is full
+    auto addAssetAllocation = [&](const CAssetAllocation& txPos) {
+        if (txPos.assetAllocationTuple.IsNull() || !GetAsset(txPos.assetAllocationTuple.nAsset, theAsset))
+            return true;
+        UniValue oAssetAllocation(UniValue::VOBJ);
+        if (!BuildAssetAllocationJson(txPos, theAsset, oAssetAllocation))
+            return true;
+        index += 1;
+        if (index <= from)
+            return true;
+        oRes.push_back(oAssetAllocation);
+        return index < count + from;
+    };
+	CAssetAllocation txPos;
+    // owners are looked up in their owner range, every allocation read is then a point read
+    if (!vecWitnessAddresses.empty()) {
+        std::vector<CAssetRecordKey> vecTuples;
+        for (const CWitnessAddress &witnessAddress : vecWitnessAddresses) {
+            std::vector<uint32_t> vecOwnerGuids;
+            ReadAssetsByAddress(witnessAddress, vecOwnerGuids);
+            for (const uint32_t &nOwnerAsset : vecOwnerGuids) {
+                if (nAsset == 0 || nAsset == nOwnerAsset)
+                    vecTuples.emplace_back(nOwnerAsset, witnessAddress);
+            }
+        }
+        for (const CAssetRecordKey &tupleKey : vecTuples) {
+            if (ReadAssetAllocation(CAssetAllocationTuple(tupleKey.nAsset, tupleKey.witnessAddress), txPos) && !addAssetAllocation(txPos))
+                break;
+        }
+        return true;
+    }
+    // allocations changed by the blocks connected since the last flush are only in the cache, they are merged into the scan in db key order
+    std::map<std::vector<unsigned char>, CAssetAllocation> mapDirty;
+    cache.ForEachDirty([&](const std::string&, const CAssetAllocation& assetallocation) {
+        const CAssetAllocationTuple &tuple = assetallocation.assetAllocationTuple;
+        if (nAsset != 0 && tuple.nAsset != nAsset)
+            return;
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(tuple.nAsset, tuple.witnessAddress));
+        CAssetAllocationCacheTraits::Copy(assetallocation, mapDirty[std::vector<unsigned char>(ssKey.begin(), ssKey.end())]);
+    });
+    auto itDirty = mapDirty.begin();
+    // the allocations of one asset are a contiguous range of the guid prefixed records
+	boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    if (nAsset != 0)
+        pcursor->Seek(std::make_pair(DB_ASSET_RECORD, CAssetRecordKey(nAsset, CWitnessAddress())));
+    else
+        pcursor->Seek(DB_ASSET_RECORD);
+    std::pair<char, CAssetRecordKey> key;
 	while (pcursor->Valid()) {
 		boost::this_thread::interruption_point();
-		try {
-            key.SetNull();
-			if (pcursor->GetKey(key) && !key.IsNull() && (nAsset == 0 || nAsset == key.nAsset)) {
-				pcursor->GetValue(txPos); 
-                if(txPos.assetAllocationTuple.IsNull()){
-                    pcursor->Next();
-                    continue;
-                }      
-				if (!vecWitnessAddresses.empty() && std::find(vecWitnessAddresses.begin(), vecWitnessAddresses.end(), txPos.assetAllocationTuple.witnessAddress) == vecWitnessAddresses.end())
-				{
-					pcursor->Next();
-					continue;
-				}
-                if (!GetAsset(key.nAsset, theAsset))
-                {
-                    pcursor->Next();
-                    continue;
-                } 
-				UniValue oAssetAllocation(UniValue::VOBJ);
-				if (!BuildAssetAllocationJson(txPos, theAsset, oAssetAllocation)) 
-				{
-					pcursor->Next();
-					continue;
-				}
-				index += 1;
-				if (index <= from) {
-					pcursor->Next();
-					continue;
-				}
-				oRes.push_back(oAssetAllocation);
-				if (index >= count + from) {
-					break;
-				}
-			}
-			pcursor->Next();
-		}
-		catch (std::exception &e) {
-			return error("%s() : deserialize error", __PRETTY_FUNCTION__);
-		}
+        if (!pcursor->GetKey(key) || key.first != DB_ASSET_RECORD || (nAsset != 0 && key.second.nAsset != nAsset))
+            break;
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey << key;
+        const std::vector<unsigned char> vchKey(ssKey.begin(), ssKey.end());
+        for (; itDirty != mapDirty.end() && itDirty->first < vchKey; ++itDirty) {
+            if (itDirty->second.nBalance > 0 && !addAssetAllocation(itDirty->second))
+                return true;
+        }
+        // a dirty record replaces the one in the db, emptied allocations are gone from it on flush
+        if (itDirty != mapDirty.end() && itDirty->first == vchKey) {
+            txPos = std::move((itDirty++)->second);
+            if (txPos.nBalance <= 0) {
+                pcursor->Next();
+                continue;
+            }
+        }
+        else if (!pcursor->GetValue(txPos))
+            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+        if (!addAssetAllocation(txPos))
+            return true;
+        pcursor->Next();
 	}
+    for (; itDirty != mapDirty.end(); ++itDirty) {
+        if (itDirty->second.nBalance > 0 && !addAssetAllocation(itDirty->second))
+            break;
+    }
 	return true;
 }
+CAmount GetZDAGSendAmount(const CAssetAllocation& assetallocation) {
+    CAmount nTotal = 0;
+    for (const auto& amountTuple : assetallocation.listSendingAllocationAmounts)
+        nTotal += amountTuple.second;
+    return nTotal;
+}
 int DetectPotentialAssetAllocationSenderConflicts(const CAssetAllocationTuple& assetAllocationTupleSender, const uint256& lookForTxHash) {
-    LOCK(cs_assetallocationarrival);
 	CAssetAllocation dbAssetAllocation;
 	// get last POW asset allocation balance to ensure we use POW balance to check for potential conflicts in mempool (real-time balances).
 	// The idea is that real-time spending amounts can in some cases overrun the POW balance safely whereas in some cases some of the spends are 
@@ -746,66 +975,45 @@ int DetectPotentialAssetAllocationSenderConflicts(const CAssetAllocationTuple& a
 
 	// ensure that this transaction exists in the arrivalTimes DB (which is the running stored lists of all real-time asset allocation sends not in POW)
 	// the arrivalTimes DB is only added to for valid asset allocation sends that happen in real-time and it is removed once there is POW on that transaction
-    const ArrivalTimesMap& arrivalTimes = arrivalTimesMap[assetAllocationTupleSender.ToString()];
-	if(arrivalTimes.empty())
+    const CAssetAllocationTupleKey senderTupleKey(assetAllocationTupleSender);
+    CZDAGShard& shard = zdagState.GetShard(senderTupleKey);
+    LOCK(mempool.cs);
+    LOCK_ZDAG_SHARD(shard);
+    auto itArrivalTimes = shard.mapArrivalTimes.find(senderTupleKey);
+	if(itArrivalTimes == shard.mapArrivalTimes.end() || itArrivalTimes->second.empty())
 		return ZDAG_NOT_FOUND;
-	// sort the arrivalTimesMap ascending based on arrival time value
-
-	// Declaring the type of Predicate for comparing arrivalTimesMap
-	typedef std::function<bool(std::pair<uint256, int64_t>, std::pair<uint256, int64_t>)> Comparator;
-
-	// Defining a lambda function to compare two pairs. It will compare two pairs using second field
-	Comparator compFunctor =
-		[](std::pair<uint256, int64_t> elem1, std::pair<uint256, int64_t> elem2)
-	{
-		return elem1.second < elem2.second;
-	};
-
-	// Declaring a set that will store the pairs using above comparison logic
-	std::set<std::pair<uint256, int64_t>, Comparator> arrivalTimesSet(
-		arrivalTimes.begin(), arrivalTimes.end(), compFunctor);
-
-	// go through arrival times and check that balances don't overrun the POW balance
-	pair<uint256, int64_t> lastArrivalTime;
-	lastArrivalTime.second = GetTimeMillis();
-	unordered_map<string, CAmount> mapBalances;
-	// init sender balance, track balances by address
-	// this is important because asset allocations can be sent/received within blocks and will overrun balances prematurely if not tracked properly, for example pow balance 3, sender sends 3, gets 2 sends 2 (total send 3+2=5 > balance of 3 from last stored state, this is a valid scenario and shouldn't be flagged)
-	CAmount &senderBalance = mapBalances[assetAllocationTupleSender.witnessAddress.ToString()];
-	senderBalance = dbAssetAllocation.nBalance;
+    const ArrivalTimesMap& arrivalTimes = itArrivalTimes->second;
+    // a sender is indexed on first use, later sends are added as they arrive and removed as they leave the mempool.
+    // Arrivals whose transaction is not in the mempool anymore stay in arrivalTimes until they expire but are never indexed
+    auto itSenderIndex = shard.mapSenderIndexes.find(senderTupleKey);
+    if (itSenderIndex == shard.mapSenderIndexes.end()) {
+        itSenderIndex = shard.mapSenderIndexes.emplace(senderTupleKey).first;
+        for (const auto& arrivalTime : arrivalTimes) {
+            const CTransactionRef txRef = mempool.get(arrivalTime.first);
+            if (txRef)
+                itSenderIndex->second.Add(arrivalTime.first, arrivalTime.second, GetZDAGSendAmount(CAssetAllocation(*txRef)));
+        }
+    }
+    const CZDAGSenderIndex& senderIndex = itSenderIndex->second;
 	int minLatency = ZDAG_MINIMUM_LATENCY_SECONDS * 1000;
 	if (fUnitTest)
 		minLatency = 1000;
-	for (auto& arrivalTime : arrivalTimesSet)
-	{
-		// ensure mempool has this transaction and it is not yet mined, get the transaction in question
-		const CTransactionRef txRef = mempool.get(arrivalTime.first);
-		if (!txRef)
-			continue;
-		const CTransaction &tx = *txRef;
-
-		// if this tx arrived within the minimum latency period flag it as potentially conflicting
-		if (abs(arrivalTime.second - lastArrivalTime.second) < minLatency) {
-			return ZDAG_MINOR_CONFLICT;
-		}
-		const uint256& txHash = tx.GetHash();
-		CAssetAllocation assetallocation(tx);
-
-
-		if (!assetallocation.listSendingAllocationAmounts.empty()) {
-			for (auto& amountTuple : assetallocation.listSendingAllocationAmounts) {
-				senderBalance -= amountTuple.second;
-				mapBalances[amountTuple.first.ToString()] += amountTuple.second;
-				// if running balance overruns the stored balance then we have a potential conflict
-				if (senderBalance < 0) {
-					return ZDAG_MINOR_CONFLICT;
-				}
-			}
-		}
-		// even if the sender may be flagged, the order of events suggests that this receiver should get his money confirmed upon pow because real-time balance is sufficient for this receiver
-		if (txHash == lookForTxHash) {
+	// sends arrive in order and amounts are positive, so the sender balance is overrun by the time lookForTxHash arrives exactly when
+	// the running total up to and including it exceeds the POW balance, and the latest arrival is the one closest to the minimum latency
+	int64_t nArrivalTime;
+	CAmount nSent;
+	if (lookForTxHash.IsNull()) {
+		if (!senderIndex.GetLastArrivalTime(nArrivalTime))
 			return ZDAG_STATUS_OK;
-		}
+		nSent = senderIndex.GetTotal();
 	}
-	return lookForTxHash.IsNull()? ZDAG_STATUS_OK: ZDAG_NOT_FOUND;
+	else if (!mempool.exists(lookForTxHash) || !senderIndex.GetSentUntil(lookForTxHash, nArrivalTime, nSent))
+		return ZDAG_NOT_FOUND;
+	// if this tx arrived within the minimum latency period flag it as potentially conflicting
+	if (abs(nArrivalTime - GetTimeMillis()) < minLatency)
+		return ZDAG_MINOR_CONFLICT;
+	// if running balance overruns the stored balance then we have a potential conflict
+	if (nSent > dbAssetAllocation.nBalance)
+		return ZDAG_MINOR_CONFLICT;
+	return ZDAG_STATUS_OK;
 }
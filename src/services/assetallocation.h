@@ -10,6 +10,11 @@
 #include <unordered_map>
 #include <txmempool.h>
 #include <services/witnessaddress.h>
+#include <services/assetcache.h>
+#include <openhashmap.h>
+#include <sync.h>
+#include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #ifdef ENABLE_WALLET
 #include <script/ismine.h>
 #endif
@@ -21,6 +26,7 @@ class CWallet;
 #endif
 bool AssetMintTxToJson(const CTransaction& tx, UniValue &entry);
 bool AssetMintTxToJson(const CTransaction& tx, const CMintPaydayCoin& mintpaydaycoin, const int& nHeight,  const uint256& blockhash, UniValue &entry);
+bool AssetMintTxToJson(const int& nTxVersion, const uint256& txid, const CMintPaydayCoin& mintpaydaycoin, const CTxOut& txOutMint, const int& nHeight, const uint256& blockhash, UniValue &entry);
 
 std::string assetAllocationFromTx(const int &nVersion);
 
@@ -70,9 +76,282 @@ public:
 		return (nAsset == 0 && witnessAddress.IsNull());
 	}
 };
-typedef std::unordered_map<std::string, CAmount> AssetBalanceMap;
+/** Fixed size binary form of an asset allocation tuple used to key the in-memory ZDAG state */
+class CAssetAllocationTupleKey {
+public:
+    // largest witness program allowed by BIP141, longer programs are keyed by their SHA256
+    static const unsigned int MAX_PROGRAM_SIZE = 40;
+    static const unsigned char HASHED_PROGRAM = 0xFF;
+    uint32_t nAsset;
+    unsigned char nVersion;
+    unsigned char nProgramSize;
+    unsigned char vchProgram[MAX_PROGRAM_SIZE];
+
+    CAssetAllocationTupleKey() {
+        SetNull();
+    }
+    explicit CAssetAllocationTupleKey(const CAssetAllocationTuple& assetAllocationTuple);
+    inline void SetNull() {
+        memset(this, 0, sizeof(*this));
+    }
+    inline unsigned int ProgramLength() const {
+        return nProgramSize == HASHED_PROGRAM? CSHA256::OUTPUT_SIZE: nProgramSize;
+    }
+    inline bool operator==(const CAssetAllocationTupleKey& other) const {
+        return memcmp(this, &other, sizeof(*this)) == 0;
+    }
+    inline bool operator!=(const CAssetAllocationTupleKey& other) const {
+        return !(*this == other);
+    }
+    // only exact for programs of up to MAX_PROGRAM_SIZE bytes
+    CAssetAllocationTuple ToTuple() const;
+    std::string ToString() const;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        ::Serialize(s, nAsset);
+        ::Serialize(s, nVersion);
+        ::Serialize(s, nProgramSize);
+        s.write((const char*)vchProgram, ProgramLength());
+    }
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        SetNull();
+        ::Unserialize(s, nAsset);
+        ::Unserialize(s, nVersion);
+        ::Unserialize(s, nProgramSize);
+        if (ProgramLength() > MAX_PROGRAM_SIZE)
+            throw std::ios_base::failure("CAssetAllocationTupleKey: witness program too large");
+        s.read((char*)vchProgram, ProgramLength());
+    }
+};
+static_assert(sizeof(CAssetAllocationTupleKey) == 48, "CAssetAllocationTupleKey must not contain uninitialized padding bytes");
+
+/**
+ * Key prefixes shared by the asset and the asset allocation dbs:
+ *  - [DB_ASSET_RECORD, guid (BE)] -> asset, [DB_ASSET_RECORD, guid (BE), address] -> allocation
+ *  - [DB_ASSET_OWNER, address, guid (BE)] -> empty, everything an address owns or holds
+ *  - [DB_ASSET_KEY_LAYOUT] -> layout version the records were written with
+ *  - [DB_ASSET_BEST_BLOCK] -> chainstate block the asset db was last flushed with (asset db only)
+ * Guids are big-endian so the allocations of an asset and the guids of an owner are contiguous ranges.
+ */
+static const char DB_ASSET_RECORD = 's';
+static const char DB_ASSET_OWNER = 'o';
+static const char DB_ASSET_KEY_LAYOUT = 'V';
+static const char DB_ASSET_BEST_BLOCK = 'B';
+static const int ASSET_KEY_LAYOUT_VERSION = 1;
+
+class CAssetRecordKey {
+public:
+    uint32_t nAsset;
+    CWitnessAddress witnessAddress;
+
+    CAssetRecordKey() : nAsset(0) {}
+    CAssetRecordKey(const uint32_t& nAssetIn, const CWitnessAddress& witnessAddressIn) : nAsset(nAssetIn) {
+        witnessAddress = witnessAddressIn;
+    }
+    CAssetRecordKey(const CAssetRecordKey& other) : nAsset(other.nAsset) {
+        witnessAddress = other.witnessAddress;
+    }
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata32be(s, nAsset);
+        // asset records are keyed by the guid alone
+        if (!witnessAddress.IsNull())
+            s << witnessAddress;
+    }
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        nAsset = ser_readdata32be(s);
+        witnessAddress.SetNull();
+        if (!s.empty())
+            s >> witnessAddress;
+    }
+};
+class CAssetOwnerKey {
+public:
+    CWitnessAddress witnessAddress;
+    uint32_t nAsset;
+
+    CAssetOwnerKey() : nAsset(0) {}
+    CAssetOwnerKey(const CWitnessAddress& witnessAddressIn, const uint32_t& nAssetIn) : nAsset(nAssetIn) {
+        witnessAddress = witnessAddressIn;
+    }
+    CAssetOwnerKey(const CAssetOwnerKey& other) : nAsset(other.nAsset) {
+        witnessAddress = other.witnessAddress;
+    }
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        s << witnessAddress;
+        ser_writedata32be(s, nAsset);
+    }
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        s >> witnessAddress;
+        nAsset = ser_readdata32be(s);
+    }
+};
+/** Stamp an empty asset or allocation db with the current key layout, false if it holds records of an older layout */
+bool CheckAssetKeyLayout(CDBWrapper& db);
+/** Guids of the assets or allocations owned by address, read from the owner range of db */
+bool ReadAssetGuidsByOwner(CDBWrapper& db, const CWitnessAddress& address, std::vector<uint32_t>& assetGuids, const size_t nMax = std::numeric_limits<size_t>::max());
+
+class SaltedAssetAllocationTupleKeyHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedAssetAllocationTupleKeyHasher();
+
+    size_t operator()(const CAssetAllocationTupleKey& key) const {
+        return CSipHasher(k0, k1).Write(((uint64_t)key.nAsset << 16) | ((uint64_t)key.nVersion << 8) | key.nProgramSize).Write(key.vchProgram, key.ProgramLength()).Finalize();
+    }
+};
+typedef openhashmap<CAssetAllocationTupleKey, CAmount, SaltedAssetAllocationTupleKeyHasher> AssetBalanceMap;
 typedef std::unordered_map<uint256, int64_t,SaltedTxidHasher> ArrivalTimesMap;
-typedef std::unordered_map<std::string, ArrivalTimesMap> ArrivalTimesMapImpl;
+typedef openhashmap<CAssetAllocationTupleKey, ArrivalTimesMap, SaltedAssetAllocationTupleKeyHasher> ArrivalTimesMapImpl;
+typedef openhashmap<CAssetAllocationTupleKey, bool, SaltedAssetAllocationTupleKeyHasher> AssetAllocationConflictSet;
+typedef openhashmap<CAssetAllocationTupleKey, bool, SaltedAssetAllocationTupleKeyHasher> ZDAGDirtySet;
+
+/**
+ * One sender's ZDAG sends in arrival order with a running total of the amounts sent, kept next to its
+ * ArrivalTimesMap so conflict status queries do not have to sort and replay the sender's arrivals.
+ * Entries are kept sorted by arrival time in a vector with a Fenwick tree over the amounts, removed entries
+ * are tombstoned until they outnumber the live ones.
+ */
+class CZDAGSenderIndex {
+private:
+    struct CArrival {
+        int64_t nArrivalTime;
+        uint256 txHash;
+        CAmount nAmount;
+        bool fRemoved;
+    };
+    std::vector<CArrival> vecArrivals;
+    // 1-based Fenwick tree over vecArrivals[i].nAmount
+    std::vector<CAmount> vecTree;
+    std::unordered_map<uint256, size_t, SaltedTxidHasher> mapPositions;
+    CAmount nTotal = 0;
+    size_t nRemoved = 0;
+
+    CAmount PrefixSum(size_t nCount) const;
+    void Rebuild();
+
+public:
+    /** Add or replace the arrival of txHash */
+    void Add(const uint256& txHash, const int64_t& nArrivalTime, const CAmount& nAmount);
+    void Remove(const uint256& txHash);
+    void clear();
+    size_t size() const { return mapPositions.size(); }
+    CAmount GetTotal() const { return nTotal; }
+    /** Arrival time of txHash and the amount sent by it and every send that arrived before it */
+    bool GetSentUntil(const uint256& txHash, int64_t& nArrivalTime, CAmount& nSent) const;
+    /** Arrival time of the latest send */
+    bool GetLastArrivalTime(int64_t& nArrivalTime) const;
+};
+typedef openhashmap<CAssetAllocationTupleKey, CZDAGSenderIndex, SaltedAssetAllocationTupleKeyHasher> ZDAGSenderIndexMap;
+
+/** Arrivals older than this (measured against the median time past) no longer count towards a sender's ZDAG state */
+static const int64_t ZDAG_ARRIVAL_EXPIRY_MILLIS = 30 * 60 * 1000;
+/** Width of one bucket of the arrival expiry wheel */
+static const int64_t ZDAG_EXPIRY_BUCKET_MILLIS = 10 * 1000;
+/** Maximum number of wheel entries drained per shard lock acquisition */
+static const unsigned int ZDAG_EXPIRY_SLICE = 1000;
+/**
+ * Arrivals by arrival time bucket. Entries are not removed when their arrival goes away some other way (reset,
+ * resync), the drain skips arrivals that are gone or have since been replaced by a later one.
+ */
+typedef std::map<int64_t, std::vector<std::pair<CAssetAllocationTupleKey, uint256> > > ZDAGExpiryWheel;
+
+/** Persisted ZDAG mempool state of one sender, see CAssetAllocationMempoolDB */
+class CZDAGSenderRecord {
+public:
+    bool fBalance = false;
+    CAmount nBalance = 0;
+    std::vector<std::pair<uint256, int64_t> > vecArrivalTimes;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(fBalance);
+        READWRITE(nBalance);
+        READWRITE(vecArrivalTimes);
+    }
+    bool IsNull() const { return !fBalance && vecArrivalTimes.empty(); }
+};
+
+/** ZDAG mempool state of the senders hashed to one shard, all of it is keyed by the sender tuple */
+struct CZDAGShard {
+    CCriticalSection cs;
+    AssetBalanceMap mapBalances GUARDED_BY(cs);
+    ArrivalTimesMapImpl mapArrivalTimes GUARDED_BY(cs);
+    AssetAllocationConflictSet setConflicts GUARDED_BY(cs);
+    ZDAGSenderIndexMap mapSenderIndexes GUARDED_BY(cs);
+    ZDAGExpiryWheel expiryWheel GUARDED_BY(cs);
+    // senders whose balance or arrival times changed since they were last persisted
+    ZDAGDirtySet setDirty GUARDED_BY(cs);
+    std::atomic<uint64_t> nLocks{0};
+    std::atomic<uint64_t> nLocksContended{0};
+
+    void MarkDirty(const CAssetAllocationTupleKey& senderTupleKey) EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        setDirty.emplace(senderTupleKey, true);
+    }
+    /** Current balance and arrival times of a sender for persisting it */
+    CZDAGSenderRecord GetSenderRecord(const CAssetAllocationTupleKey& senderTupleKey) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void QueueExpiry(const CAssetAllocationTupleKey& senderTupleKey, const uint256& txHash, const int64_t& nArrivalTime) EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        expiryWheel[nArrivalTime / ZDAG_EXPIRY_BUCKET_MILLIS].emplace_back(senderTupleKey, txHash);
+    }
+    /**
+     * Drop up to nMaxEntries wheel entries from buckets that arrived entirely before nExpiredBefore, removing a sender's
+     * balance and conflict once its last arrival expires. Returns true if expired buckets are left over.
+     */
+    bool ExpireArrivalTimes(const int64_t& nExpiredBefore, unsigned int nMaxEntries, int& nExpired) EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+static const unsigned int ZDAG_SHARDS = 16;
+/**
+ * Real-time (ZDAG) balances, arrival times and conflicts of asset allocation senders, split into hash shards with
+ * their own lock so mempool acceptance of unrelated senders does not serialize. Never hold more than one shard
+ * lock at a time, and take mempool.cs before a shard lock if both are needed.
+ */
+class CZDAGState {
+private:
+    CZDAGShard shards[ZDAG_SHARDS];
+    // salted independently of the maps inside the shards so each shard still spreads over all of its slots
+    SaltedAssetAllocationTupleKeyHasher hasher;
+
+public:
+    CZDAGShard& GetShard(const CAssetAllocationTupleKey& key) { return shards[hasher(key) % ZDAG_SHARDS]; }
+    CZDAGShard& GetShard(unsigned int nShard) { return shards[nShard]; }
+    /** Add a sender read back from disk, it is not marked dirty */
+    void LoadSender(const CAssetAllocationTupleKey& senderTupleKey, CZDAGSenderRecord& record);
+    void ClearArrivalTimes();
+    /** Shard lock acquisitions and how many of them found the lock held by another thread */
+    void GetLockStats(uint64_t& nLocks, uint64_t& nLocksContended) const;
+};
+extern CZDAGState zdagState;
+
+/** Shard lock that counts how often it had to wait for another thread */
+class SCOPED_LOCKABLE CZDAGShardLock : public UniqueLock<CCriticalSection>
+{
+public:
+    CZDAGShardLock(CZDAGShard& shard, const char* pszFile, int nLine) EXCLUSIVE_LOCK_FUNCTION(shard.cs) : UniqueLock<CCriticalSection>(shard.cs, "zdagshard.cs", pszFile, nLine, true)
+    {
+        shard.nLocks++;
+        if (!owns_lock()) {
+            shard.nLocksContended++;
+            EnterCritical("zdagshard.cs", pszFile, nLine, (void*)mutex());
+            lock();
+        }
+    }
+};
+#define LOCK_ZDAG_SHARD(shard) CZDAGShardLock PASTE2(zdagshardblock, __COUNTER__)(shard, __FILE__, __LINE__)
+
 typedef std::vector<std::pair<CWitnessAddress, CAmount > > RangeAmountTuples;
 static const int ZDAG_MINIMUM_LATENCY_SECONDS = 10;
 static const int ONE_YEAR_IN_BLOCKS = 525600;
@@ -130,22 +409,39 @@ public:
 	void Serialize(std::vector<unsigned char>& vchData);
 };
 typedef std::unordered_map<std::string, CAssetAllocation > AssetAllocationMap;
+struct CAssetAllocationCacheTraits {
+    static bool IsErased(const CAssetAllocation& assetallocation) { return assetallocation.nBalance <= 0; }
+    static void Copy(const CAssetAllocation& from, CAssetAllocation& to);
+    static size_t DynamicUsage(const CAssetAllocation& assetallocation);
+};
 class CAssetAllocationDB : public CDBWrapper {
+private:
+    CServiceRecordCache<std::string, CAssetAllocation, CAssetAllocationCacheTraits> cache;
 public:
 	CAssetAllocationDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "assetallocations", nCacheSize, fMemory, fWipe) {}
     
-    bool ReadAssetAllocation(const CAssetAllocationTuple& assetAllocationTuple, CAssetAllocation& assetallocation) {
-        return Read(assetAllocationTuple, assetallocation);
+    bool ReadAssetAllocation(const CAssetAllocationTuple& assetAllocationTuple, CAssetAllocation& assetallocation);
+    void WriteCache(AssetAllocationMap &mapAssetAllocations) {
+        cache.Write(mapAssetAllocations);
+    }
+    void GetDirtyCache(AssetAllocationMap &mapAssetAllocations) {
+        cache.GetDirty(mapAssetAllocations);
     }
-    bool ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids){
-        return Read(address, assetGuids);
+    void EndFlushCache(const bool fWritten) {
+        cache.EndFlush(fWritten);
     }
+    size_t DynamicMemoryUsage() const {
+        return cache.DynamicMemoryUsage();
+    }
+    /** Guids held by address, the owner index of the db with the allocations changed since the last flush applied */
+    bool ReadAssetsByAddress(const CWitnessAddress &address, std::vector<uint32_t> &assetGuids);
     bool ExistsAssetsByAddress(const CWitnessAddress &address){
-        return Exists(address);
+        std::vector<uint32_t> assetGuids;
+        return ReadAssetsByAddress(address, assetGuids);
     }	
-    bool Flush(const AssetAllocationMap &mapAssetAllocations);
-	void WriteAssetAllocationIndex(const CTransaction &tx, const CAsset& dbAsset, const int &nHeight, const uint256& blockhash);
-    void WriteMintIndex(const CTransaction& tx, const CMintPaydayCoin& mintPaydayCoin, const int &nHeight, const uint256& blockhash);
+    bool Flush(const AssetAllocationMap &mapAssetAllocations, const bool fSync = false);
+	void NotifyAssetAllocationUpdate(const CTransaction &tx, const CAsset& dbAsset, const int &nHeight, const uint256& blockhash);
+    void NotifyMintUpdate(const CTransaction& tx, const CMintPaydayCoin& mintPaydayCoin, const int &nHeight, const uint256& blockhash);
 	bool ScanAssetAllocations(const int count, const int from, const UniValue& oOptions, UniValue& oRes);
 };
 
@@ -154,29 +450,20 @@ public:
     CAssetAllocationMempoolDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "assetallocationmempoolbalances", nCacheSize, fMemory, fWipe) {
     }
 
-    bool WriteAssetAllocationMempoolBalances(const AssetBalanceMap &valueMap) {
-        return Write(std::string("assetallocationtxbalance"), valueMap, true);
-    }
-    bool ReadAssetAllocationMempoolBalances(AssetBalanceMap &valueMap) {
-        return Read(std::string("assetallocationtxbalance"), valueMap);
-    }
-    bool WriteAssetAllocationMempoolArrivalTimes(const ArrivalTimesMapImpl &valueMap) {
-        return Write(std::string("assetallocationtxarrival"), valueMap, true);
-    }
-    bool ReadAssetAllocationMempoolArrivalTimes(ArrivalTimesMapImpl &valueMap) {
-        return Read(std::string("assetallocationtxarrival"), valueMap);
-    }   
+    /** Write the senders that changed since the last flush, one record per sender, and erase the ones that are gone */
+    bool FlushZDAGState(CZDAGState& state);
+    /** Stream every persisted sender into state */
+    bool LoadZDAGState(CZDAGState& state);
     bool ScanAssetAllocationMempoolBalances(const int count, const int from, const UniValue& oOptions, UniValue& oRes);
 };
 bool GetAssetAllocation(const CAssetAllocationTuple& assetAllocationTuple,CAssetAllocation& txPos);
 bool BuildAssetAllocationJson(const CAssetAllocation& assetallocation, const CAsset& asset, UniValue& oName);
 bool AssetAllocationTxToJSON(const CTransaction &tx, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash, UniValue &entry, CAssetAllocation& assetallocation);
+bool AssetAllocationTxToJSON(const int& nTxVersion, const uint256& txid, const CAssetAllocation& assetallocation, const std::vector<unsigned char>& vchEthAddress, const CAsset& dbAsset, const int& nHeight, const uint256& blockhash, UniValue &entry);
 #ifdef ENABLE_WALLET
 bool AssetAllocationTxToJSON(const CTransaction &tx, UniValue &entry, CWallet* const pwallet, const isminefilter* filter_ismine);
 #endif
 bool AssetAllocationTxToJSON(const CTransaction &tx, UniValue &entry);
-void WriteAssetIndexForAllocation(const CAssetAllocation& assetallocation, const uint256& txid, const UniValue& oName);
-void WriteAssetIndexForAllocation(const CMintPaydayCoin& mintPaydayCoin, const uint256& txid, const UniValue& oName);
-void WriteAssetAllocationIndexTXID(const CAssetAllocationTuple& allocationTuple, const uint256& txid);
+CAmount GetZDAGSendAmount(const CAssetAllocation& assetallocation);
 int DetectPotentialAssetAllocationSenderConflicts(const CAssetAllocationTuple& assetAllocationTupleSender, const uint256& lookForTxHash);
 #endif // PAYDAYCOIN_SERVICES_ASSETALLOCATION_H
@@ -0,0 +1,219 @@
+// Copyright (c) 2017-2018 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PAYDAYCOIN_SERVICES_ASSETCACHE_H
+#define PAYDAYCOIN_SERVICES_ASSETCACHE_H
+
+#include <memusage.h>
+#include <sync.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Write-back cache of decoded asset db records, modelled on CCoinsViewCache.
+ *
+ * Records read from the db are kept decoded so repeat lookups skip LevelDB and deserialization, db misses are
+ * remembered as FRESH entries and connected/disconnected blocks are written into the cache as DIRTY entries.
+ * GetDirty() hands copies of the dirty records to the owning db for a batch write, the cache keeps serving them
+ * until EndFlush() reports the write succeeded.
+ *
+ * Traits must provide IsErased(record) (the record would be erased from the db on flush), Copy(from, to) and
+ * DynamicUsage(record) for the heap memory owned by a record.
+ */
+template <typename Key, typename Value, typename Traits>
+class CServiceRecordCache
+{
+public:
+    typedef std::unordered_map<Key, Value> RecordMap;
+    enum Flags {
+        DIRTY = (1 << 0), // this cache entry is potentially different from the version in the db
+        FRESH = (1 << 1), // the db does not have this entry
+    };
+
+private:
+    struct CCacheEntry
+    {
+        Value record;
+        unsigned char flags = 0;
+    };
+    mutable CCriticalSection cs;
+    std::unordered_map<Key, CCacheEntry> cacheRecords GUARDED_BY(cs);
+    /* Cached dynamic memory usage for the records owned by the cache entries */
+    size_t cachedRecordsUsage GUARDED_BY(cs) = 0;
+    /* Bumped around every flush so db reads that raced it are not cached */
+    uint64_t nGeneration GUARDED_BY(cs) = 0;
+    /* Set between GetDirty() and EndFlush() while the db is being written */
+    bool fFlushing GUARDED_BY(cs) = false;
+
+public:
+    /**
+     * Look up a record. Returns 1 and copies the record if it exists, 0 if it is known not to exist and -1 if the
+     * db has to be consulted, in which case nGenerationOut is set for the following Add().
+     */
+    int Get(const Key& key, Value& record, uint64_t& nGenerationOut) const
+    {
+        LOCK(cs);
+        auto it = cacheRecords.find(key);
+        if (it == cacheRecords.end()) {
+            nGenerationOut = nGeneration;
+            return -1;
+        }
+        if (Traits::IsErased(it->second.record))
+            return 0;
+        Traits::Copy(it->second.record, record);
+        return 1;
+    }
+
+    /** Remember the result of a db read, pass nullptr if the db did not have the record */
+    void Add(const Key& key, const Value* record, const uint64_t& nGenerationIn)
+    {
+        LOCK(cs);
+        if (fFlushing || nGenerationIn != nGeneration)
+            return;
+        auto it = cacheRecords.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        if (!it.second)
+            return;
+        CCacheEntry& entry = it.first->second;
+        if (record) {
+            Traits::Copy(*record, entry.record);
+            cachedRecordsUsage += Traits::DynamicUsage(entry.record);
+        } else {
+            entry.flags = FRESH;
+        }
+    }
+
+    /** Take ownership of the records changed by a block and mark them dirty */
+    void Write(RecordMap& mapRecords)
+    {
+        LOCK(cs);
+        for (auto& recordPair : mapRecords) {
+            auto it = cacheRecords.emplace(std::piecewise_construct, std::forward_as_tuple(recordPair.first), std::forward_as_tuple());
+            CCacheEntry& entry = it.first->second;
+            if (!it.second)
+                cachedRecordsUsage -= Traits::DynamicUsage(entry.record);
+            entry.record = std::move(recordPair.second);
+            entry.flags |= DIRTY;
+            cachedRecordsUsage += Traits::DynamicUsage(entry.record);
+        }
+        mapRecords.clear();
+    }
+
+    /** Copy every dirty record the db has to see into mapRecords, call EndFlush() once they are written */
+    void GetDirty(RecordMap& mapRecords)
+    {
+        LOCK(cs);
+        for (const auto& entryPair : cacheRecords) {
+            const CCacheEntry& entry = entryPair.second;
+            if (!(entry.flags & DIRTY))
+                continue;
+            // erasing a record the db never had is a no-op
+            if ((entry.flags & FRESH) && Traits::IsErased(entry.record))
+                continue;
+            Traits::Copy(entry.record, mapRecords[entryPair.first]);
+        }
+        fFlushing = true;
+        nGeneration++;
+    }
+
+    /** Finish a flush started by GetDirty(), the cache is only emptied if the dirty records made it to the db */
+    void EndFlush(const bool fWritten)
+    {
+        LOCK(cs);
+        if (fWritten) {
+            cacheRecords.clear();
+            cachedRecordsUsage = 0;
+        }
+        fFlushing = false;
+        nGeneration++;
+    }
+
+    /** Call fn(key, record) for every dirty record, erased ones included, so db scans can see unflushed blocks */
+    template <typename Callable>
+    void ForEachDirty(Callable fn) const
+    {
+        LOCK(cs);
+        for (const auto& entryPair : cacheRecords) {
+            if (entryPair.second.flags & DIRTY)
+                fn(entryPair.first, entryPair.second.record);
+        }
+    }
+
+    size_t DynamicMemoryUsage() const
+    {
+        LOCK(cs);
+        return memusage::DynamicUsage(cacheRecords) + cachedRecordsUsage;
+    }
+
+    size_t GetCacheSize() const
+    {
+        LOCK(cs);
+        return cacheRecords.size();
+    }
+};
+
+/**
+ * Writes and erases of a plain key/value asset db that wait for the next chainstate flush. Reads have to consult
+ * Get() before the db, Key and Value must be usable with memusage::DynamicUsage.
+ */
+template <typename Key, typename Value>
+class CServicePendingWrites
+{
+private:
+    mutable CCriticalSection cs;
+    /* false and the value for a pending write, true for a pending erase */
+    std::map<Key, std::pair<bool, Value> > mapPending GUARDED_BY(cs);
+
+public:
+    void Write(const Key& key, const Value& value)
+    {
+        LOCK(cs);
+        mapPending[key] = std::make_pair(false, value);
+    }
+
+    void Erase(const Key& key)
+    {
+        LOCK(cs);
+        mapPending[key] = std::make_pair(true, Value());
+    }
+
+    /** Returns 1 and copies the value for a pending write, 0 for a pending erase and -1 if the db has to be consulted */
+    int Get(const Key& key, Value& value) const
+    {
+        LOCK(cs);
+        auto it = mapPending.find(key);
+        if (it == mapPending.end())
+            return -1;
+        if (it->second.first)
+            return 0;
+        value = it->second.second;
+        return 1;
+    }
+
+    void GetPending(std::vector<std::pair<Key, Value> >& vecWrites, std::vector<Key>& vecErases) const
+    {
+        LOCK(cs);
+        for (const auto& pendingPair : mapPending) {
+            if (pendingPair.second.first)
+                vecErases.push_back(pendingPair.first);
+            else
+                vecWrites.emplace_back(pendingPair.first, pendingPair.second.second);
+        }
+    }
+
+    /** Forget the pending writes once they made it to the db */
+    void Clear()
+    {
+        LOCK(cs);
+        mapPending.clear();
+    }
+
+    size_t DynamicMemoryUsage() const
+    {
+        LOCK(cs);
+        return memusage::DynamicUsage(mapPending);
+    }
+};
+
+#endif // PAYDAYCOIN_SERVICES_ASSETCACHE_H
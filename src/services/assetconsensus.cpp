@@ -12,16 +12,104 @@
 #include <ethereum/commondata.h>
 #include <boost/thread.hpp>
 #include <services/rpc/assetrpc.h>
-extern AssetBalanceMap mempoolMapAssetBalances;
-extern ArrivalTimesMapImpl arrivalTimesMap;
+#include <checkqueue.h>
+#include <cuckoocache.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <txdb.h>
+#include <index/assetindex.h>
 std::unique_ptr<CBlockIndexDB> pblockindexdb;
 std::unique_ptr<CLockedOutpointsDB> plockedoutpointsdb;
 std::unique_ptr<CEthereumTxRootsDB> pethereumtxrootsdb;
 std::unique_ptr<CEthereumMintedTxDB> pethereumtxmintdb;
-extern std::unordered_set<std::string> assetAllocationConflicts;
-extern CCriticalSection cs_assetallocation;
-extern CCriticalSection cs_assetallocationarrival;
+int64_t nAssetCacheUsage = DEFAULT_ASSET_DB_CACHE << 20;
 using namespace std;
+namespace {
+/**
+ * Mints whose receipt and transaction SPV proofs verified, to avoid walking and hashing both Patricia
+ * tries twice for every mint (once when accepted into memory pool, and again when connected in a block).
+ * The proofs only depend on the transaction, the roots they prove against are checked against the
+ * relayed headers on every call so entries stay valid across reorgs of either chain.
+ */
+class CEthereumProofCache
+{
+private:
+    //! Entries are SHA256(nonce || witness hash of the mint)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_proofcache;
+
+public:
+    CEthereumProofCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256 &hashWitness)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hashWitness.begin(), 32).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_proofcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_proofcache);
+        setValid.insert(entry);
+    }
+    uint32_t setup_bytes(size_t n)
+    {
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CEthereumProofCache ethereumProofCache;
+} // namespace
+
+void InitEthereumProofCache()
+{
+    size_t nElems = ethereumProofCache.setup_bytes(DEFAULT_ETHEREUM_PROOF_CACHE_SIZE << 20);
+    LogPrintf("Using %zu MiB for ethereum proof cache, able to store %zu elements\n",
+        (nElems * sizeof(uint256)) >> 20, nElems);
+}
+/** Whether the root carried in a mint is the 32 byte root the relayer stored */
+static bool MatchesTxRoot(dev::bytesConstRef vchRoot, const uint256 &hashRoot){
+    return vchRoot.size() == hashRoot.size() && std::equal(vchRoot.begin(), vchRoot.end(), hashRoot.begin());
+}
+CPaydayCoinTxPayload::CPaydayCoinTxPayload(const CTransaction& tx) {
+    fValid = false;
+    if (IsAssetAllocationTx(tx.nVersion) || tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+        fValid = assetAllocation.UnserializeFromTx(tx);
+    else if (IsAssetTx(tx.nVersion))
+        fValid = asset.UnserializeFromTx(tx);
+    else if (IsPaydayCoinMintTx(tx.nVersion))
+        fValid = mintPaydayCoin.UnserializeFromTx(tx);
+}
+size_t CPaydayCoinTxPayload::DynamicMemoryUsage() const {
+    return CAssetCacheTraits::DynamicUsage(asset) + CAssetAllocationCacheTraits::DynamicUsage(assetAllocation) +
+        memusage::DynamicUsage(mintPaydayCoin.assetAllocationTuple.witnessAddress.vchWitnessProgram) +
+        memusage::DynamicUsage(mintPaydayCoin.vchTxValue) + memusage::DynamicUsage(mintPaydayCoin.vchTxParentNodes) +
+        memusage::DynamicUsage(mintPaydayCoin.vchTxRoot) + memusage::DynamicUsage(mintPaydayCoin.vchTxPath) +
+        memusage::DynamicUsage(mintPaydayCoin.vchReceiptValue) + memusage::DynamicUsage(mintPaydayCoin.vchReceiptParentNodes) +
+        memusage::DynamicUsage(mintPaydayCoin.vchReceiptRoot) + memusage::DynamicUsage(mintPaydayCoin.vchReceiptPath);
+}
+void CTxMemPoolEntry::SetPaydayCoinPayload(const PaydayCoinTxPayloadRef& payloadIn) {
+    if (payload)
+        nUsageSize -= memusage::DynamicUsage(payload) + payload->DynamicMemoryUsage();
+    payload = payloadIn;
+    if (payload)
+        nUsageSize += memusage::DynamicUsage(payload) + payload->DynamicMemoryUsage();
+}
+PaydayCoinTxPayloadRef MakePaydayCoinTxPayload(const CTransaction& tx) {
+    if (!IsPaydayCoinTx(tx.nVersion))
+        return nullptr;
+    return std::make_shared<const CPaydayCoinTxPayload>(tx);
+}
 bool DisconnectPaydayCoinTransaction(const CTransaction& tx, const CBlockIndex* pindex, CCoinsViewCache& view, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys)
 {
     if(tx.IsCoinBase())
@@ -66,11 +154,11 @@ bool DisconnectPaydayCoinTransaction(const CTransaction& tx, const CBlockIndex*
     return true;       
 }
 
-bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& errorMessage, const bool &fJustCheck, const bool& bSanity, const bool& bMiner, const int& nHeight, const uint256& blockhash, AssetMap& mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, bool &bTxRootError)
+bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, const CPaydayCoinTxPayload& payload, std::string& errorMessage, const bool &fJustCheck, const bool& bSanity, const bool& bMiner, const int& nHeight, const uint256& blockhash, AssetMap& mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, bool &bTxRootError)
 {
     static bool bGethTestnet = gArgs.GetBoolArg("-gethtestnet", false);
-    // unserialize mint object from txn, check for valid
-    CMintPaydayCoin mintPaydayCoin(tx);
+    // mint object unserialized from txn, check for valid
+    const CMintPaydayCoin &mintPaydayCoin = payload.mintPaydayCoin;
     CAsset dbAsset;
     if(mintPaydayCoin.IsNull())
     {
@@ -156,13 +244,13 @@ bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& er
     dev::RLP rlpTxRoot(&mintPaydayCoin.vchTxRoot);
     dev::RLP rlpReceiptRoot(&mintPaydayCoin.vchReceiptRoot);
 
-    if(!txRootDB.vchTxRoot.empty() && rlpTxRoot.toBytes(dev::RLP::VeryStrict) != txRootDB.vchTxRoot){
+    if(!txRootDB.IsNull() && !MatchesTxRoot(rlpTxRoot.toBytesConstRef(dev::RLP::VeryStrict), txRootDB.hashTxRoot)){
         errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Mismatching Tx Roots");
         bTxRootError = true; // roots can be wrong because geth may not give us affected headers post re-org
         return false;
     }
 
-    if(!txRootDB.vchReceiptRoot.empty() && rlpReceiptRoot.toBytes(dev::RLP::VeryStrict) != txRootDB.vchReceiptRoot){
+    if(!txRootDB.IsNull() && !MatchesTxRoot(rlpReceiptRoot.toBytesConstRef(dev::RLP::VeryStrict), txRootDB.hashReceiptRoot)){
         errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Mismatching Receipt Roots");
         bTxRootError = true; // roots can be wrong because geth may not give us affected headers post re-org
         return false;
@@ -186,16 +274,21 @@ bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& er
     // add the key to flush to db later
     vecMintKeys.emplace_back(ethKey);
     
-    // verify receipt proof
-    if(!VerifyProof(&vchTxPath, rlpReceiptValue, rlpReceiptParentNodes, rlpReceiptRoot)){
-        errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Could not verify ethereum transaction receipt using SPV proof");
-        return false;
-    } 
-    // verify transaction proof
-    if(!VerifyProof(&vchTxPath, rlpTxValue, rlpTxParentNodes, rlpTxRoot)){
-        errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Could not verify ethereum transaction using SPV proof");
-        return false;
-    } 
+    uint256 hashProofCacheEntry;
+    ethereumProofCache.ComputeEntry(hashProofCacheEntry, tx.GetWitnessHash());
+    if(!ethereumProofCache.Get(hashProofCacheEntry)){
+        // verify receipt proof
+        if(!VerifyProof(&vchTxPath, rlpReceiptValue, rlpReceiptParentNodes, rlpReceiptRoot)){
+            errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Could not verify ethereum transaction receipt using SPV proof");
+            return false;
+        } 
+        // verify transaction proof
+        if(!VerifyProof(&vchTxPath, rlpTxValue, rlpTxParentNodes, rlpTxRoot)){
+            errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Could not verify ethereum transaction using SPV proof");
+            return false;
+        } 
+        ethereumProofCache.Set(hashProofCacheEntry);
+    }
     if (!rlpTxValue.isList()){
         errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Transaction RLP must be a list");
         return false;
@@ -224,7 +317,7 @@ bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& er
     
     CAmount outputAmount;
     uint32_t nAsset = 0;
-    const std::vector<unsigned char> &rlpBytes = rlpTxValue[5].toBytes(dev::RLP::VeryStrict);
+    const dev::bytesConstRef &rlpBytes = rlpTxValue[5].toBytesConstRef(dev::RLP::VeryStrict);
     CWitnessAddress witnessAddress;
     if(!parseEthMethodInputData(Params().GetConsensus().vchPDAYXBurnMethodSignature, rlpBytes, outputAmount, nAsset, witnessAddress)){
         errorMessage = "PAYDAYCOIN_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Could not parse and validate transaction data");
@@ -275,7 +368,7 @@ bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& er
         }  
     
         const std::string &receiverTupleStr = mintPaydayCoin.assetAllocationTuple.ToString();
-        auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+        auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
         auto mapAssetAllocation = result1.first;
         const bool &mapAssetAllocationNotFound = result1.second;
         if(mapAssetAllocationNotFound){
@@ -297,12 +390,201 @@ bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& er
         // update balances  
         storedReceiverAllocationRef.nBalance += mintPaydayCoin.nValueAsset; 
         if(!fJustCheck && !bSanity && !bMiner)     
-            passetallocationdb->WriteMintIndex(tx, mintPaydayCoin, nHeight, blockhash);         
+            passetallocationdb->NotifyMintUpdate(tx, mintPaydayCoin, nHeight, blockhash);         
                                        
     }
     return true;
 }
-bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationState& state, const CCoinsViewCache &inputs, bool fJustCheck, bool &bOverflow, int nHeight, const CBlock& block, const bool &bSanity, const bool &bMiner, std::vector<uint256> &txsToRemove)
+static bool CheckPaydayCoinBlockTx(const bool ibd, const CTransaction& tx, const CPaydayCoinTxPayload& payload, const CCoinsViewCache &inputs, const bool &fJustCheck, const int &nHeight, const uint256& blockHash, const bool &bMiner, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, std::vector<COutPoint> &vecLockedOutpoints, std::string &errorMessage, bool &bOverflow, bool &bTxRootError)
+{
+    errorMessage.clear();
+    if (IsAssetAllocationTx(tx.nVersion))
+    {
+        // fJustCheck inplace of bSanity to preserve global structures from being changed during test calls, fJustCheck is actually passed in as false because we want to check in PoW mode
+        return CheckAssetAllocationInputs(tx, payload, inputs, false, nHeight, blockHash, mapAssetAllocations, vecLockedOutpoints, errorMessage, bOverflow, fJustCheck, bMiner);
+    }
+    else if (IsAssetTx(tx.nVersion))
+    {
+        return CheckAssetInputs(tx, payload, inputs, false, nHeight, blockHash, mapAssets, mapAssetAllocations, errorMessage, fJustCheck, bMiner);
+    } 
+    else if(IsPaydayCoinMintTx(tx.nVersion))
+    {
+        if(nHeight <= Params().GetConsensus().nBridgeStartBlock){
+            errorMessage = "Bridge is disabled until blockheight 51000";
+            return false;
+        }
+        return CheckPaydayCoinMint(ibd, tx, payload, errorMessage, false, fJustCheck, bMiner, nHeight, blockHash, mapAssets, mapAssetAllocations, vecMintKeys, bTxRootError);
+    }
+    return true;
+}
+/** 
+ * Collect the AssetMap/AssetAllocationMap keys a transaction can touch while being connected.
+ * Asset guids are keyed by the plain guid, allocations by their tuple string which always contains a '-'.
+ */
+static void GetAssetCheckKeys(const CTransaction& tx, const CPaydayCoinTxPayload& payload, std::vector<std::string> &vecKeys)
+{
+    if (IsAssetAllocationTx(tx.nVersion) || tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+    {
+        const CAssetAllocation &theAssetAllocation = payload.assetAllocation;
+        if(theAssetAllocation.assetAllocationTuple.IsNull())
+            return;
+        const uint32_t &nAsset = theAssetAllocation.assetAllocationTuple.nAsset;
+        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND)
+            vecKeys.emplace_back(itostr(nAsset));
+        else
+            vecKeys.emplace_back(theAssetAllocation.assetAllocationTuple.ToString());
+        for(const auto& amountTuple: theAssetAllocation.listSendingAllocationAmounts){
+            vecKeys.emplace_back(CAssetAllocationTuple(nAsset, amountTuple.first).ToString());
+        }
+        // burns credit the shared burn allocation of the asset
+        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_BURN)
+            vecKeys.emplace_back(CAssetAllocationTuple(nAsset, CWitnessAddress(0, vchFromString("burn"))).ToString());
+    }
+    else if (IsAssetTx(tx.nVersion))
+    {
+        const CAsset &theAsset = payload.asset;
+        if(!theAsset.IsNull())
+            vecKeys.emplace_back(itostr(theAsset.nAsset));
+    }
+    else if (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_MINT)
+    {
+        const CMintPaydayCoin &mintPaydayCoin = payload.mintPaydayCoin;
+        if(!mintPaydayCoin.IsNull())
+            vecKeys.emplace_back(mintPaydayCoin.assetAllocationTuple.ToString());
+    }
+}
+/** A set of block transactions that share no asset or allocation with any other set */
+struct CAssetCheckGroup
+{
+    std::vector<unsigned int> vecTxIndexes;
+    AssetMap mapAssets;
+    AssetAllocationMap mapAssetAllocations;
+    EthereumMintTxVec vecMintKeys;
+    std::vector<COutPoint> vecLockedOutpoints;
+    bool bOverflow = false;
+    bool bTxRootError = false;
+};
+/** Block wide arguments shared by every CAssetCheck of one CheckPaydayCoinInputs call */
+struct CAssetCheckContext
+{
+    bool ibd;
+    const CBlock* pblock;
+    const CCoinsViewCache* pinputs;
+    bool fJustCheck;
+    int nHeight;
+    uint256 blockHash;
+    bool bMiner;
+    const std::vector<PaydayCoinTxPayloadRef>* pvecPayloads;
+    std::vector<CAssetCheckResult>* pvecResults;
+};
+/**
+ * Closure representing the serial validation of one CAssetCheckGroup.
+ * Per transaction results are written to the context, so the check itself always succeeds and never
+ * short-circuits the remaining groups on the queue.
+ */
+class CAssetCheck
+{
+private:
+    const CAssetCheckContext *pcontext;
+    CAssetCheckGroup *pgroup;
+public:
+    CAssetCheck(): pcontext(nullptr), pgroup(nullptr) {}
+    CAssetCheck(const CAssetCheckContext *pcontextIn, CAssetCheckGroup *pgroupIn): pcontext(pcontextIn), pgroup(pgroupIn) {}
+
+    bool operator()() {
+        const CAssetCheckContext &ctx = *pcontext;
+        for(const unsigned int &i: pgroup->vecTxIndexes){
+            CAssetCheckResult &result = (*ctx.pvecResults)[i];
+            result.good = CheckPaydayCoinBlockTx(ctx.ibd, *(ctx.pblock->vtx[i]), *(*ctx.pvecPayloads)[i], *ctx.pinputs, ctx.fJustCheck, ctx.nHeight, ctx.blockHash, ctx.bMiner, pgroup->mapAssets, pgroup->mapAssetAllocations, pgroup->vecMintKeys, pgroup->vecLockedOutpoints, result.errorMessage, pgroup->bOverflow, pgroup->bTxRootError);
+        }
+        return true;
+    }
+
+    void swap(CAssetCheck &check) {
+        std::swap(pcontext, check.pcontext);
+        std::swap(pgroup, check.pgroup);
+    }
+};
+static CCheckQueue<CAssetCheck> assetcheckqueue(16);
+
+void ThreadAssetCheck(int worker_num)
+{
+    util::ThreadRename(strprintf("assetch.%i", worker_num));
+    assetcheckqueue.Thread();
+}
+/**
+ * Validate the asset transactions of a block as independent groups on the asset check queue and merge the
+ * per-group state into the block maps in group order. Transactions are grouped by the asset guids and allocation
+ * tuples they touch, so every map key is owned by exactly one group and each group sees its transactions in block
+ * order, giving the same maps and per transaction results as the serial loop.
+ * Returns false (without touching any output) if the block does not split into at least two groups.
+ */
+static bool CheckPaydayCoinInputsParallel(const bool ibd, const CBlock& block, const CCoinsViewCache &inputs, const bool &fJustCheck, const int &nHeight, const uint256& blockHash, const bool &bMiner, const std::vector<unsigned int> &vecAssetTxs, const std::vector<PaydayCoinTxPayloadRef> &vecPayloads, std::vector<CAssetCheckResult> &vecResults, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, std::vector<COutPoint> &vecLockedOutpoints, bool &bOverflow, bool &bTxRootError)
+{
+    // union-find over the asset txs, joined through the first tx to claim each key
+    std::vector<unsigned int> vecParent(vecAssetTxs.size());
+    for (unsigned int n = 0; n < vecParent.size(); n++)
+        vecParent[n] = n;
+    auto findRoot = [&vecParent](unsigned int n) {
+        while (vecParent[n] != n) {
+            vecParent[n] = vecParent[vecParent[n]];
+            n = vecParent[n];
+        }
+        return n;
+    };
+    std::unordered_map<std::string, unsigned int> mapKeyOwners;
+    std::vector<std::string> vecKeys;
+    for (unsigned int n = 0; n < vecAssetTxs.size(); n++) {
+        vecKeys.clear();
+        GetAssetCheckKeys(*(block.vtx[vecAssetTxs[n]]), *vecPayloads[vecAssetTxs[n]], vecKeys);
+        for (const std::string &key: vecKeys) {
+            auto it = mapKeyOwners.emplace(key, n);
+            if (!it.second) {
+                const unsigned int &nRootOwner = findRoot(it.first->second);
+                const unsigned int &nRoot = findRoot(n);
+                if (nRootOwner != nRoot)
+                    vecParent[std::max(nRootOwner, nRoot)] = std::min(nRootOwner, nRoot);
+            }
+        }
+    }
+    // groups are ordered by their first transaction, each group keeps block order internally
+    std::vector<CAssetCheckGroup> vecGroups;
+    std::unordered_map<unsigned int, unsigned int> mapRootGroups;
+    for (unsigned int n = 0; n < vecAssetTxs.size(); n++) {
+        auto it = mapRootGroups.emplace(findRoot(n), vecGroups.size());
+        if (it.second)
+            vecGroups.emplace_back();
+        vecGroups[it.first->second].vecTxIndexes.push_back(vecAssetTxs[n]);
+    }
+    if (vecGroups.size() < 2)
+        return false;
+    // CCoinsViewCache::AccessCoin fills the cache on a miss, warm it for every input up front so the workers only ever read it
+    for (const unsigned int &i: vecAssetTxs) {
+        for (const CTxIn &txin: block.vtx[i]->vin)
+            inputs.AccessCoin(txin.prevout);
+    }
+    const CAssetCheckContext context{ibd, &block, &inputs, fJustCheck, nHeight, blockHash, bMiner, &vecPayloads, &vecResults};
+    std::vector<CAssetCheck> vChecks;
+    vChecks.reserve(vecGroups.size());
+    for (CAssetCheckGroup &group: vecGroups)
+        vChecks.emplace_back(&context, &group);
+    CCheckQueueControl<CAssetCheck> control(&assetcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+    for (CAssetCheckGroup &group: vecGroups) {
+        for (auto &assetPair: group.mapAssets)
+            mapAssets.emplace(assetPair.first, std::move(assetPair.second));
+        for (auto &allocationPair: group.mapAssetAllocations)
+            mapAssetAllocations.emplace(allocationPair.first, std::move(allocationPair.second));
+        vecMintKeys.insert(vecMintKeys.end(), group.vecMintKeys.begin(), group.vecMintKeys.end());
+        vecLockedOutpoints.insert(vecLockedOutpoints.end(), group.vecLockedOutpoints.begin(), group.vecLockedOutpoints.end());
+        bOverflow |= group.bOverflow;
+        bTxRootError |= group.bTxRootError;
+    }
+    LogPrint(BCLog::PDAY, "CheckPaydayCoinInputs: checked %d asset transactions in %d parallel groups\n", vecAssetTxs.size(), vecGroups.size());
+    return true;
+}
+bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationState& state, const CCoinsViewCache &inputs, bool fJustCheck, bool &bOverflow, int nHeight, const CBlock& block, const bool &bSanity, const bool &bMiner, std::vector<uint256> &txsToRemove, const int64_t &nZDAGArrivalTime, const CPaydayCoinTxPayload* pPayload)
 {
     AssetAllocationMap mapAssetAllocations;
     AssetMap mapAssets;
@@ -319,15 +601,20 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
             return true;
 		if (!IsPaydayCoinTx(tx.nVersion))
 			return true;
+        PaydayCoinTxPayloadRef payloadRef;
+        if (!pPayload) {
+            payloadRef = MakePaydayCoinTxPayload(tx);
+            pPayload = payloadRef.get();
+        }
         if (IsAssetAllocationTx(tx.nVersion))
         {
             errorMessage.clear();
-            good = CheckAssetAllocationInputs(tx, inputs, fJustCheck, nHeight, uint256(), mapAssetAllocations, vecLockedOutpoints, errorMessage, bOverflow, bSanity, bMiner);
+            good = CheckAssetAllocationInputs(tx, *pPayload, inputs, fJustCheck, nHeight, uint256(), mapAssetAllocations, vecLockedOutpoints, errorMessage, bOverflow, bSanity, bMiner, nZDAGArrivalTime);
         }
         else if (IsAssetTx(tx.nVersion))
         {
             errorMessage.clear();
-            good = CheckAssetInputs(tx, inputs, fJustCheck, nHeight, uint256(), mapAssets, mapAssetAllocations, errorMessage, bSanity, bMiner);
+            good = CheckAssetInputs(tx, *pPayload, inputs, fJustCheck, nHeight, uint256(), mapAssets, mapAssetAllocations, errorMessage, bSanity, bMiner);
         }
         else if(IsPaydayCoinMintTx(tx.nVersion)) 
         {
@@ -337,7 +624,7 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
             }
             else{
                 errorMessage.clear();
-                good = CheckPaydayCoinMint(ibd, tx, errorMessage, fJustCheck, bSanity, bMiner, nHeight, uint256(), mapAssets, mapAssetAllocations, vecMintKeys, bTxRootError);
+                good = CheckPaydayCoinMint(ibd, tx, *pPayload, errorMessage, fJustCheck, bSanity, bMiner, nHeight, uint256(), mapAssets, mapAssetAllocations, vecMintKeys, bTxRootError);
             }
         }
   
@@ -353,10 +640,10 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
     else if (!block.vtx.empty()) {
         const uint256& blockHash = block.GetHash();
         std::vector<std::pair<uint256, uint256> > blockIndex;
+        std::vector<CAssetCheckResult> vecResults(block.vtx.size());
+        std::vector<unsigned int> vecAssetTxs;
         for (unsigned int i = 0; i < block.vtx.size(); i++)
         {
-
-            good = true;
             const CTransaction &tx = *(block.vtx[i]);    
             if(!bMiner && !fJustCheck && !bSanity){
                 const uint256& txHash = tx.GetHash(); 
@@ -366,32 +653,37 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
                 continue;
 
             if(!IsPaydayCoinTx(tx.nVersion))
-                continue;      
-            if (IsAssetAllocationTx(tx.nVersion))
-            {
-                errorMessage.clear();
-                // fJustCheck inplace of bSanity to preserve global structures from being changed during test calls, fJustCheck is actually passed in as false because we want to check in PoW mode
-                good = CheckAssetAllocationInputs(tx, inputs, false, nHeight, blockHash, mapAssetAllocations, vecLockedOutpoints, errorMessage, bOverflow, fJustCheck, bMiner);
-
-            }
-            else if (IsAssetTx(tx.nVersion))
-            {
-                errorMessage.clear();
-                good = CheckAssetInputs(tx, inputs, false, nHeight, blockHash, mapAssets, mapAssetAllocations, errorMessage, fJustCheck, bMiner);
-            } 
-            else if(IsPaydayCoinMintTx(tx.nVersion))
+                continue;
+            vecAssetTxs.push_back(i);
+        }
+        // transactions seen by the mempool were decoded on acceptance, only the others are decoded here and before the
+        // checks are split over the asset check threads, which must not take mempool.cs
+        std::vector<PaydayCoinTxPayloadRef> vecPayloads(block.vtx.size());
+        {
+            LOCK(mempool.cs);
+            for (const unsigned int &i: vecAssetTxs)
+                vecPayloads[i] = mempool.GetPaydayCoinPayload(block.vtx[i]->GetHash());
+        }
+        for (const unsigned int &i: vecAssetTxs)
+        {
+            if (!vecPayloads[i])
+                vecPayloads[i] = MakePaydayCoinTxPayload(*(block.vtx[i]));
+        }
+        // the per-tx zmq writers are order dependent so only split the block when they are not in use
+        const bool bParallel = nScriptCheckThreads && fConcurrentProcessing && !fZMQAsset && !fZMQAssetAllocation && vecAssetTxs.size() >= MIN_PARALLEL_ASSET_CHECK_TXS;
+        if(!bParallel || !CheckPaydayCoinInputsParallel(ibd, block, inputs, fJustCheck, nHeight, blockHash, bMiner, vecAssetTxs, vecPayloads, vecResults, mapAssets, mapAssetAllocations, vecMintKeys, vecLockedOutpoints, bOverflow, bTxRootError)){
+            for (const unsigned int &i: vecAssetTxs)
             {
-                if(nHeight <= Params().GetConsensus().nBridgeStartBlock){
-                    errorMessage = "Bridge is disabled until blockheight 51000";
-                    good = false;
-                }
-                else{
-                    errorMessage.clear();
-                    good = CheckPaydayCoinMint(ibd, tx, errorMessage, false, fJustCheck, bMiner, nHeight, blockHash, mapAssets, mapAssetAllocations, vecMintKeys, bTxRootError);
-                }
+                CAssetCheckResult &result = vecResults[i];
+                result.good = CheckPaydayCoinBlockTx(ibd, *(block.vtx[i]), *vecPayloads[i], inputs, fJustCheck, nHeight, blockHash, bMiner, mapAssets, mapAssetAllocations, vecMintKeys, vecLockedOutpoints, result.errorMessage, bOverflow, bTxRootError);
             }
-             
-                        
+        }
+        // outcome is decided in block order, the last asset transaction sets the result
+        for (const unsigned int &i: vecAssetTxs)
+        {
+            CAssetCheckResult &result = vecResults[i];
+            good = result.good;
+            errorMessage = std::move(result.errorMessage);
             if (!good)
             {
                 if (!errorMessage.empty()) {
@@ -399,7 +691,7 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
                     if(bMiner){
                         good = true;
                         errorMessage.clear();
-                        txsToRemove.push_back(tx.GetHash());
+                        txsToRemove.push_back(block.vtx[i]->GetHash());
                         continue;
                     }
                 }
@@ -409,10 +701,12 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
                         
         if(!bSanity && !fJustCheck){
             if(!bMiner && pblockindexdb){
-                if(!pblockindexdb->FlushWrite(blockIndex) || !passetallocationdb->Flush(mapAssetAllocations) || !passetdb->Flush(mapAssets) || !plockedoutpointsdb->FlushWrite(vecLockedOutpoints) || !pethereumtxmintdb->FlushWrite(vecMintKeys)){
-                    good = false;
-                    errorMessage = "Error flushing to asset dbs";
-                }
+                // the asset dbs are written with the chainstate, see StageAssetStateJournal()
+                passetallocationdb->WriteCache(mapAssetAllocations);
+                passetdb->WriteCache(mapAssets);
+                pblockindexdb->WriteBlockIndex(blockIndex);
+                plockedoutpointsdb->WriteLockedOutpoints(vecLockedOutpoints);
+                pethereumtxmintdb->WriteMintKeys(vecMintKeys);
             }
         }        
         if (!good || !errorMessage.empty()){
@@ -427,19 +721,24 @@ bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationSt
 
 void ResyncAssetAllocationStates(){ 
     int count = 0;
-     {
-        
-        vector<string> vecToRemoveMempoolBalances;
-        LOCK2(cs_main, mempool.cs);
-        LOCK(cs_assetallocation);
-        LOCK(cs_assetallocationarrival);
-        for (auto&indexObj : mempoolMapAssetBalances) {
+    int64_t nMedianTimePast;
+    {
+        LOCK(cs_main);
+        nMedianTimePast = ::ChainActive().Tip()->GetMedianTimePast();
+    }
+    // one shard at a time so mempool acceptance of senders in the other shards carries on
+    for (unsigned int nShard = 0; nShard < ZDAG_SHARDS; nShard++) {
+        vector<CAssetAllocationTupleKey> vecToRemoveMempoolBalances;
+        CZDAGShard& shard = zdagState.GetShard(nShard);
+        LOCK(mempool.cs);
+        LOCK_ZDAG_SHARD(shard);
+        for (auto&indexObj : shard.mapBalances) {
             vector<uint256> vecToRemoveArrivalTimes;
-            const string& strSenderTuple = indexObj.first;
+            const CAssetAllocationTupleKey& senderTupleKey = indexObj.first;
             // if no arrival time for this mempool balance, remove it
-            auto arrivalTimes = arrivalTimesMap.find(strSenderTuple);
-            if(arrivalTimes == arrivalTimesMap.end()){
-                vecToRemoveMempoolBalances.push_back(strSenderTuple);
+            auto arrivalTimes = shard.mapArrivalTimes.find(senderTupleKey);
+            if(arrivalTimes == shard.mapArrivalTimes.end()){
+                vecToRemoveMempoolBalances.push_back(senderTupleKey);
                 continue;
             }
             for(auto& arrivalTime: arrivalTimes->second){
@@ -449,81 +748,115 @@ void ResyncAssetAllocationStates(){
                 if (!txRef){
                     vecToRemoveArrivalTimes.push_back(txHash);
                 }
-                else if(!arrivalTime.first.IsNull() && ((::ChainActive().Tip()->GetMedianTimePast()*1000) - arrivalTime.second) > 1800000){
+                else if(!arrivalTime.first.IsNull() && ((nMedianTimePast*1000) - arrivalTime.second) > ZDAG_ARRIVAL_EXPIRY_MILLIS){
                     vecToRemoveArrivalTimes.push_back(txHash);
                 }
             }
             // if we are removing everything from arrivalTime map then might as well remove it from parent altogether
+            if(!vecToRemoveArrivalTimes.empty())
+                shard.MarkDirty(senderTupleKey);
             if(vecToRemoveArrivalTimes.size() >= arrivalTimes->second.size()){
-                arrivalTimesMap.erase(strSenderTuple);
-                vecToRemoveMempoolBalances.push_back(strSenderTuple);
+                shard.mapArrivalTimes.erase(arrivalTimes);
+                shard.mapSenderIndexes.erase(senderTupleKey);
+                vecToRemoveMempoolBalances.push_back(senderTupleKey);
             } 
             // otherwise remove the individual txids
             else{
+                auto senderIndex = shard.mapSenderIndexes.find(senderTupleKey);
                 for(auto &removeTxHash: vecToRemoveArrivalTimes){
                     arrivalTimes->second.erase(removeTxHash);
+                    if(senderIndex != shard.mapSenderIndexes.end())
+                        senderIndex->second.Remove(removeTxHash);
                 }
             }         
         }
         count+=vecToRemoveMempoolBalances.size();
         for(auto& senderTuple: vecToRemoveMempoolBalances){
-            mempoolMapAssetBalances.erase(senderTuple);
-            // also remove from assetAllocationConflicts
-            unordered_set<string>::const_iterator it = assetAllocationConflicts.find(senderTuple);
-            if (it != assetAllocationConflicts.end()) {
-                assetAllocationConflicts.erase(it);
-            }
+            shard.MarkDirty(senderTuple);
+            shard.mapBalances.erase(senderTuple);
+            // also remove from the conflicts
+            shard.setConflicts.erase(senderTuple);
         }       
     }   
     if(count > 0)
         LogPrint(BCLog::PDAY,"removeExpiredMempoolBalances removed %d expired asset allocation transactions from mempool balances\n", count);
 
 }
-bool ResetAssetAllocation(const string &senderStr, const uint256 &txHash, const bool &bMiner, const bool& bCheckExpiryOnly) {
+static std::atomic<bool> fAssetAllocationResyncRequested{false};
+void RequestAssetAllocationResync(){
+    fAssetAllocationResyncRequested = true;
+}
+void ExpireAssetAllocationArrivalTimes(){
+    if(fAssetAllocationResyncRequested.exchange(false))
+        ResyncAssetAllocationStates();
+    int64_t nMedianTimePast;
+    {
+        LOCK(cs_main);
+        if(!::ChainActive().Tip())
+            return;
+        nMedianTimePast = ::ChainActive().Tip()->GetMedianTimePast();
+    }
+    const int64_t nExpiredBefore = nMedianTimePast*1000 - ZDAG_ARRIVAL_EXPIRY_MILLIS;
+    int count = 0;
+    for (unsigned int nShard = 0; nShard < ZDAG_SHARDS; nShard++) {
+        CZDAGShard& shard = zdagState.GetShard(nShard);
+        // release the shard lock between slices so mempool acceptance is never held up for long
+        bool fMore = true;
+        while(fMore){
+            LOCK_ZDAG_SHARD(shard);
+            fMore = shard.ExpireArrivalTimes(nExpiredBefore, ZDAG_EXPIRY_SLICE, count);
+        }
+    }
+    if(count > 0)
+        LogPrint(BCLog::PDAY,"ExpireAssetAllocationArrivalTimes expired %d asset allocation arrival times\n", count);
+}
+bool ResetAssetAllocation(const CAssetAllocationTupleKey &senderKey, const uint256 &txHash, const bool &bMiner, const bool& bCheckExpiryOnly) {
 
 
     bool removeAllConflicts = true;
     if(!bMiner){
+        CZDAGShard& shard = zdagState.GetShard(senderKey);
         {
-            LOCK(cs_assetallocationarrival);
+            LOCK_ZDAG_SHARD(shard);
             // remove the conflict once we revert since it is assumed to be resolved on POW
-            auto arrivalTimes = arrivalTimesMap.find(senderStr);
+            auto arrivalTimes = shard.mapArrivalTimes.find(senderKey);
             
-            if(arrivalTimes != arrivalTimesMap.end()){
+            if(arrivalTimes != shard.mapArrivalTimes.end()){
                 // remove only if all arrival times are either expired (30 mins) or no more zdag transactions left for this sender
                 for(auto& arrivalTime: arrivalTimes->second){
                     // ensure mempool has the tx and its less than 30 mins old
                     if(bCheckExpiryOnly && !mempool.get(arrivalTime.first))
                         continue;
-                    if(!arrivalTime.first.IsNull() && ((::ChainActive().Tip()->GetMedianTimePast()*1000) - arrivalTime.second) <= 1800000){
+                    if(!arrivalTime.first.IsNull() && ((::ChainActive().Tip()->GetMedianTimePast()*1000) - arrivalTime.second) <= ZDAG_ARRIVAL_EXPIRY_MILLIS){
                         removeAllConflicts = false;
                         break;
                     }
                 }
             }
             if(removeAllConflicts){
-                if(arrivalTimes != arrivalTimesMap.end())
-                    arrivalTimesMap.erase(arrivalTimes);
-                unordered_set<string>::const_iterator it = assetAllocationConflicts.find(senderStr);
-                if (it != assetAllocationConflicts.end()) {
-                    assetAllocationConflicts.erase(it);
-                }   
+                shard.MarkDirty(senderKey);
+                if(arrivalTimes != shard.mapArrivalTimes.end())
+                    shard.mapArrivalTimes.erase(arrivalTimes);
+                shard.mapSenderIndexes.erase(senderKey);
+                shard.setConflicts.erase(senderKey);
             }
             else if(!bCheckExpiryOnly){
+                shard.MarkDirty(senderKey);
                 arrivalTimes->second.erase(txHash);
+                auto senderIndex = shard.mapSenderIndexes.find(senderKey);
+                if(senderIndex != shard.mapSenderIndexes.end())
+                    senderIndex->second.Remove(txHash);
                 if(arrivalTimes->second.size() <= 0)
                     removeAllConflicts = true;
             }
         }
         if(removeAllConflicts)
         {
-            LOCK(cs_assetallocation);
-            mempoolMapAssetBalances.erase(senderStr);
+            LOCK_ZDAG_SHARD(shard);
+            shard.MarkDirty(senderKey);
+            shard.mapBalances.erase(senderKey);
             if(!bCheckExpiryOnly){
-                unordered_set<string>::const_iterator it = assetAllocationConflicts.find(senderStr);
-                if (it != assetAllocationConflicts.end()) {
-                    assetAllocationConflicts.erase(it);
-                }  
+                shard.setConflicts.erase(senderKey);
             }
         }
     }
@@ -562,7 +895,7 @@ bool DisconnectMintAsset(const CTransaction &tx, AssetAllocationMap &mapAssetAll
     vecMintKeys.emplace_back(ethKey);  
     // recver
     const std::string &receiverTupleStr = mintPaydayCoin.assetAllocationTuple.ToString();
-    auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+    auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
     auto mapAssetAllocation = result1.first;
     const bool& mapAssetAllocationNotFound = result1.second;
     if(mapAssetAllocationNotFound){
@@ -584,21 +917,9 @@ bool DisconnectMintAsset(const CTransaction &tx, AssetAllocationMap &mapAssetAll
     else if(storedReceiverAllocationRef.nBalance == 0){
         storedReceiverAllocationRef.SetNull();
     }
-    if(fAssetIndex){
-        const uint256& txid = tx.GetHash();
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), mintPaydayCoin.assetAllocationTuple.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(mintPaydayCoin.assetAllocationTuple, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectMintAsset: Could not erase mint asset allocation from asset allocation index\n");
-            }
-            if(!passetindexdb->EraseIndexTXID(mintPaydayCoin.assetAllocationTuple.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectMintAsset: Could not erase mint asset allocation from asset index\n");
-            } 
-        }      
-    }    
     return true; 
 }
 bool DisconnectAssetAllocation(const CTransaction &tx, AssetAllocationMap &mapAssetAllocations){
-    const uint256& txid = tx.GetHash();
     CAssetAllocation theAssetAllocation(tx);
 
     const std::string &senderTupleStr = theAssetAllocation.assetAllocationTuple.ToString();
@@ -606,7 +927,7 @@ bool DisconnectAssetAllocation(const CTransaction &tx, AssetAllocationMap &mapAs
         LogPrint(BCLog::PDAY,"DisconnectAssetAllocation: Could not decode asset allocation\n");
         return false;
     }
-    auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(senderTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+    auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(senderTupleStr),  std::forward_as_tuple());
     auto mapAssetAllocation = result.first;
     const bool & mapAssetAllocationNotFound = result.second;
     if(mapAssetAllocationNotFound){
@@ -626,7 +947,7 @@ bool DisconnectAssetAllocation(const CTransaction &tx, AssetAllocationMap &mapAs
         const std::string &receiverTupleStr = receiverAllocationTuple.ToString();
         CAssetAllocation receiverAllocation;
         
-        auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+        auto result1 = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
         auto mapAssetAllocationReceiver = result1.first;
         const bool& mapAssetAllocationReceiverNotFound = result1.second;
         if(mapAssetAllocationReceiverNotFound){
@@ -650,31 +971,11 @@ bool DisconnectAssetAllocation(const CTransaction &tx, AssetAllocationMap &mapAs
         else if(storedReceiverAllocationRef.nBalance == 0){
             storedReceiverAllocationRef.SetNull();  
         }
-        if(fAssetIndex){
-            if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), receiverAllocationTuple.nAsset) != fAssetIndexGuids.end()){
-                if(!passetindexdb->EraseIndexTXID(receiverAllocationTuple, txid)){
-                    LogPrint(BCLog::PDAY,"DisconnectAssetAllocation: Could not erase receiver allocation from asset allocation index\n");
-                }
-                if(!passetindexdb->EraseIndexTXID(receiverAllocationTuple.nAsset, txid)){
-                    LogPrint(BCLog::PDAY,"DisconnectAssetAllocation: Could not erase receiver allocation from asset index\n");
-                }
-            }
-        }                                       
     }
-    if(fAssetIndex){
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), theAssetAllocation.assetAllocationTuple.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(theAssetAllocation.assetAllocationTuple, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetAllocation: Could not erase sender allocation from asset allocation index\n");
-            }
-            if(!passetindexdb->EraseIndexTXID(theAssetAllocation.assetAllocationTuple.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetAllocation: Could not erase sender allocation from asset index\n");
-            }
-        }     
-    }         
     return true; 
 }
-bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
-        bool fJustCheck, int nHeight, const uint256& blockhash, AssetAllocationMap &mapAssetAllocations, std::vector<COutPoint> &vecLockedOutpoints, string &errorMessage, bool& bOverflow, const bool &bSanityCheck, const bool &bMiner) {
+bool CheckAssetAllocationInputs(const CTransaction &tx, const CPaydayCoinTxPayload& payload, const CCoinsViewCache &inputs,
+        bool fJustCheck, int nHeight, const uint256& blockhash, AssetAllocationMap &mapAssetAllocations, std::vector<COutPoint> &vecLockedOutpoints, string &errorMessage, bool& bOverflow, const bool &bSanityCheck, const bool &bMiner, const int64_t &nZDAGArrivalTime) {
     if (passetallocationdb == nullptr)
         return false;
     const uint256 & txHash = tx.GetHash();
@@ -684,8 +985,8 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
             fJustCheck ? "JUSTCHECK" : "BLOCK");
             
 
-    // unserialize assetallocation from txn, check for valid
-    CAssetAllocation theAssetAllocation(tx);
+    // assetallocation unserialized from txn, check for valid
+    const CAssetAllocation &theAssetAllocation = payload.assetAllocation;
     if(theAssetAllocation.assetAllocationTuple.IsNull())
     {
         errorMessage = "PAYDAYCOIN_ASSET_ALLOCATION_CONSENSUS_ERROR ERRCODE: 1001 - " + _("Cannot unserialize data inside of this transaction relating to an assetallocation");
@@ -735,6 +1036,8 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
 
     const CWitnessAddress &user1 = theAssetAllocation.assetAllocationTuple.witnessAddress;
     const string & senderTupleStr = theAssetAllocation.assetAllocationTuple.ToString();
+    const CAssetAllocationTupleKey senderTupleKey(theAssetAllocation.assetAllocationTuple);
+    CZDAGShard& senderShard = zdagState.GetShard(senderTupleKey);
 
     CAssetAllocation dbAssetAllocation;
     AssetAllocationMap::iterator mapAssetAllocation;
@@ -747,7 +1050,7 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         }     
     }
     else{
-        auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(senderTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+        auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(senderTupleStr),  std::forward_as_tuple());
         mapAssetAllocation = result.first;
         const bool& mapAssetAllocationNotFound = result.second;
         
@@ -768,15 +1071,16 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         return error(errorMessage.c_str());
     }
         
-    AssetBalanceMap::iterator mapBalanceSender;
     CAmount mapBalanceSenderCopy;
     bool mapSenderMempoolBalanceNotFound = false;
     if(fJustCheck && !bSanityCheck){
-        LOCK(cs_assetallocation); 
-        auto result =  mempoolMapAssetBalances.emplace(std::piecewise_construct,  std::forward_as_tuple(senderTupleStr),  std::forward_as_tuple(std::move(storedSenderAllocationRef.nBalance))); 
-        mapBalanceSender = result.first;
+        LOCK_ZDAG_SHARD(senderShard);
+        // the sender is looked up again by key when writing back, receivers inserted below may move this entry
+        auto result =  senderShard.mapBalances.emplace(senderTupleKey, storedSenderAllocationRef.nBalance); 
         mapSenderMempoolBalanceNotFound = result.second;
-        mapBalanceSenderCopy = mapBalanceSender->second;
+        mapBalanceSenderCopy = result.first->second;
+        if(mapSenderMempoolBalanceNotFound)
+            senderShard.MarkDirty(senderTupleKey);
     }
     else
         mapBalanceSenderCopy = storedSenderAllocationRef.nBalance;     
@@ -820,9 +1124,9 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         if (mapBalanceSenderCopy < 0) {
             if(fJustCheck && !bSanityCheck)
             {
-                LOCK(cs_assetallocation); 
+                LOCK_ZDAG_SHARD(senderShard);
                 if(mapSenderMempoolBalanceNotFound){
-                    mempoolMapAssetBalances.erase(mapBalanceSender);
+                    senderShard.mapBalances.erase(senderTupleKey);
                 }
             }
             bOverflow = true;
@@ -832,7 +1136,7 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         if (!fJustCheck) {   
             const CAssetAllocationTuple receiverAllocationTuple(nAssetFromScript,  CWitnessAddress(0, vchFromString("burn")));
             const string& receiverTupleStr = receiverAllocationTuple.ToString();  
-            auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+            auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
             auto mapAssetAllocationReceiver = result.first;
             const bool& mapAssetAllocationReceiverNotFound = result.second;
             if(mapAssetAllocationReceiverNotFound){
@@ -845,9 +1149,9 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
             } 
             mapAssetAllocationReceiver->second.nBalance += nAmountFromScript;                        
         }else if (!bSanityCheck && !bMiner) {
-            LOCK(cs_assetallocationarrival);
+            LOCK_ZDAG_SHARD(senderShard);
             // add conflicting sender if using ZDAG
-            assetAllocationConflicts.insert(senderTupleStr);
+            senderShard.setConflicts.emplace(senderTupleKey, true);
         }
     }
 	else if (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_LOCK)
@@ -890,12 +1194,12 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         if (mapBalanceSenderCopy < 0) {
             if(fJustCheck && !bSanityCheck && !bMiner)
             {
-                LOCK(cs_assetallocationarrival);
+                LOCK_ZDAG_SHARD(senderShard);
                 // add conflicting sender
-                assetAllocationConflicts.insert(senderTupleStr);
+                senderShard.setConflicts.emplace(senderTupleKey, true);
                 // If we already have this transaction in the arrival map we must have already accepted it, so don't set to overflow.
                 // We return true so that the mempool doesn't remove this transaction erroneously
-                ArrivalTimesMap &arrivalTimes = arrivalTimesMap[senderTupleStr];
+                ArrivalTimesMap &arrivalTimes = senderShard.mapArrivalTimes[senderTupleKey];
                 ArrivalTimesMap::iterator it = arrivalTimes.find(txHash);
                 if (it != arrivalTimes.end()){
                     LogPrint(BCLog::PDAY, "PaydayCoin ZDAG transaction overflowed but already accepted in mempool, so this transaction acts as a no-op...\n");
@@ -904,9 +1208,9 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
             }
             if(fJustCheck && !bSanityCheck)
             {
-                LOCK(cs_assetallocation); 
+                LOCK_ZDAG_SHARD(senderShard);
                 if(mapSenderMempoolBalanceNotFound){
-                    mempoolMapAssetBalances.erase(mapBalanceSender);
+                    senderShard.mapBalances.erase(senderTupleKey);
                 }
             }
             bOverflow = true;            
@@ -918,9 +1222,9 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
             if (amountTuple.first == theAssetAllocation.assetAllocationTuple.witnessAddress) {
                 if(fJustCheck && !bSanityCheck)
                 {
-                    LOCK(cs_assetallocation); 
+                    LOCK_ZDAG_SHARD(senderShard);
                     if(mapSenderMempoolBalanceNotFound){
-                        mempoolMapAssetBalances.erase(mapBalanceSender);
+                        senderShard.mapBalances.erase(senderTupleKey);
                     }
                 }           
                 errorMessage = "PAYDAYCOIN_ASSET_ALLOCATION_CONSENSUS_ERROR: ERRCODE: 1022 - " + _("Cannot send an asset allocation to yourself");
@@ -929,11 +1233,12 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
         
             const CAssetAllocationTuple receiverAllocationTuple(theAssetAllocation.assetAllocationTuple.nAsset, amountTuple.first);
             const string &receiverTupleStr = receiverAllocationTuple.ToString();
-            AssetBalanceMap::iterator mapBalanceReceiver;
             AssetAllocationMap::iterator mapBalanceReceiverBlock;            
             if(fJustCheck && !bSanityCheck){
-                LOCK(cs_assetallocation);
-                auto result = mempoolMapAssetBalances.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(0));
+                const CAssetAllocationTupleKey receiverTupleKey(receiverAllocationTuple);
+                CZDAGShard& receiverShard = zdagState.GetShard(receiverTupleKey);
+                LOCK_ZDAG_SHARD(receiverShard);
+                auto result = receiverShard.mapBalances.emplace(receiverTupleKey, 0);
                 auto mapBalanceReceiver = result.first;
                 const bool& mapAssetAllocationReceiverNotFound = result.second;
                 if(mapAssetAllocationReceiverNotFound){
@@ -944,9 +1249,10 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
                 if(!bSanityCheck){
                     mapBalanceReceiver->second += amountTuple.second;
                 }
+                receiverShard.MarkDirty(receiverTupleKey);
             }  
             else{           
-                auto result =  mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+                auto result =  mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
                 auto mapBalanceReceiverBlock = result.first;
                 const bool& mapAssetAllocationReceiverBlockNotFound = result.second;
                 if(mapAssetAllocationReceiverBlockNotFound){
@@ -961,7 +1267,7 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
                 if(!fJustCheck){ 
                     // to remove mempool balances but need to check to ensure that all txid's from arrivalTimes are first gone before removing receiver mempool balance
                     // otherwise one can have a conflict as a sender and send himself an allocation and clear the mempool balance inadvertently
-                    ResetAssetAllocation(receiverTupleStr, txHash, bMiner);      
+                    ResetAssetAllocation(CAssetAllocationTupleKey(receiverAllocationTuple), txHash, bMiner);      
                 }     
             }
 
@@ -971,7 +1277,7 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
     // asset sends are the only ones confirming without PoW
     if(!fJustCheck){
         if (!bSanityCheck && tx.nVersion != PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_LOCK) {
-            ResetAssetAllocation(senderTupleStr, txHash, bMiner);
+            ResetAssetAllocation(senderTupleKey, txHash, bMiner);
            
         } 
         storedSenderAllocationRef.listSendingAllocationAmounts.clear();
@@ -981,7 +1287,7 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
 
         if(!bMiner) {   
             // send notification on pow, for zdag transactions this is the second notification meaning the zdag tx has been confirmed
-            passetallocationdb->WriteAssetAllocationIndex(tx, dbAsset, nHeight, blockhash);  
+            passetallocationdb->NotifyAssetAllocationUpdate(tx, dbAsset, nHeight, blockhash);  
             LogPrint(BCLog::PDAY,"CONNECTED ASSET ALLOCATION: op=%s assetallocation=%s hash=%s height=%d fJustCheck=%d\n",
                 assetAllocationFromTx(tx.nVersion).c_str(),
                 senderTupleStr.c_str(),
@@ -994,17 +1300,30 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
     else if(!bSanityCheck){
 		if(tx.nVersion != PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_LOCK)
         {
-            LOCK(cs_assetallocationarrival);
-            ArrivalTimesMap &arrivalTimes = arrivalTimesMap[senderTupleStr];
-            arrivalTimes[txHash] = GetTimeMillis();
+            LOCK_ZDAG_SHARD(senderShard);
+            ArrivalTimesMap &arrivalTimes = senderShard.mapArrivalTimes[senderTupleKey];
+            // the mempool stamps the arrival once so template ordering agrees with the sender state
+            const int64_t nArrivalTime = nZDAGArrivalTime > 0? nZDAGArrivalTime: GetTimeMillis();
+            arrivalTimes[txHash] = nArrivalTime;
+            // senders not queried yet are indexed from their arrival times on first use
+            auto senderIndex = senderShard.mapSenderIndexes.find(senderTupleKey);
+            if (senderIndex != senderShard.mapSenderIndexes.end())
+                senderIndex->second.Add(txHash, nArrivalTime, GetZDAGSendAmount(theAssetAllocation));
+            senderShard.QueueExpiry(senderTupleKey, txHash, nArrivalTime);
+            senderShard.MarkDirty(senderTupleKey);
         }
 
         // send a realtime notification on zdag, send another when pow happens (above)
-        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_SEND)
-            passetallocationdb->WriteAssetAllocationIndex(tx, dbAsset, nHeight, blockhash);
+        if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ALLOCATION_SEND){
+            passetallocationdb->NotifyAssetAllocationUpdate(tx, dbAsset, nHeight, blockhash);
+            // zdag sends are listed by the asset index before they confirm
+            if(!bMiner && g_assetindex)
+                g_assetindex->IndexUnconfirmedTransaction(tx, nHeight, blockhash);
+        }
         {
-            LOCK(cs_assetallocation);
-            mapBalanceSender->second = std::move(mapBalanceSenderCopy);
+            LOCK_ZDAG_SHARD(senderShard);
+            senderShard.mapBalances[senderTupleKey] = std::move(mapBalanceSenderCopy);
+            senderShard.MarkDirty(senderTupleKey);
         }
     }
      
@@ -1012,14 +1331,13 @@ bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &i
 }
 
 bool DisconnectAssetSend(const CTransaction &tx, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations){
-    const uint256 &txid = tx.GetHash();
     CAsset dbAsset;
     CAssetAllocation theAssetAllocation(tx);
     if(theAssetAllocation.assetAllocationTuple.IsNull()){
         LogPrint(BCLog::PDAY,"DisconnectAssetSend: Could not decode asset allocation in asset send\n");
         return false;
     } 
-    auto result  = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAssetAllocation.assetAllocationTuple.nAsset),  std::forward_as_tuple(std::move(emptyAsset)));
+    auto result  = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAssetAllocation.assetAllocationTuple.nAsset),  std::forward_as_tuple());
     auto mapAsset = result.first;
     const bool& mapAssetNotFound = result.second;
     if(mapAssetNotFound){
@@ -1036,7 +1354,7 @@ bool DisconnectAssetSend(const CTransaction &tx, AssetMap &mapAssets, AssetAlloc
         const CAssetAllocationTuple receiverAllocationTuple(theAssetAllocation.assetAllocationTuple.nAsset, amountTuple.first);
         const std::string &receiverTupleStr = receiverAllocationTuple.ToString();
         CAssetAllocation receiverAllocation;
-        auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+        auto result = mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
         auto mapAssetAllocation = result.first;
         const bool &mapAssetAllocationNotFound = result.second;
         if(mapAssetAllocationNotFound){
@@ -1059,27 +1377,7 @@ bool DisconnectAssetSend(const CTransaction &tx, AssetMap &mapAssets, AssetAlloc
             storedReceiverAllocationRef.SetNull();       
         }
         
-        if(fAssetIndex){
-            if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), receiverAllocationTuple.nAsset) != fAssetIndexGuids.end()){
-                if(!passetindexdb->EraseIndexTXID(receiverAllocationTuple, txid)){
-                    LogPrint(BCLog::PDAY,"DisconnectAssetSend: Could not erase receiver allocation from asset allocation index\n");
-                }
-                if(!passetindexdb->EraseIndexTXID(receiverAllocationTuple.nAsset, txid)){
-                    LogPrint(BCLog::PDAY,"DisconnectAssetSend: Could not erase receiver allocation from asset index\n");
-                } 
-            }
-        }                                             
     }     
-    if(fAssetIndex){
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), theAssetAllocation.assetAllocationTuple.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(theAssetAllocation.assetAllocationTuple, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetSend: Could not erase sender allocation from asset allocation index\n");
-            }
-            if(!passetindexdb->EraseIndexTXID(theAssetAllocation.assetAllocationTuple.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetSend: Could not erase sender allocation from asset index\n");
-            }
-        }     
-    }          
     return true;  
 }
 bool DisconnectAssetUpdate(const CTransaction &tx, AssetMap &mapAssets){
@@ -1090,7 +1388,7 @@ bool DisconnectAssetUpdate(const CTransaction &tx, AssetMap &mapAssets){
         LogPrint(BCLog::PDAY,"DisconnectAssetUpdate: Could not decode asset\n");
         return false;
     }
-    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple(std::move(emptyAsset)));
+    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple());
     auto mapAsset = result.first;
     const bool &mapAssetNotFound = result.second;
     if(mapAssetNotFound){
@@ -1111,14 +1409,6 @@ bool DisconnectAssetUpdate(const CTransaction &tx, AssetMap &mapAssets){
             return false;
         }                                          
     } 
-    if(fAssetIndex){
-        const uint256 &txid = tx.GetHash();
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), theAsset.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(theAsset.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetUpdate: Could not erase asset update from asset index\n");
-            }
-        }
-    }         
     return true;  
 }
 bool DisconnectAssetTransfer(const CTransaction &tx, AssetMap &mapAssets){
@@ -1129,7 +1419,7 @@ bool DisconnectAssetTransfer(const CTransaction &tx, AssetMap &mapAssets){
         LogPrint(BCLog::PDAY,"DisconnectAssetTransfer: Could not decode asset\n");
         return false;
     }
-    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple(std::move(emptyAsset)));
+    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple());
     auto mapAsset = result.first;
     const bool &mapAssetNotFound = result.second;
     if(mapAssetNotFound){
@@ -1143,14 +1433,6 @@ bool DisconnectAssetTransfer(const CTransaction &tx, AssetMap &mapAssets){
     // theAsset.witnessAddress  is enforced to be the sender of the transfer which was the owner at the time of transfer
     // so set it back to reverse the transfer
     storedSenderRef.witnessAddress = theAsset.witnessAddress;   
-    if(fAssetIndex){
-        const uint256 &txid = tx.GetHash();
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), theAsset.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(theAsset.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetTransfer: Could not erase asset update from asset index\n");
-            }
-        }
-    }         
     return true;  
 }
 bool DisconnectAssetActivate(const CTransaction &tx, AssetMap &mapAssets){
@@ -1161,7 +1443,7 @@ bool DisconnectAssetActivate(const CTransaction &tx, AssetMap &mapAssets){
         LogPrint(BCLog::PDAY,"DisconnectAssetActivate: Could not decode asset in asset activate\n");
         return false;
     }
-    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple(std::move(emptyAsset)));
+    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(theAsset.nAsset),  std::forward_as_tuple());
     auto mapAsset = result.first;
     const bool &mapAssetNotFound = result.second;
     if(mapAssetNotFound){
@@ -1173,17 +1455,9 @@ bool DisconnectAssetActivate(const CTransaction &tx, AssetMap &mapAssets){
         mapAsset->second = std::move(dbAsset);      
     }
     mapAsset->second.SetNull();  
-    if(fAssetIndex){
-        const uint256 &txid = tx.GetHash();
-        if(fAssetIndexGuids.empty() || std::find(fAssetIndexGuids.begin(), fAssetIndexGuids.end(), theAsset.nAsset) != fAssetIndexGuids.end()){
-            if(!passetindexdb->EraseIndexTXID(theAsset.nAsset, txid)){
-                LogPrint(BCLog::PDAY,"DisconnectAssetActivate: Could not erase asset activate from asset index\n");
-            }
-        }    
-    }       
     return true;  
 }
-bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
+bool CheckAssetInputs(const CTransaction &tx, const CPaydayCoinTxPayload& payload, const CCoinsViewCache &inputs,
         bool fJustCheck, int nHeight, const uint256& blockhash, AssetMap& mapAssets, AssetAllocationMap &mapAssetAllocations, string &errorMessage, const bool &bSanityCheck, const bool &bMiner) {
     if (passetdb == nullptr)
         return false;
@@ -1193,13 +1467,10 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
             ::ChainActive().Tip()->nHeight, txHash.ToString().c_str(),
             fJustCheck ? "JUSTCHECK" : "BLOCK");
 
-    // unserialize asset from txn, check for valid
-    CAsset theAsset;
-    CAssetAllocation theAssetAllocation;
-    vector<unsigned char> vchData;
-
-    int nDataOut;
-    if(!GetPaydayCoinData(tx, vchData, nDataOut) || (tx.nVersion != PAYDAYCOIN_TX_VERSION_ASSET_SEND && !theAsset.UnserializeFromData(vchData)) || (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND && !theAssetAllocation.UnserializeFromData(vchData)))
+    // asset unserialized from txn, check for valid
+    const CAsset &theAsset = payload.asset;
+    const CAssetAllocation &theAssetAllocation = payload.assetAllocation;
+    if(!payload.fValid)
     {
         errorMessage = "PAYDAYCOIN_ASSET_CONSENSUS_ERROR ERRCODE: 2000 - " + _("Cannot unserialize data inside of this transaction relating to an asset");
         return error(errorMessage.c_str());
@@ -1316,7 +1587,7 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
 
     CAsset dbAsset;
     const uint32_t &nAsset = tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_SEND ? theAssetAllocation.assetAllocationTuple.nAsset : theAsset.nAsset;
-    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(nAsset),  std::forward_as_tuple(std::move(emptyAsset)));
+    auto result = mapAssets.emplace(std::piecewise_construct,  std::forward_as_tuple(nAsset),  std::forward_as_tuple());
     auto mapAsset = result.first;
     const bool & mapAssetNotFound = result.second; 
     if (mapAssetNotFound)
@@ -1327,7 +1598,8 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
                 return error(errorMessage.c_str());
             }
             else
-                mapAsset->second = std::move(theAsset);      
+                // the shared payload cannot be moved from and assets are not copyable, activation is rare enough to decode again
+                mapAsset->second = CAsset(tx);      
         }
         else{
             if(tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ACTIVATE){
@@ -1446,7 +1718,7 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
                 CAssetAllocation receiverAllocation;
                 const CAssetAllocationTuple receiverAllocationTuple(theAssetAllocation.assetAllocationTuple.nAsset, amountTuple.first);
                 const string& receiverTupleStr = receiverAllocationTuple.ToString();
-                auto result =  mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple(std::move(emptyAllocation)));
+                auto result =  mapAssetAllocations.emplace(std::piecewise_construct,  std::forward_as_tuple(receiverTupleStr),  std::forward_as_tuple());
                 auto mapAssetAllocation = result.first;
                 const bool& mapAssetAllocationNotFound = result.second;
                
@@ -1466,7 +1738,7 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
             }
         }
         if (!bSanityCheck && !fJustCheck && !bMiner)
-            passetallocationdb->WriteAssetAllocationIndex(tx, storedSenderAssetRef, nHeight, blockhash);  
+            passetallocationdb->NotifyAssetAllocationUpdate(tx, storedSenderAssetRef, nHeight, blockhash);  
     }
     else if (tx.nVersion == PAYDAYCOIN_TX_VERSION_ASSET_ACTIVATE)
     {
@@ -1483,7 +1755,7 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
     storedSenderAssetRef.txHash = txHash;
     // write asset, if asset send, only write on pow since asset -> asset allocation is not 0-conf compatible
     if (!bSanityCheck && !fJustCheck && !bMiner) {
-        passetdb->WriteAssetIndex(tx, storedSenderAssetRef, nHeight, blockhash);
+        passetdb->NotifyAssetUpdate(tx, storedSenderAssetRef, nHeight, blockhash);
         LogPrint(BCLog::PDAY,"CONNECTED ASSET: tx=%s symbol=%d hash=%s height=%d fJustCheck=%d\n",
                 assetFromTx(tx.nVersion).c_str(),
                 nAsset,
@@ -1493,56 +1765,156 @@ bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs,
     }
     return true;
 }
-bool CBlockIndexDB::FlushErase(const std::vector<uint256> &vecTXIDs){
-    if(vecTXIDs.empty())
-        return true;
-
-    CDBBatch batch(*this);
+void CBlockIndexDB::WriteBlockIndex(const std::vector<std::pair<uint256, uint256> > &blockIndex){
+    for (const auto &pair : blockIndex) {
+        pending.Write(pair.first, pair.second);
+    }
+}
+void CBlockIndexDB::EraseBlockIndex(const std::vector<uint256> &vecTXIDs){
     for (const uint256 &txid : vecTXIDs) {
-        batch.Erase(txid);
+        pending.Erase(txid);
     }
-    LogPrint(BCLog::PDAY, "Flushing %d block index removals\n", vecTXIDs.size());
-    return WriteBatch(batch);
 }
-bool CBlockIndexDB::FlushWrite(const std::vector<std::pair<uint256, uint256> > &blockIndex){
-    if(blockIndex.empty())
+bool CBlockIndexDB::Flush(const std::vector<std::pair<uint256, uint256> > &blockIndex, const std::vector<uint256> &vecTXIDs, const bool fSync){
+    if(blockIndex.empty() && vecTXIDs.empty())
         return true;
     CDBBatch batch(*this);
+    for (const uint256 &txid : vecTXIDs) {
+        batch.Erase(txid);
+    }
     for (const auto &pair : blockIndex) {
         batch.Write(pair.first, pair.second);
     }
-    LogPrint(BCLog::PDAY, "Flush writing %d block indexes\n", blockIndex.size());
-    return WriteBatch(batch);
+    LogPrint(BCLog::PDAY, "Flushing %d block indexes (erased %d)\n", blockIndex.size(), vecTXIDs.size());
+    return WriteBatch(batch, fSync);
 }
-bool CLockedOutpointsDB::FlushErase(const std::vector<COutPoint> &lockedOutpoints) {
-	if (lockedOutpoints.empty())
-		return true;
-
-	CDBBatch batch(*this);
+/**
+ * Apply a journal to the asset dbs with synced writes, every write is idempotent so a journal may be applied more than once.
+ * The asset db goes last as its best block tells which journal the asset dbs are complete up to. The asset records are moved out of the journal
+ */
+static bool ApplyAssetStateJournal(CAssetStateJournal &journal){
+    AssetMap mapAssets(std::make_move_iterator(journal.vecAssets.begin()), std::make_move_iterator(journal.vecAssets.end()));
+    AssetAllocationMap mapAssetAllocations(std::make_move_iterator(journal.vecAssetAllocations.begin()), std::make_move_iterator(journal.vecAssetAllocations.end()));
+    return pblockindexdb->Flush(journal.blockIndex, journal.vecErasedBlockIndex, true) &&
+        plockedoutpointsdb->Flush(journal.vecLockedOutpoints, journal.vecUnlockedOutpoints, true) &&
+        pethereumtxmintdb->Flush(journal.vecMintKeys, journal.vecErasedMintKeys, true) &&
+        passetallocationdb->Flush(mapAssetAllocations, true) && passetdb->Flush(mapAssets, true, journal.blockHash);
+}
+void StageAssetStateJournal(const uint256& bestBlock, CCoinsViewDB& coinsdb, CAssetStateJournal& journal){
+    journal.SetNull();
+    if(!passetdb || !passetallocationdb)
+        return;
+    AssetMap mapAssets;
+    AssetAllocationMap mapAssetAllocations;
+    passetdb->GetDirtyCache(mapAssets);
+    passetallocationdb->GetDirtyCache(mapAssetAllocations);
+    pblockindexdb->GetPending(journal.blockIndex, journal.vecErasedBlockIndex);
+    plockedoutpointsdb->GetPending(journal.vecLockedOutpoints, journal.vecUnlockedOutpoints);
+    pethereumtxmintdb->GetPending(journal.vecMintKeys, journal.vecErasedMintKeys);
+    LogPrint(BCLog::PDAY, "Flushing asset caches, %d assets, %d asset allocations, %d block indexes, %d locked outpoints and %d ethereum tx mints\n",
+        mapAssets.size(), mapAssetAllocations.size(), journal.blockIndex.size() + journal.vecErasedBlockIndex.size(),
+        journal.vecLockedOutpoints.size() + journal.vecUnlockedOutpoints.size(), journal.vecMintKeys.size() + journal.vecErasedMintKeys.size());
+    // staged even when nothing changed so the best block of the asset db follows the chainstate
+    journal.blockHash = bestBlock;
+    journal.vecAssets.assign(std::make_move_iterator(mapAssets.begin()), std::make_move_iterator(mapAssets.end()));
+    journal.vecAssetAllocations.assign(std::make_move_iterator(mapAssetAllocations.begin()), std::make_move_iterator(mapAssetAllocations.end()));
+    CDataStream ssJournal(SER_DISK, CLIENT_VERSION);
+    ssJournal << journal;
+    coinsdb.SetAssetJournal(std::vector<unsigned char>(ssJournal.begin(), ssJournal.end()));
+}
+bool FlushAssetStateJournal(CAssetStateJournal& journal, CCoinsViewDB& coinsdb){
+    if(!passetdb || !passetallocationdb)
+        return true;
+    bool ret = true;
+    if(!journal.IsNull()){
+        // a crash from here on leaves the journal in the chainstate for ReplayAssetStateJournal()
+        ret = ApplyAssetStateJournal(journal);
+        // the asset dbs are synced so the journal is not needed anymore, losing this erase just applies it again
+        if(ret)
+            ret = coinsdb.EraseAssetJournal();
+    }
+    // until the asset dbs have the staged state the caches and pending writes keep serving it
+    if(ret){
+        pblockindexdb->ClearPending();
+        plockedoutpointsdb->ClearPending();
+        pethereumtxmintdb->ClearPending();
+    }
+    passetdb->EndFlushCache(ret);
+    passetallocationdb->EndFlushCache(ret);
+    return ret;
+}
+void AbortAssetStateJournal(CCoinsViewDB& coinsdb){
+    if(!passetdb || !passetallocationdb)
+        return;
+    coinsdb.SetAssetJournal(std::vector<unsigned char>());
+    passetdb->EndFlushCache(false);
+    passetallocationdb->EndFlushCache(false);
+}
+size_t GetAssetCacheUsage(){
+    if(!passetdb || !passetallocationdb)
+        return 0;
+    return passetdb->DynamicMemoryUsage() + passetallocationdb->DynamicMemoryUsage() +
+        pblockindexdb->DynamicMemoryUsage() + plockedoutpointsdb->DynamicMemoryUsage() + pethereumtxmintdb->DynamicMemoryUsage();
+}
+bool ReplayAssetStateJournal(CCoinsViewDB& coinsdb){
+    std::vector<unsigned char> vchJournal;
+    if(!coinsdb.ReadAssetJournal(vchJournal)){
+        // the asset dbs were completed by the last chainstate flush, unless they were written without it
+        uint256 assetBestBlock;
+        const uint256 bestBlock = coinsdb.GetBestBlock();
+        if(passetdb->ReadBestBlock(assetBestBlock) && assetBestBlock != bestBlock)
+            return error("%s: asset dbs at block %s do not match the chainstate best block %s", __func__, assetBestBlock.GetHex(), bestBlock.GetHex());
+        return true;
+    }
+    CAssetStateJournal journal;
+    try {
+        CDataStream ssJournal(vchJournal, SER_DISK, CLIENT_VERSION);
+        ssJournal >> journal;
+    } catch (const std::exception& e) {
+        return error("%s: failed to deserialize the asset state journal: %s", __func__, e.what());
+    }
+    // the journal is written with the coins of its block, anything else means the chainstate was changed behind our back
+    const uint256 bestBlock = coinsdb.GetBestBlock();
+    if(journal.blockHash != bestBlock)
+        return error("%s: asset state journal of block %s does not match the chainstate best block %s", __func__, journal.blockHash.GetHex(), bestBlock.GetHex());
+    LogPrintf("Replaying asset state journal for block %s\n", journal.blockHash.GetHex());
+    if(!ApplyAssetStateJournal(journal))
+        return error("%s: failed to replay asset state journal for block %s", __func__, journal.blockHash.GetHex());
+    return coinsdb.EraseAssetJournal();
+}
+void CLockedOutpointsDB::WriteLockedOutpoints(const std::vector<COutPoint> &lockedOutpoints) {
 	for (const auto &outpoint : lockedOutpoints) {
-		batch.Erase(outpoint);
+		if (outpoint.IsNull())
+			pending.Erase(outpoint);
+		else
+			pending.Write(outpoint, true);
 	}
-	LogPrint(BCLog::PDAY, "Flushing %d locked outpoints removals\n", lockedOutpoints.size());
-	return WriteBatch(batch);
 }
-bool CLockedOutpointsDB::FlushWrite(const std::vector<COutPoint> &lockedOutpoints) {
-	if (lockedOutpoints.empty())
+void CLockedOutpointsDB::EraseLockedOutpoints(const std::vector<COutPoint> &lockedOutpoints) {
+	for (const auto &outpoint : lockedOutpoints) {
+		pending.Erase(outpoint);
+	}
+}
+void CLockedOutpointsDB::GetPending(std::vector<COutPoint> &lockedOutpoints, std::vector<COutPoint> &unlockedOutpoints) const {
+	std::vector<std::pair<COutPoint, bool> > vecLocked;
+	pending.GetPending(vecLocked, unlockedOutpoints);
+	lockedOutpoints.reserve(lockedOutpoints.size() + vecLocked.size());
+	for (const auto &lockedPair : vecLocked) {
+		lockedOutpoints.push_back(lockedPair.first);
+	}
+}
+bool CLockedOutpointsDB::Flush(const std::vector<COutPoint> &lockedOutpoints, const std::vector<COutPoint> &unlockedOutpoints, const bool fSync) {
+	if (lockedOutpoints.empty() && unlockedOutpoints.empty())
 		return true;
 	CDBBatch batch(*this);
-	int write = 0;
-	int erase = 0;
+	for (const auto &outpoint : unlockedOutpoints) {
+		batch.Erase(outpoint);
+	}
 	for (const auto &outpoint : lockedOutpoints) {
-		if (outpoint.IsNull()) {
-			erase++;
-			batch.Erase(outpoint);
-		}
-		else {
-			write++;
-			batch.Write(outpoint, true);
-		}
+		batch.Write(outpoint, true);
 	}
-	LogPrint(BCLog::PDAY, "Flushing %d locked outpoints (erased %d, written %d)\n", lockedOutpoints.size(), erase, write);
-	return WriteBatch(batch);
+	LogPrint(BCLog::PDAY, "Flushing %d locked outpoints (erased %d, written %d)\n", lockedOutpoints.size() + unlockedOutpoints.size(), unlockedOutpoints.size(), lockedOutpoints.size());
+	return WriteBatch(batch, fSync);
 }
 bool CheckPaydayCoinLockedOutpoints(const CTransactionRef &tx, CValidationState& state) {
 	// PAYDAYCOIN
@@ -1589,10 +1961,17 @@ bool CheckPaydayCoinLockedOutpoints(const CTransactionRef &tx, CValidationState&
 	}
 	return true;
 }
+/** Height of the tx root the cursor is on, false past the last root */
+static bool GetTxRootHeight(CDBIterator &cursor, uint32_t &nHeight){
+    std::pair<char, CEthereumTxRootKey> key;
+    if(!cursor.Valid() || !cursor.GetKey(key) || key.first != DB_ETHEREUM_TX_ROOT)
+        return false;
+    nHeight = key.second.nHeight;
+    return true;
+}
 bool CEthereumTxRootsDB::PruneTxRoots(const uint32_t &fNewGethSyncHeight) {
     uint32_t fNewGethCurrentHeight = fGethCurrentHeight;
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->SeekToFirst();
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
     vector<uint32_t> vecHeightKeys;
     uint32_t nKey = 0;
     uint32_t cutoffHeight = 0;
@@ -1605,25 +1984,24 @@ bool CEthereumTxRootsDB::PruneTxRoots(const uint32_t &fNewGethSyncHeight) {
             LogPrint(BCLog::PDAY, "Nothing to prune fGethSyncHeight = %d\n", fNewGethSyncHeight);
             return true;
         }
+        // roots before the cutoff height are the front of the height range
+        for(pcursor->Seek(DB_ETHEREUM_TX_ROOT); GetTxRootHeight(*pcursor, nKey) && nKey < cutoffHeight; pcursor->Next())
+            vecHeightKeys.emplace_back(nKey);
+        // roots after the tip height passed in (re-org) are the back of it
+        pcursor->Seek(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(fNewGethSyncHeight + 1)));
+        for(; GetTxRootHeight(*pcursor, nKey); pcursor->Next())
+            vecHeightKeys.emplace_back(nKey);
+        // step back to the highest root that is kept
+        pcursor->Seek(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(fNewGethSyncHeight + 1)));
     }
-    std::vector<unsigned char> txPos;
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        try {
-            if(pcursor->GetKey(nKey)){
-                // if height is before cutoff height or after tip height passed in (re-org), remove the txroot from db
-                if (fNewGethSyncHeight > 0 && (nKey < cutoffHeight || nKey > fNewGethSyncHeight)) {
-                    vecHeightKeys.emplace_back(nKey);
-                }
-                else if(nKey > fNewGethCurrentHeight)
-                    fNewGethCurrentHeight = nKey;
-            }
-            pcursor->Next();
-        }
-        catch (std::exception &e) {
-            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
-        }
-    }
+    else
+        pcursor->Seek((char)(DB_ETHEREUM_TX_ROOT + 1));
+    if(pcursor->Valid())
+        pcursor->Prev();
+    else
+        pcursor->SeekToLast();
+    if(GetTxRootHeight(*pcursor, nKey) && nKey >= cutoffHeight && nKey > fNewGethCurrentHeight)
+        fNewGethCurrentHeight = nKey;
 
     {
         LOCK(cs_ethsyncheight);
@@ -1632,15 +2010,139 @@ bool CEthereumTxRootsDB::PruneTxRoots(const uint32_t &fNewGethSyncHeight) {
     }      
     return FlushErase(vecHeightKeys);
 }
+/** Root record as written by versions before ETHEREUM_TX_ROOTS_VERSION 2 */
+class CLegacyEthereumTxRoot {
+public:
+    std::vector<unsigned char> vchBlockHash;
+    std::vector<unsigned char> vchPrevHash;
+    std::vector<unsigned char> vchTxRoot;
+    std::vector<unsigned char> vchReceiptRoot;
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vchBlockHash);
+        READWRITE(vchPrevHash);
+        READWRITE(vchTxRoot);
+        READWRITE(vchReceiptRoot);
+    }
+    bool ToTxRoot(EthereumTxRoot &txRoot) const {
+        for(const auto* vch : {&vchBlockHash, &vchPrevHash, &vchTxRoot, &vchReceiptRoot}){
+            if(vch->size() != txRoot.hashBlock.size())
+                return false;
+        }
+        txRoot.hashBlock = uint256(vchBlockHash);
+        txRoot.hashPrevBlock = uint256(vchPrevHash);
+        txRoot.hashTxRoot = uint256(vchTxRoot);
+        txRoot.hashReceiptRoot = uint256(vchReceiptRoot);
+        return true;
+    }
+};
+bool CEthereumTxRootsDB::Upgrade(){
+    int nVersion = 0;
+    if(Read(DB_ETHEREUM_TX_ROOTS_VERSION, nVersion) && nVersion == ETHEREUM_TX_ROOTS_VERSION)
+        return true;
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+    uint32_t nHeight;
+    std::pair<char, CEthereumTxRootKey> key;
+    CLegacyEthereumTxRoot txRootLegacy;
+    EthereumTxRoot txRoot;
+    size_t nUpgraded = 0;
+    size_t nDropped = 0;
+    for(pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()){
+        boost::this_thread::interruption_point();
+        // version 0 keys are the bare 4 byte height, version 1 already used the prefixed big-endian keys
+        const bool fLegacyKey = pcursor->GetKeySize() == sizeof(uint32_t) && pcursor->GetKey(nHeight);
+        if(fLegacyKey)
+            batch.Erase(nHeight);
+        else if(nVersion == 1 && pcursor->GetKey(key) && key.first == DB_ETHEREUM_TX_ROOT)
+            nHeight = key.second.nHeight;
+        else
+            continue;
+        if(!pcursor->GetValue(txRootLegacy))
+            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+        // a root that is not a 32 byte hash could never match a mint, the audit asks the relayer for it again
+        if(txRootLegacy.ToTxRoot(txRoot)){
+            batch.Write(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(nHeight)), txRoot);
+            nUpgraded++;
+        }
+        else{
+            if(!fLegacyKey)
+                batch.Erase(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(nHeight)));
+            nDropped++;
+        }
+        if(batch.SizeEstimate() > (1 << 22)){
+            if(!WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
+    }
+    batch.Write(DB_ETHEREUM_TX_ROOTS_VERSION, ETHEREUM_TX_ROOTS_VERSION);
+    LogPrintf("Upgraded %d ethereum tx roots to version %d, dropped %d malformed roots\n", nUpgraded, ETHEREUM_TX_ROOTS_VERSION, nDropped);
+    return WriteBatch(batch, true);
+}
+bool CEthereumTxRootsDB::LoadRecentTxRoots(){
+    uint32_t nCurrentHeight = 0;
+    {
+        LOCK(cs_ethsyncheight);
+        nCurrentHeight = fGethCurrentHeight;
+    }
+    const uint32_t nFirstHeight = nCurrentHeight >= MAX_ETHEREUM_TX_ROOTS? nCurrentHeight - MAX_ETHEREUM_TX_ROOTS + 1: 0;
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    uint32_t nHeight;
+    EthereumTxRoot txRoot;
+    for(pcursor->Seek(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(nFirstHeight))); GetTxRootHeight(*pcursor, nHeight); pcursor->Next()){
+        boost::this_thread::interruption_point();
+        if(!pcursor->GetValue(txRoot))
+            return error("%s() : deserialize error", __PRETTY_FUNCTION__);
+        CacheTxRoot(nHeight, txRoot);
+    }
+    return true;
+}
 bool CEthereumTxRootsDB::Init(){
-    return PruneTxRoots(0);
+    return Upgrade() && PruneTxRoots(0) && LoadRecentTxRoots();
+}
+void CEthereumTxRootsDB::CacheTxRoot(const uint32_t &nHeight, const EthereumTxRoot &txRoot){
+    LOCK(cs_txroots);
+    std::pair<uint32_t, EthereumTxRoot> &slot = vecRecentTxRoots[nHeight % MAX_ETHEREUM_TX_ROOTS];
+    // an older root refetched by the audit must not evict a newer one sharing its slot
+    if(slot.second.IsNull() || slot.first <= nHeight){
+        slot.first = nHeight;
+        slot.second = txRoot;
+    }
+}
+void CEthereumTxRootsDB::UncacheTxRoot(const uint32_t &nHeight){
+    LOCK(cs_txroots);
+    std::pair<uint32_t, EthereumTxRoot> &slot = vecRecentTxRoots[nHeight % MAX_ETHEREUM_TX_ROOTS];
+    if(slot.first == nHeight)
+        slot.second.SetNull();
+}
+bool CEthereumTxRootsDB::ReadTxRoots(const uint32_t& nHeight, EthereumTxRoot& txRoot){
+    {
+        LOCK(cs_txroots);
+        const std::pair<uint32_t, EthereumTxRoot> &slot = vecRecentTxRoots[nHeight % MAX_ETHEREUM_TX_ROOTS];
+        if(slot.first == nHeight && !slot.second.IsNull()){
+            txRoot = slot.second;
+            return true;
+        }
+    }
+    return Read(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(nHeight)), txRoot);
+}
+void CEthereumTxRootsDB::InvalidateAudit(const uint32_t &nHeight){
+    AssertLockHeld(cs_audit);
+    // the link from the first audited root to the one before it is never checked, so roots below the range do not matter
+    if(nAuditedFrom > nAuditedTo || nHeight > nAuditedTo || nHeight < nAuditedFrom)
+        return;
+    if(nHeight == nAuditedFrom){
+        nAuditedFrom = 1;
+        nAuditedTo = 0;
+    }
+    else
+        nAuditedTo = nHeight - 1;
 }
 void CEthereumTxRootsDB::AuditTxRootDB(std::vector<std::pair<uint32_t, uint32_t> > &vecMissingBlockRanges){
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->SeekToFirst();
-    vector<uint32_t> vecHeightKeys;
-    uint32_t nKey = 0;
-    uint32_t nKeyIndex = 0;
+    LOCK(cs_audit);
     uint32_t nCurrentSyncHeight = 0;
     {
         LOCK(cs_ethsyncheight);
@@ -1650,107 +2152,151 @@ void CEthereumTxRootsDB::AuditTxRootDB(std::vector<std::pair<uint32_t, uint32_t>
     uint32_t nKeyCutoff = nCurrentSyncHeight - MAX_ETHEREUM_TX_ROOTS;
     if(nCurrentSyncHeight < MAX_ETHEREUM_TX_ROOTS)
         nKeyCutoff = 0;
-    std::vector<unsigned char> txPos;
-    std::map<uint32_t, EthereumTxRoot> mapTxRoots;
-    
-    // sort keys numerically
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        try {
-            if(!pcursor->GetKey(nKey)){
-                 pcursor->Next();
-                 continue;
-            }
-            EthereumTxRoot txRoot;
-            pcursor->GetValue(txRoot);
-            mapTxRoots.emplace(nKey, txRoot);
-            pcursor->Next();
-        }
-        catch (std::exception &e) {
-            return;
-        }
-    } 
-    while(mapTxRoots.size() < 2){
+    // the window up to nAuditedTo was already found contiguous, carry on from its last root
+    const bool fResume = nAuditedFrom <= nKeyCutoff && nKeyCutoff < nAuditedTo && nAuditedTo <= nCurrentSyncHeight;
+    // roots come back in height order, only the window consensus checks need is audited and one root is held at a time
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(fResume? nAuditedTo: nKeyCutoff)));
+    uint32_t nKeyIndex = 0;
+    EthereumTxRoot txRootPrev;
+    if(!GetTxRootHeight(*pcursor, nKeyIndex) || !pcursor->GetValue(txRootPrev)){
+        nAuditedFrom = 1;
+        nAuditedTo = 0;
+        if(fResume)
+            return AuditTxRootDB(vecMissingBlockRanges);
+        vecMissingBlockRanges.emplace_back(make_pair(nKeyCutoff, nCurrentSyncHeight));
+        return;
+    }
+    if(fResume && nKeyIndex != nAuditedTo){
+        nAuditedFrom = 1;
+        nAuditedTo = 0;
+        return AuditTxRootDB(vecMissingBlockRanges);
+    }
+    pcursor->Next();
+    uint32_t key = 0;
+    if(!fResume && !GetTxRootHeight(*pcursor, key)){
+        nAuditedFrom = 1;
+        nAuditedTo = 0;
         vecMissingBlockRanges.emplace_back(make_pair(nKeyCutoff, nCurrentSyncHeight));
         return;
     }
-    auto setIt = mapTxRoots.begin();
-    nKeyIndex = setIt->first;
-    setIt++;
     // we should have at least MAX_ETHEREUM_TX_ROOTS roots available from the tip for consensus checks
-    if(nCurrentSyncHeight >= MAX_ETHEREUM_TX_ROOTS && nKeyIndex > nKeyCutoff){
+    if(!fResume && nCurrentSyncHeight >= MAX_ETHEREUM_TX_ROOTS && nKeyIndex > nKeyCutoff){
         vecMissingBlockRanges.emplace_back(make_pair(nKeyCutoff, nKeyIndex-1));
     }
-    std::vector<unsigned char> vchPrevHash;
+    // track how far the roots stay contiguous and linked from the cutoff
+    const bool fFromCutoff = fResume || nKeyIndex == nKeyCutoff;
+    bool fContiguous = fFromCutoff;
+    const uint32_t nNewAuditedFrom = fResume? nAuditedFrom: nKeyCutoff;
+    uint32_t nNewAuditedTo = nKeyIndex;
     std::vector<uint32_t> vecRemoveKeys;
+    EthereumTxRoot txRoot;
     // find sequence gaps in sorted key set 
-    for (; setIt != mapTxRoots.end(); ++setIt){
-            const uint32_t &key = setIt->first;
+    for (; GetTxRootHeight(*pcursor, key); pcursor->Next()){
+            boost::this_thread::interruption_point();
+            if(!pcursor->GetValue(txRoot))
+                return;
             const uint32_t &nNextKeyIndex = nKeyIndex+1;
-            if (key != nNextKeyIndex && (key-1) >= nNextKeyIndex)
+            if (key != nNextKeyIndex && (key-1) >= nNextKeyIndex){
                 vecMissingBlockRanges.emplace_back(make_pair(nNextKeyIndex, key-1));
+                fContiguous = false;
+            }
             // if continious index we want to ensure hash chain is also continious
             else{
                 // if prevhash of prev txroot != hash of this tx root then request inconsistent roots again
-                const EthereumTxRoot &txRoot = setIt->second;
-                auto prevRootPair = std::prev(setIt);
-                const EthereumTxRoot &txRootPrev = prevRootPair->second;
-                if(txRoot.vchPrevHash != txRootPrev.vchBlockHash){
+                if(txRoot.hashPrevBlock != txRootPrev.hashBlock){
                     // get a range of -50 to +50 around effected tx root to minimize chance that you will be requesting 1 root at a time in a long range fork
                     // this is fine because relayer fetches 100 headers at a time anyway
                     vecMissingBlockRanges.emplace_back(make_pair(std::max(0,(int32_t)key-50), std::min((int32_t)key+50, (int32_t)nCurrentSyncHeight)));
                     vecRemoveKeys.push_back(key);
+                    fContiguous = false;
                 }
             }
-            nKeyIndex = key;   
+            if(fContiguous && key <= nCurrentSyncHeight)
+                nNewAuditedTo = key;
+            nKeyIndex = key;
+            std::swap(txRootPrev, txRoot);
     } 
+    if(fFromCutoff){
+        nAuditedFrom = nNewAuditedFrom;
+        nAuditedTo = nNewAuditedTo;
+    }
+    else{
+        nAuditedFrom = 1;
+        nAuditedTo = 0;
+    }
     if(!vecRemoveKeys.empty()){
         LogPrint(BCLog::PDAY, "Detected an %d inconsistent hash chains in Ethereum headers, removing...\n", vecRemoveKeys.size());
-        pethereumtxrootsdb->FlushErase(vecRemoveKeys);
+        FlushErase(vecRemoveKeys);
     }
 }
 bool CEthereumTxRootsDB::FlushErase(const std::vector<uint32_t> &vecHeightKeys){
     if(vecHeightKeys.empty())
         return true;
+    LOCK(cs_audit);
     const uint32_t &nFirst = vecHeightKeys.front();
     const uint32_t &nLast = vecHeightKeys.back();
     CDBBatch batch(*this);
     for (const auto &key : vecHeightKeys) {
-        batch.Erase(key);
+        batch.Erase(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(key)));
     }
     LogPrint(BCLog::PDAY, "Flushing, erasing %d ethereum tx roots, block range (%d-%d)\n", vecHeightKeys.size(), nFirst, nLast);
-    return WriteBatch(batch);
+    if(!WriteBatch(batch))
+        return false;
+    for (const auto &key : vecHeightKeys) {
+        UncacheTxRoot(key);
+        InvalidateAudit(key);
+    }
+    return true;
 }
 bool CEthereumTxRootsDB::FlushWrite(const EthereumTxRootMap &mapTxRoots){
     if(mapTxRoots.empty())
         return true;
+    LOCK(cs_audit);
     const uint32_t &nFirst = mapTxRoots.begin()->first;
     uint32_t nLast = nFirst;
     CDBBatch batch(*this);
     for (const auto &key : mapTxRoots) {
-        batch.Write(key.first, key.second);
+        batch.Write(std::make_pair(DB_ETHEREUM_TX_ROOT, CEthereumTxRootKey(key.first)), key.second);
         nLast = key.first;
     }
     LogPrint(BCLog::PDAY, "Flushing, writing %d ethereum tx roots, block range (%d-%d)\n", mapTxRoots.size(), nFirst, nLast);
-    return WriteBatch(batch);
+    if(!WriteBatch(batch))
+        return false;
+    for (const auto &key : mapTxRoots) {
+        CacheTxRoot(key.first, key.second);
+        InvalidateAudit(key.first);
+    }
+    return true;
 }
-bool CEthereumMintedTxDB::FlushWrite(const EthereumMintTxVec &vecMintKeys){
-    if(vecMintKeys.empty())
-        return true;
-    CDBBatch batch(*this);
+void CEthereumMintedTxDB::WriteMintKeys(const EthereumMintTxVec &vecMintKeys){
     for (const auto &key : vecMintKeys) {
-        batch.Write(key, true);
+        pending.Write(key, true);
+    }
+}
+void CEthereumMintedTxDB::EraseMintKeys(const EthereumMintTxVec &vecMintKeys){
+    for (const auto &key : vecMintKeys) {
+        pending.Erase(key);
+    }
+}
+void CEthereumMintedTxDB::GetPending(EthereumMintTxVec &vecMintKeys, EthereumMintTxVec &vecErasedMintKeys) const {
+    std::vector<std::pair<std::pair<uint64_t, uint32_t>, bool> > vecMinted;
+    pending.GetPending(vecMinted, vecErasedMintKeys);
+    vecMintKeys.reserve(vecMintKeys.size() + vecMinted.size());
+    for (const auto &mintPair : vecMinted) {
+        vecMintKeys.push_back(mintPair.first);
     }
-    LogPrint(BCLog::PDAY, "Flushing, writing %d ethereum tx mints\n", vecMintKeys.size());
-    return WriteBatch(batch);
 }
-bool CEthereumMintedTxDB::FlushErase(const EthereumMintTxVec &vecMintKeys){
-    if(vecMintKeys.empty())
+bool CEthereumMintedTxDB::Flush(const EthereumMintTxVec &vecMintKeys, const EthereumMintTxVec &vecErasedMintKeys, const bool fSync){
+    if(vecMintKeys.empty() && vecErasedMintKeys.empty())
         return true;
     CDBBatch batch(*this);
-    for (const auto &key : vecMintKeys) {
+    for (const auto &key : vecErasedMintKeys) {
         batch.Erase(key);
     }
-    LogPrint(BCLog::PDAY, "Flushing, erasing %d ethereum tx mints\n", vecMintKeys.size());
-    return WriteBatch(batch);
+    for (const auto &key : vecMintKeys) {
+        batch.Write(key, true);
+    }
+    LogPrint(BCLog::PDAY, "Flushing %d ethereum tx mints (erased %d)\n", vecMintKeys.size(), vecErasedMintKeys.size());
+    return WriteBatch(batch, fSync);
 }
\ No newline at end of file
@@ -8,51 +8,136 @@
 
 #include <primitives/transaction.h>
 #include <services/asset.h>
+#include <txmempool.h>
+/**
+ * Service payload of a PaydayCoin transaction, decoded once and shared read-only between mempool acceptance,
+ * the threaded mempool re-check, block assembly and block connection. Only the object matching the transaction
+ * version is decoded, fValid tells whether that succeeded.
+ */
+class CPaydayCoinTxPayload {
+public:
+    CAsset asset;
+    CAssetAllocation assetAllocation;
+    CMintPaydayCoin mintPaydayCoin;
+    bool fValid;
+    explicit CPaydayCoinTxPayload(const CTransaction& tx);
+    size_t DynamicMemoryUsage() const;
+};
+PaydayCoinTxPayloadRef MakePaydayCoinTxPayload(const CTransaction& tx);
+/** Connected and disconnected blocks only stage their changes, the db is written with the chainstate flush */
 class CBlockIndexDB : public CDBWrapper {
+private:
+    CServicePendingWrites<uint256, uint256> pending;
 public:
     CBlockIndexDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blockindex", nCacheSize, fMemory, fWipe) {}
     
     bool ReadBlockHash(const uint256& txid, uint256& block_hash){
+        const int nPending = pending.Get(txid, block_hash);
+        if(nPending >= 0)
+            return nPending == 1;
         return Read(txid, block_hash);
     } 
-    bool FlushWrite(const std::vector<std::pair<uint256, uint256> > &blockIndex);
-    bool FlushErase(const std::vector<uint256> &vecTXIDs);
+    void WriteBlockIndex(const std::vector<std::pair<uint256, uint256> > &blockIndex);
+    void EraseBlockIndex(const std::vector<uint256> &vecTXIDs);
+    void GetPending(std::vector<std::pair<uint256, uint256> > &blockIndex, std::vector<uint256> &vecTXIDs) const {
+        pending.GetPending(blockIndex, vecTXIDs);
+    }
+    void ClearPending() {
+        pending.Clear();
+    }
+    size_t DynamicMemoryUsage() const {
+        return pending.DynamicMemoryUsage();
+    }
+    bool Flush(const std::vector<std::pair<uint256, uint256> > &blockIndex, const std::vector<uint256> &vecTXIDs, const bool fSync = false);
 };
 class CLockedOutpointsDB : public CDBWrapper {
+private:
+    CServicePendingWrites<COutPoint, bool> pending;
 public:
 	CLockedOutpointsDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "lockedoutpoints", nCacheSize, fMemory, fWipe) {}
 
 	bool ReadOutpoint(const COutPoint& outpoint, bool& locked) {
+        const int nPending = pending.Get(outpoint, locked);
+        if(nPending >= 0)
+            return nPending == 1;
 		return Read(outpoint, locked);
 	}
-	bool FlushWrite(const std::vector<COutPoint> &lockedOutpoints);
-	bool FlushErase(const std::vector<COutPoint> &lockedOutpoints);
+	void WriteLockedOutpoints(const std::vector<COutPoint> &lockedOutpoints);
+	void EraseLockedOutpoints(const std::vector<COutPoint> &lockedOutpoints);
+    void GetPending(std::vector<COutPoint> &lockedOutpoints, std::vector<COutPoint> &unlockedOutpoints) const;
+    void ClearPending() {
+        pending.Clear();
+    }
+    size_t DynamicMemoryUsage() const {
+        return pending.DynamicMemoryUsage();
+    }
+	bool Flush(const std::vector<COutPoint> &lockedOutpoints, const std::vector<COutPoint> &unlockedOutpoints, const bool fSync = false);
 };
+/** Ethereum header commitments, the hashes are kept in the byte order the relayer sends them in */
 class EthereumTxRoot {
     public:
-    std::vector<unsigned char> vchBlockHash;
-    std::vector<unsigned char> vchPrevHash;
-    std::vector<unsigned char> vchTxRoot;
-    std::vector<unsigned char> vchReceiptRoot;
+    uint256 hashBlock;
+    uint256 hashPrevBlock;
+    uint256 hashTxRoot;
+    uint256 hashReceiptRoot;
     
     ADD_SERIALIZE_METHODS;
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {      
-        READWRITE(vchBlockHash);
-        READWRITE(vchPrevHash);
-        READWRITE(vchTxRoot);
-        READWRITE(vchReceiptRoot);
+        READWRITE(hashBlock);
+        READWRITE(hashPrevBlock);
+        READWRITE(hashTxRoot);
+        READWRITE(hashReceiptRoot);
     }
+    inline void SetNull() { hashBlock.SetNull(); hashPrevBlock.SetNull(); hashTxRoot.SetNull(); hashReceiptRoot.SetNull(); }
+    inline bool IsNull() const { return hashBlock.IsNull(); }
 };
 typedef std::unordered_map<uint32_t, EthereumTxRoot> EthereumTxRootMap;
+/**
+ * Tx roots are stored under [DB_ETHEREUM_TX_ROOT, height (BE)] so LevelDB keeps them in height order,
+ * [DB_ETHEREUM_TX_ROOTS_VERSION] holds the key layout the roots were written with.
+ */
+static const char DB_ETHEREUM_TX_ROOT = 'r';
+static const char DB_ETHEREUM_TX_ROOTS_VERSION = 'V';
+static const int ETHEREUM_TX_ROOTS_VERSION = 2;
+class CEthereumTxRootKey {
+public:
+    uint32_t nHeight;
+    explicit CEthereumTxRootKey(const uint32_t& nHeightIn = 0) : nHeight(nHeightIn) {}
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata32be(s, nHeight);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        nHeight = ser_readdata32be(s);
+    }
+};
 class CEthereumTxRootsDB : public CDBWrapper {
+private:
+    CCriticalSection cs_txroots;
+    /** Ring of the most recent roots, height % MAX_ETHEREUM_TX_ROOTS -> (height, root), null roots mark empty slots */
+    std::vector<std::pair<uint32_t, EthereumTxRoot> > vecRecentTxRoots;
+    /** Held by the audit and by writers, so writes cannot race the contiguous range the audit records */
+    CCriticalSection cs_audit;
+    /** Roots in [nAuditedFrom, nAuditedTo] were found present and hash linked by the last audit, empty if nAuditedFrom > nAuditedTo */
+    uint32_t nAuditedFrom;
+    uint32_t nAuditedTo;
+    /** A write or erase at nHeight means the links into nHeight have to be audited again */
+    void InvalidateAudit(const uint32_t &nHeight);
+    /** Rewrite roots of older versions under the big-endian keys and with fixed size hashes */
+    bool Upgrade();
+    /** Fill the ring from the roots on disk ending at fGethCurrentHeight */
+    bool LoadRecentTxRoots();
+    void CacheTxRoot(const uint32_t &nHeight, const EthereumTxRoot &txRoot);
+    void UncacheTxRoot(const uint32_t &nHeight);
 public:
-    CEthereumTxRootsDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "ethereumtxroots", nCacheSize, fMemory, fWipe) {
+    CEthereumTxRootsDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "ethereumtxroots", nCacheSize, fMemory, fWipe), vecRecentTxRoots(MAX_ETHEREUM_TX_ROOTS), nAuditedFrom(1), nAuditedTo(0) {
        Init();
     } 
-    bool ReadTxRoots(const uint32_t& nHeight, EthereumTxRoot& txRoot) {
-        return Read(nHeight, txRoot);
-    } 
+    /** Roots within MAX_ETHEREUM_TX_ROOTS of the latest header the relayer sent are served from memory */
+    bool ReadTxRoots(const uint32_t& nHeight, EthereumTxRoot& txRoot);
+    /** Report missing and unlinked roots in the consensus window, resuming after the range found contiguous by the previous audit */
     void AuditTxRootDB(std::vector<std::pair<uint32_t, uint32_t> > &vecMissingBlockRanges);
     bool Init();
     bool PruneTxRoots(const uint32_t &fNewGethSyncHeight);
@@ -61,19 +146,87 @@ public:
 };
 typedef std::vector<std::pair<uint64_t, uint32_t> > EthereumMintTxVec;
 class CEthereumMintedTxDB : public CDBWrapper {
+private:
+    CServicePendingWrites<std::pair<uint64_t, uint32_t>, bool> pending;
 public:
     CEthereumMintedTxDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "ethereumminttx", nCacheSize, fMemory, fWipe) {
     } 
     bool ExistsKey(const std::pair<uint64_t, uint32_t> &ethKey) {
+        bool fMinted;
+        const int nPending = pending.Get(ethKey, fMinted);
+        if(nPending >= 0)
+            return nPending == 1;
         return Exists(ethKey);
     } 
-    bool FlushErase(const EthereumMintTxVec &vecMintKeys);
-    bool FlushWrite(const EthereumMintTxVec &vecMintKeys);
+    void WriteMintKeys(const EthereumMintTxVec &vecMintKeys);
+    void EraseMintKeys(const EthereumMintTxVec &vecMintKeys);
+    void GetPending(EthereumMintTxVec &vecMintKeys, EthereumMintTxVec &vecErasedMintKeys) const;
+    void ClearPending() {
+        pending.Clear();
+    }
+    size_t DynamicMemoryUsage() const {
+        return pending.DynamicMemoryUsage();
+    }
+    bool Flush(const EthereumMintTxVec &vecMintKeys, const EthereumMintTxVec &vecErasedMintKeys, const bool fSync = false);
+};
+class CCoinsViewDB;
+/**
+ * Asset state changed since the last chainstate flush. It is written to the chainstate in the same batch as the coins
+ * of blockHash and stays there until the asset dbs it is applied to are synced, the asset db records blockHash last.
+ */
+class CAssetStateJournal {
+public:
+    uint256 blockHash;
+    std::vector<std::pair<uint256, uint256> > blockIndex;
+    std::vector<uint256> vecErasedBlockIndex;
+    std::vector<std::pair<int, CAsset> > vecAssets;
+    std::vector<std::pair<std::string, CAssetAllocation> > vecAssetAllocations;
+    std::vector<COutPoint> vecLockedOutpoints;
+    std::vector<COutPoint> vecUnlockedOutpoints;
+    EthereumMintTxVec vecMintKeys;
+    EthereumMintTxVec vecErasedMintKeys;
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(blockHash);
+        READWRITE(blockIndex);
+        READWRITE(vecErasedBlockIndex);
+        READWRITE(vecAssets);
+        READWRITE(vecAssetAllocations);
+        READWRITE(vecLockedOutpoints);
+        READWRITE(vecUnlockedOutpoints);
+        READWRITE(vecMintKeys);
+        READWRITE(vecErasedMintKeys);
+    }
+    inline void SetNull() { blockHash.SetNull(); blockIndex.clear(); vecErasedBlockIndex.clear(); vecAssets.clear(); vecAssetAllocations.clear(); vecLockedOutpoints.clear(); vecUnlockedOutpoints.clear(); vecMintKeys.clear(); vecErasedMintKeys.clear(); }
+    inline bool IsNull() const { return blockHash.IsNull(); }
 };
 extern std::unique_ptr<CBlockIndexDB> pblockindexdb;
 extern std::unique_ptr<CLockedOutpointsDB> plockedoutpointsdb;
 extern std::unique_ptr<CEthereumTxRootsDB> pethereumtxrootsdb;
 extern std::unique_ptr<CEthereumMintedTxDB> pethereumtxmintdb;
+/**
+ * Copy the dirty asset and allocation records and the pending writes of the other asset dbs into journal and hand it
+ * to the coins db, so the chainstate flush of bestBlock that follows writes it with the coins. Called from FlushStateToDisk.
+ */
+void StageAssetStateJournal(const uint256& bestBlock, CCoinsViewDB& coinsdb, CAssetStateJournal& journal);
+/**
+ * Apply a journal flushed with the chainstate to the asset dbs and drop it from the chainstate once they are synced.
+ * The caches and pending writes are only released after that.
+ */
+bool FlushAssetStateJournal(CAssetStateJournal& journal, CCoinsViewDB& coinsdb);
+/** The chainstate flush failed, keep serving the staged asset state from the caches */
+void AbortAssetStateJournal(CCoinsViewDB& coinsdb);
+size_t GetAssetCacheUsage();
+/** Default for -assetdbcache, maximum memory of the asset and asset allocation caches in MiB */
+static const int64_t DEFAULT_ASSET_DB_CACHE = 64;
+extern int64_t nAssetCacheUsage;
+/**
+ * Finish applying a journal left in the chainstate by an unclean shutdown, after ReplayBlocks() brought the coins to its
+ * block. Without a journal the best block of the asset db has to match the chainstate.
+ */
+bool ReplayAssetStateJournal(CCoinsViewDB& coinsdb);
 bool DisconnectPaydayCoinTransaction(const CTransaction& tx, const CBlockIndex* pindex, CCoinsViewCache& view, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys);
 bool DisconnectAssetActivate(const CTransaction &tx, AssetMap &mapAssets);
 bool DisconnectAssetSend(const CTransaction &tx, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations);
@@ -82,13 +235,32 @@ bool DisconnectAssetTransfer(const CTransaction &tx, AssetMap &mapAssets);
 bool DisconnectAssetAllocation(const CTransaction &tx, AssetAllocationMap &mapAssetAllocations);
 bool DisconnectMintAsset(const CTransaction &tx, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys);
 bool DisconnectMint(const CTransaction &tx, EthereumMintTxVec &vecMintKeys);
-bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, std::string& errorMessage, const bool &fJustCheck, const bool& bSanity, const bool& bMiner, const int& nHeight, const uint256& blockhash, AssetMap& mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, bool &bTxRootError);
-bool CheckAssetInputs(const CTransaction &tx, const CCoinsViewCache &inputs, bool fJustCheck, int nHeight, const uint256& blockhash, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, std::string &errorMessage, const bool &bSanityCheck=false, const bool &bMiner=false);
+/** Size in MiB of the cache of verified mint SPV proofs */
+static const unsigned int DEFAULT_ETHEREUM_PROOF_CACHE_SIZE = 1;
+/** Initializes the verified mint SPV proof cache, called once at startup */
+void InitEthereumProofCache();
+bool CheckPaydayCoinMint(const bool ibd, const CTransaction& tx, const CPaydayCoinTxPayload& payload, std::string& errorMessage, const bool &fJustCheck, const bool& bSanity, const bool& bMiner, const int& nHeight, const uint256& blockhash, AssetMap& mapAssets, AssetAllocationMap &mapAssetAllocations, EthereumMintTxVec &vecMintKeys, bool &bTxRootError);
+bool CheckAssetInputs(const CTransaction &tx, const CPaydayCoinTxPayload& payload, const CCoinsViewCache &inputs, bool fJustCheck, int nHeight, const uint256& blockhash, AssetMap &mapAssets, AssetAllocationMap &mapAssetAllocations, std::string &errorMessage, const bool &bSanityCheck=false, const bool &bMiner=false);
 static std::vector<uint256> DEFAULT_VECTOR;
-bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fJustCheck, bool &bOverflow, int nHeight, const CBlock& block, const bool &bSanity = false, const bool &bMiner = false, std::vector<uint256>& txsToRemove=DEFAULT_VECTOR);
-static CAssetAllocation emptyAllocation;
-bool ResetAssetAllocation(const std::string &senderStr, const uint256 &txHash, const bool &bMiner=false, const bool &bExpiryOnly=false);
+bool CheckPaydayCoinInputs(const bool ibd, const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fJustCheck, bool &bOverflow, int nHeight, const CBlock& block, const bool &bSanity = false, const bool &bMiner = false, std::vector<uint256>& txsToRemove=DEFAULT_VECTOR, const int64_t &nZDAGArrivalTime = 0, const CPaydayCoinTxPayload* pPayload = nullptr);
+/** Minimum number of asset transactions in a block before they are split across the asset check threads */
+static const unsigned int MIN_PARALLEL_ASSET_CHECK_TXS = 16;
+/** Outcome of checking one asset transaction of a block */
+struct CAssetCheckResult
+{
+    bool good = true;
+    std::string errorMessage;
+};
+/** Run an instance of the asset checking thread */
+void ThreadAssetCheck(int worker_num);
+bool ResetAssetAllocation(const CAssetAllocationTupleKey &senderKey, const uint256 &txHash, const bool &bMiner=false, const bool &bExpiryOnly=false);
 void ResyncAssetAllocationStates();
+/** Have the next ExpireAssetAllocationArrivalTimes run do a full ResyncAssetAllocationStates first */
+void RequestAssetAllocationResync();
+/** Drain expired arrivals off the ZDAG expiry wheels, run periodically from the scheduler */
+void ExpireAssetAllocationArrivalTimes();
+/** How often the scheduler drains the ZDAG expiry wheels */
+static const int64_t ZDAG_EXPIRY_INTERVAL_MILLIS = 5 * 1000;
 bool CheckPaydayCoinLockedOutpoints(const CTransactionRef &tx, CValidationState& state);
-bool CheckAssetAllocationInputs(const CTransaction &tx, const CCoinsViewCache &inputs, bool fJustCheck, int nHeight, const uint256& blockhash, AssetAllocationMap &mapAssetAllocations, std::vector<COutPoint> &vecLockedOutpoints, std::string &errorMessage, bool& bOverflow, const bool &bSanityCheck = false, const bool &bMiner = false);
+bool CheckAssetAllocationInputs(const CTransaction &tx, const CPaydayCoinTxPayload& payload, const CCoinsViewCache &inputs, bool fJustCheck, int nHeight, const uint256& blockhash, AssetAllocationMap &mapAssetAllocations, std::vector<COutPoint> &vecLockedOutpoints, std::string &errorMessage, bool& bOverflow, const bool &bSanityCheck = false, const bool &bMiner = false, const int64_t &nZDAGArrivalTime = 0);
 #endif // PAYDAYCOIN_SERVICES_ASSETCONSENSUS_H
@@ -4,45 +4,76 @@
 #include <base58.h>
 #include <validation.h>
 using namespace std;
-extern ArrivalTimesMapImpl arrivalTimesMap;
-extern CCriticalSection cs_assetallocationarrival;
-bool OrderBasedOnArrivalTime(std::vector<CTransactionRef>& blockVtx) {
+// stable LSD radix sort of (key, index) pairs, keys are arrival times relative to the earliest one so only the
+// low digits usually differ and the remaining passes are skipped
+static void RadixSortArrivals(std::vector<std::pair<uint64_t, unsigned int> >& vecArrivals, const uint64_t& nMaxKey) {
+	static const unsigned int RADIX_BITS = 11;
+	static const uint64_t RADIX_MASK = (1 << RADIX_BITS) - 1;
+	std::vector<std::pair<uint64_t, unsigned int> > vecScratch(vecArrivals.size());
+	std::vector<size_t> vecCounts(RADIX_MASK + 2);
+	for (unsigned int nShift = 0; nShift < 64 && (nMaxKey >> nShift) != 0; nShift += RADIX_BITS) {
+		std::fill(vecCounts.begin(), vecCounts.end(), 0);
+		for (const auto& arrival : vecArrivals)
+			vecCounts[((arrival.first >> nShift) & RADIX_MASK) + 1]++;
+		for (size_t i = 1; i < vecCounts.size(); i++)
+			vecCounts[i] += vecCounts[i - 1];
+		for (const auto& arrival : vecArrivals)
+			vecScratch[vecCounts[(arrival.first >> nShift) & RADIX_MASK]++] = arrival;
+		vecArrivals.swap(vecScratch);
+	}
+}
+bool OrderBasedOnArrivalTime(std::vector<CTransactionRef>& blockVtx, const std::vector<int64_t>& vecArrivalTimes, std::vector<unsigned int>& vecOrder) {
+	if (blockVtx.size() != vecArrivalTimes.size())
+	{
+		LogPrint(BCLog::PDAY, "OrderBasedOnArrivalTime: arrival time count does not match block transaction count! arrival time count %d vs block count %d\n", vecArrivalTimes.size(), blockVtx.size());
+		return false;
+	}
 	std::vector<CTransactionRef> orderedVtx;
-	AssertLockHeld(cs_main);
-	CCoinsViewCache view(pcoinsTip.get());
-	// order the arrival times in ascending order using a map
-	std::multimap<int64_t, int> orderedIndexes;
+	orderedVtx.reserve(blockVtx.size());
+	vecOrder.clear();
+	vecOrder.reserve(blockVtx.size());
+	std::vector<std::pair<uint64_t, unsigned int> > vecArrivals;
+	// we don't have these in our arrival times list, means they must be rejected via consensus so add them to the end
+	std::vector<unsigned int> vecNoArrivals;
+	int64_t nMinArrivalTime = std::numeric_limits<int64_t>::max();
 	for (unsigned int n = 0; n < blockVtx.size(); n++) {
-		const CTransactionRef txRef = blockVtx[n];
+		const CTransactionRef &txRef = blockVtx[n];
 		if (!txRef)
 			continue;
-		const CTransaction &tx = *txRef;
-		if (IsAssetAllocationTx(tx.nVersion))
+		if (IsAssetAllocationTx(txRef->nVersion))
 		{
-			LOCK(cs_assetallocationarrival);
-			
-			CAssetAllocation assetallocation(tx);
-			ArrivalTimesMap &arrivalTimes = arrivalTimesMap[assetallocation.assetAllocationTuple.ToString()];
-
-			ArrivalTimesMap::iterator it = arrivalTimes.find(tx.GetHash());
-			if (it != arrivalTimes.end())
-				orderedIndexes.insert(make_pair((*it).second, n));
-			// we don't have this in our arrival times list, means it must be rejected via consensus so add it to the end
-			else
-				orderedIndexes.insert(make_pair(INT64_MAX, n));
+			const int64_t &nArrivalTime = vecArrivalTimes[n];
+			if (nArrivalTime == std::numeric_limits<int64_t>::max())
+				vecNoArrivals.push_back(n);
+			else {
+				vecArrivals.emplace_back(nArrivalTime, n);
+				nMinArrivalTime = std::min(nMinArrivalTime, nArrivalTime);
+			}
 			continue;	
 		}
 		// add normal tx's to orderedvtx, 
 		orderedVtx.emplace_back(txRef);
+		vecOrder.push_back(n);
+	}
+	uint64_t nMaxKey = 0;
+	for (auto& arrival : vecArrivals) {
+		arrival.first = arrival.first - (uint64_t)nMinArrivalTime;
+		nMaxKey = std::max(nMaxKey, arrival.first);
+	}
+	RadixSortArrivals(vecArrivals, nMaxKey);
+	for (const auto& arrival : vecArrivals) {
+		orderedVtx.emplace_back(blockVtx[arrival.second]);
+		vecOrder.push_back(arrival.second);
 	}
-	for (auto& orderedIndex : orderedIndexes) {
-		orderedVtx.emplace_back(blockVtx[orderedIndex.second]);
+	for (const unsigned int& n : vecNoArrivals) {
+		orderedVtx.emplace_back(blockVtx[n]);
+		vecOrder.push_back(n);
 	}
 	if (blockVtx.size() != orderedVtx.size())
 	{
 		LogPrint(BCLog::PDAY, "OrderBasedOnArrivalTime: sorted block transaction count does not match unsorted block transaction count! sorted block count %d vs unsorted block count %d\n", orderedVtx.size(), blockVtx.size());
 		return false;
 	}
-	blockVtx = orderedVtx;
+	blockVtx = std::move(orderedVtx);
 	return true;
 }
@@ -3,5 +3,18 @@
 #include <vector>
 #include <primitives/transaction.h>
 
-bool OrderBasedOnArrivalTime(std::vector<CTransactionRef>& blockVtx);
+/**
+ * Move the asset allocation transactions of blockVtx to the end ordered by their cached ZDAG arrival times, vecArrivalTimes
+ * runs parallel to blockVtx. vecOrder receives the previous position of every transaction in the new order.
+ */
+bool OrderBasedOnArrivalTime(std::vector<CTransactionRef>& blockVtx, const std::vector<int64_t>& vecArrivalTimes, std::vector<unsigned int>& vecOrder);
+/** Reorder a vector that ran parallel to the block transactions the way OrderBasedOnArrivalTime() reordered them */
+template <typename T>
+void ApplyArrivalTimeOrder(const std::vector<unsigned int>& vecOrder, std::vector<T>& vec) {
+	std::vector<T> vecOrdered;
+	vecOrdered.reserve(vecOrder.size());
+	for (const unsigned int& n : vecOrder)
+		vecOrdered.emplace_back(std::move(vec[n]));
+	vec = std::move(vecOrdered);
+}
 #endif // PAYDAYCOIN_SERVICES_GRAPH_H
\ No newline at end of file
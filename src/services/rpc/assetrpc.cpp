@@ -9,6 +9,7 @@
 #include <services/assetconsensus.h>
 #include <services/rpc/assetrpc.h>
 #include <chainparams.h>
+#include <index/assetindex.h>
 #include <rpc/server.h>
 #include <validationinterface.h>
 using namespace std;
@@ -19,7 +20,6 @@ extern UniValue ValueFromAmount(const CAmount& amount);
 extern UniValue DescribeAddress(const CTxDestination& dest);
 extern std::string EncodeHexTx(const CTransaction& tx, const int serializeFlags = 0);
 extern bool DecodeHexTx(CMutableTransaction& tx, const std::string& hex_tx, bool try_no_witness = false, bool try_witness = true);
-extern std::unordered_set<std::string> assetAllocationConflicts;
 // PAYDAYCOIN service rpc functions
 extern UniValue sendrawtransaction(const JSONRPCRequest& request);
 using namespace std;
@@ -195,6 +195,28 @@ UniValue tpstestinfo(const JSONRPCRequest& request) {
 	oTPSTestResults.__pushKV("receivers", oTPSTestReceiversMempool);
 	return oTPSTestResults;
 }
+UniValue getzdaglockstats(const JSONRPCRequest& request) {
+	const UniValue &params = request.params;
+	if (request.fHelp || 0 != params.size())
+		throw runtime_error("getzdaglockstats\n"
+			"Gets lock contention counters of the sharded ZDAG mempool state\n"
+			"\nResult:\n"
+			"{\n"
+			"  \"shards\":     (numeric) Number of independently locked ZDAG shards\n"
+			"  \"locks\":      (numeric) Shard lock acquisitions since startup\n"
+			"  \"contended\":  (numeric) Shard lock acquisitions that had to wait for another thread\n"
+			"}\n"
+			"\nExamples:\n"
+			+ HelpExampleCli("getzdaglockstats", "")
+			+ HelpExampleRpc("getzdaglockstats", ""));
+	uint64_t nLocks, nLocksContended;
+	zdagState.GetLockStats(nLocks, nLocksContended);
+	UniValue oLockStats(UniValue::VOBJ);
+	oLockStats.__pushKV("shards", (int)ZDAG_SHARDS);
+	oLockStats.__pushKV("locks", nLocks);
+	oLockStats.__pushKV("contended", nLocksContended);
+	return oLockStats;
+}
 UniValue tpstestsetenabled(const JSONRPCRequest& request) {
 	const UniValue &params = request.params;
 	if (request.fHelp || 1 != params.size())
@@ -554,10 +576,17 @@ UniValue assetallocationsenderstatus(const JSONRPCRequest& request) {
 	const CAssetAllocationTuple assetAllocationTupleSender(nAsset, CWitnessAddress(witnessVersion, ParseHex(witnessProgramHex)));
     {
         LOCK2(cs_main, mempool.cs);
-        ResetAssetAllocation(assetAllocationTupleSender.ToString(), txid, false, true);
+        const CAssetAllocationTupleKey senderTupleKey(assetAllocationTupleSender);
+        ResetAssetAllocation(senderTupleKey, txid, false, true);
         
     	int nStatus = ZDAG_STATUS_OK;
-    	if (assetAllocationConflicts.find(assetAllocationTupleSender.ToString()) != assetAllocationConflicts.end())
+    	bool fConflict;
+    	{
+    	    CZDAGShard& shard = zdagState.GetShard(senderTupleKey);
+    	    LOCK_ZDAG_SHARD(shard);
+    	    fConflict = shard.setConflicts.count(senderTupleKey) > 0;
+    	}
+    	if (fConflict)
     		nStatus = ZDAG_MAJOR_CONFLICT;
     	else
     		nStatus = DetectPotentialAssetAllocationSenderConflicts(assetAllocationTupleSender, txid);
@@ -1061,9 +1090,11 @@ UniValue listassetindex(const JSONRPCRequest& request) {
                 + HelpExampleRpc("listassetindex", "2, '{\"asset_guid\":92922, \"address\":\"sys1qw40fdue7g7r5ugw0epzk7xy24tywncm26hu4a7\"}'")
             }
         }.ToString());
-    if(!fAssetIndex){
+    if(!g_assetindex){
         throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 1510 - " + _("You must start paydaycoin with -assetindex enabled"));
     }
+    // results are only as recent as the block the index has caught up to, see getassetindexinfo while it is syncing
+    g_assetindex->BlockUntilSyncedToCurrentChain();
     UniValue options;
     int64_t page = params[0].get_int64();
    
@@ -1074,10 +1105,39 @@ UniValue listassetindex(const JSONRPCRequest& request) {
     options = params[1];
     
     UniValue oRes(UniValue::VARR);
-    if (!passetindexdb->ScanAssetIndex(page, options, oRes))
+    if (!ScanAssetIndex(page, options, oRes))
         throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 1510 - " + _("Scan failed"));
     return oRes;
 }
+UniValue getassetindexinfo(const JSONRPCRequest& request) {
+    const UniValue &params = request.params;
+    if (request.fHelp || 0 != params.size())
+        throw runtime_error(
+            RPCHelpMan{"getassetindexinfo",
+            "\nReturn the sync state of the asset index, which is built in the background after startup. Requires assetindex config parameter enabled.\n",
+            {},
+            RPCResult{
+                 "{\n"
+                 "  \"synced\":            (boolean) Whether the index has caught up with the chain tip\n"
+                 "  \"best_block_height\": (numeric) Height of the last block indexed, -1 if none\n"
+                 "  \"best_block_hash\":   (string) Hash of the last block indexed\n"
+                 "}\n"
+            },
+            RPCExamples{
+                HelpExampleCli("getassetindexinfo", "")
+                + HelpExampleRpc("getassetindexinfo", "")
+            }
+        }.ToString());
+    if(!g_assetindex){
+        throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 1510 - " + _("You must start paydaycoin with -assetindex enabled"));
+    }
+    const CBlockIndex* pindexBest = g_assetindex->GetBestBlockIndex();
+    UniValue oRes(UniValue::VOBJ);
+    oRes.__pushKV("synced", g_assetindex->IsSynced());
+    oRes.__pushKV("best_block_height", pindexBest ? pindexBest->nHeight : -1);
+    oRes.__pushKV("best_block_hash", pindexBest ? pindexBest->GetBlockHash().GetHex() : uint256().GetHex());
+    return oRes;
+}
 UniValue listassetindexassets(const JSONRPCRequest& request) {
     const UniValue &params = request.params;
     if (request.fHelp || 1 != params.size())
@@ -1259,6 +1319,16 @@ UniValue paydaycoinsetethstatus(const JSONRPCRequest& request) {
     }    
     return ret;
 }
+/** Parse an optionally 0x prefixed 32 byte Ethereum hash, the bytes are kept in the order given */
+static bool ParseEthereumHash(const UniValue& value, uint256& hash) {
+    string strHash = value.get_str();
+    boost::erase_all(strHash, "0x");  // strip 0x
+    const std::vector<unsigned char> &vchHash = ParseHex(strHash);
+    if(vchHash.size() != hash.size())
+        return false;
+    hash = uint256(vchHash);
+    return true;
+}
 UniValue paydaycoinsetethheaders(const JSONRPCRequest& request) {
     const UniValue &params = request.params;
     if (request.fHelp || 1 != params.size())
@@ -1294,25 +1364,16 @@ UniValue paydaycoinsetethheaders(const JSONRPCRequest& request) {
 
     EthereumTxRootMap txRootMap;       
     const UniValue &headerArray = params[0].get_array();
-    
+    txRootMap.reserve(headerArray.size());
     for(size_t i =0;i<headerArray.size();i++){
         EthereumTxRoot txRoot;
         const UniValue &tupleArray = headerArray[i].get_array();
         if(tupleArray.size() != 5)
             throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2512 - " + _("Invalid size in a blocknumber/txroots input, should be size of 5"));
         const uint32_t &nHeight = (uint32_t)tupleArray[0].get_int();
-        string blockHash = tupleArray[1].get_str();
-        boost::erase_all(blockHash, "0x");  // strip 0x
-        txRoot.vchBlockHash = ParseHex(blockHash);
-        string prevHash = tupleArray[2].get_str();
-        boost::erase_all(prevHash, "0x");  // strip 0x
-        txRoot.vchPrevHash = ParseHex(prevHash);
-        string txRootStr = tupleArray[3].get_str();
-        boost::erase_all(txRootStr, "0x");  // strip 0x
-        txRoot.vchTxRoot = ParseHex(txRootStr);
-        string txReceiptRoot = tupleArray[4].get_str();
-        boost::erase_all(txReceiptRoot, "0x");  // strip 0x
-        txRoot.vchReceiptRoot = ParseHex(txReceiptRoot);
+        if(!ParseEthereumHash(tupleArray[1], txRoot.hashBlock) || !ParseEthereumHash(tupleArray[2], txRoot.hashPrevBlock) ||
+            !ParseEthereumHash(tupleArray[3], txRoot.hashTxRoot) || !ParseEthereumHash(tupleArray[4], txRoot.hashReceiptRoot))
+            throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2512 - " + _("Invalid hash in a blocknumber/txroots input, should be 32 bytes of hex"));
         txRootMap.emplace(std::piecewise_construct,  std::forward_as_tuple(nHeight),  std::forward_as_tuple(txRoot));
     } 
     bool res = pethereumtxrootsdb->FlushWrite(txRootMap);
@@ -1320,6 +1381,49 @@ UniValue paydaycoinsetethheaders(const JSONRPCRequest& request) {
     ret.__pushKV("status", res? "success": "fail");
     return ret;
 }
+// height (4 bytes little endian) followed by the block hash, previous hash, tx root and receipt root (32 bytes each)
+static const size_t ETHEREUM_HEADER_RECORD_SIZE = 4 + 4 * 32;
+UniValue paydaycoinsetethheadersraw(const JSONRPCRequest& request) {
+    const UniValue &params = request.params;
+    if (request.fHelp || 1 != params.size())
+        throw runtime_error(
+            RPCHelpMan{"paydaycoinsetethheadersraw",
+                "\nSets Ethereum headers in PaydayCoin to validate transactions through the PDAYX bridge, in the compact binary form relayers use while catching up.\n",
+                {
+                    {"headers", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "Concatenated 132 byte headers, each a block number (4 bytes little endian) followed by block hash, previous hash, tx root and receipt root (32 bytes each)"}
+                },
+                RPCResult{
+                "{\n"
+                "    \"status\": xx     (string) Result\n"
+                "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("paydaycoinsetethheadersraw", "\"307b6b00d8ac75c7b4084c85a89d6e28219ff162661efb8b794d4b66e6e9ea52b4139b10...\"")
+                    + HelpExampleRpc("paydaycoinsetethheadersraw", "\"307b6b00d8ac75c7b4084c85a89d6e28219ff162661efb8b794d4b66e6e9ea52b4139b10...\"")
+                }
+            }.ToString());
+
+    const std::string &strHeaders = params[0].get_str();
+    if(!IsHex(strHeaders))
+        throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2512 - " + _("Headers must be hex encoded"));
+    const std::vector<unsigned char> &vchHeaders = ParseHex(strHeaders);
+    if(vchHeaders.size() % ETHEREUM_HEADER_RECORD_SIZE != 0)
+        throw runtime_error("PAYDAYCOIN_ASSET_RPC_ERROR: ERRCODE: 2512 - " + _("Invalid headers length, should be a multiple of 132 bytes"));
+    const size_t nHeaders = vchHeaders.size() / ETHEREUM_HEADER_RECORD_SIZE;
+    EthereumTxRootMap txRootMap;
+    txRootMap.reserve(nHeaders);
+    VectorReader reader(SER_NETWORK, PROTOCOL_VERSION, vchHeaders, 0);
+    for(size_t i = 0; i < nHeaders; i++){
+        uint32_t nHeight;
+        EthereumTxRoot txRoot;
+        reader >> nHeight >> txRoot;
+        txRootMap.emplace(nHeight, txRoot);
+    }
+    bool res = pethereumtxrootsdb->FlushWrite(txRootMap);
+    UniValue ret(UniValue::VOBJ);
+    ret.__pushKV("status", res? "success": "fail");
+    return ret;
+}
  
 UniValue paydaycoingettxroots(const JSONRPCRequest& request)
 {
@@ -1343,17 +1447,16 @@ UniValue paydaycoingettxroots(const JSONRPCRequest& request)
             }.ToString());
     }
     int nHeight = request.params[0].get_int();
-    std::pair<std::vector<unsigned char>,std::vector<unsigned char>> vchTxRoots;
     EthereumTxRoot txRootDB;
     if(!pethereumtxrootsdb || !pethereumtxrootsdb->ReadTxRoots(nHeight, txRootDB)){
        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Could not read transaction roots");
     }
       
     UniValue ret(UniValue::VOBJ);  
-    ret.pushKV("blockhash", HexStr(txRootDB.vchBlockHash)); 
-    ret.pushKV("prevhash", HexStr(txRootDB.vchPrevHash)); 
-    ret.pushKV("txroot", HexStr(txRootDB.vchTxRoot));
-    ret.pushKV("receiptroot", HexStr(txRootDB.vchReceiptRoot));
+    ret.pushKV("blockhash", HexStr(txRootDB.hashBlock.begin(), txRootDB.hashBlock.end())); 
+    ret.pushKV("prevhash", HexStr(txRootDB.hashPrevBlock.begin(), txRootDB.hashPrevBlock.end())); 
+    ret.pushKV("txroot", HexStr(txRootDB.hashTxRoot.begin(), txRootDB.hashTxRoot.end()));
+    ret.pushKV("receiptroot", HexStr(txRootDB.hashReceiptRoot.begin(), txRootDB.hashReceiptRoot.end()));
     
     return ret;
 } 
@@ -1377,13 +1480,16 @@ static const CRPCCommand commands[] =
     { "paydaycoin",            "listassetallocations",             &listassetallocations,          {"count","from","options"} },
     { "paydaycoin",            "listassetallocationmempoolbalances",             &listassetallocationmempoolbalances,          {"count","from","options"} },
     { "paydaycoin",            "listassetindex",                   &listassetindex,                {"page","options"} },
+    { "paydaycoin",            "getassetindexinfo",                &getassetindexinfo,             {} },
     { "paydaycoin",            "listassetindexassets",             &listassetindexassets,          {"address"} },
     { "paydaycoin",            "listassetindexallocations",        &listassetindexallocations,     {"address"} },
     { "paydaycoin",            "tpstestinfo",                      &tpstestinfo,                   {} },
+    { "paydaycoin",            "getzdaglockstats",                 &getzdaglockstats,              {} },
     { "paydaycoin",            "tpstestadd",                       &tpstestadd,                    {"starttime","rawtxs"} },
     { "paydaycoin",            "tpstestsetenabled",                &tpstestsetenabled,             {"enabled"} },
     { "paydaycoin",            "paydaycoinsetethstatus",              &paydaycoinsetethstatus,           {"syncing_status","highestBlock"} },
     { "paydaycoin",            "paydaycoinsetethheaders",             &paydaycoinsetethheaders,          {"headers"} },
+    { "paydaycoin",            "paydaycoinsetethheadersraw",          &paydaycoinsetethheadersraw,       {"headers"} },
     { "paydaycoin",            "paydaycoinstopgeth",                  &paydaycoinstopgeth,               {} },
     { "paydaycoin",            "paydaycoinstartgeth",                 &paydaycoinstartgeth,              {} },
 };
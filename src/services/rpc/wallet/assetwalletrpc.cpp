@@ -20,8 +20,6 @@ extern UniValue ValueFromAmount(const CAmount& amount);
 extern UniValue DescribeAddress(const CTxDestination& dest);
 extern std::string EncodeHexTx(const CTransaction& tx, const int serializeFlags = 0);
 extern bool DecodeHexTx(CMutableTransaction& tx, const std::string& hex_tx, bool try_no_witness = false, bool try_witness = true);
-extern ArrivalTimesMapImpl arrivalTimesMap; 
-extern CCriticalSection cs_assetallocationarrival;
 extern CAmount GetMinimumFee(const CWallet& wallet, unsigned int nTxBytes, const CCoinControl& coin_control, FeeCalculation* feeCalc);
 extern bool IsDust(const CTxOut& txout, const CFeeRate& dustRelayFee);
 extern CAmount AssetAmountFromValue(UniValue& value, int precision);
@@ -965,9 +963,11 @@ UniValue assetallocationsendmany(const JSONRPCRequest& request) {
 	}
     
     {
-        LOCK(cs_assetallocationarrival);
+        const CAssetAllocationTupleKey assetAllocationTupleKey(assetAllocationTuple);
+        CZDAGShard& shard = zdagState.GetShard(assetAllocationTupleKey);
+        LOCK_ZDAG_SHARD(shard);
     	// check to see if a transaction for this asset/address tuple has arrived before minimum latency period
-    	const ArrivalTimesMap &arrivalTimes = arrivalTimesMap[assetAllocationTuple.ToString()];
+    	const ArrivalTimesMap &arrivalTimes = shard.mapArrivalTimes[assetAllocationTupleKey];
     	const int64_t & nNow = GetTimeMillis();
     	int minLatency = ZDAG_MINIMUM_LATENCY_SECONDS * 1000;
     	if (fUnitTest)
@@ -1044,9 +1044,11 @@ UniValue assetallocationburn(const JSONRPCRequest& request) {
 	if (!GetAssetAllocation(assetAllocationTuple, theAssetAllocation))
 		throw runtime_error("PAYDAYCOIN_ASSET_ALLOCATION_RPC_ERROR: ERRCODE: 1500 - " + _("Could not find a asset allocation with this key"));
     {
-        LOCK(cs_assetallocationarrival);
+        const CAssetAllocationTupleKey assetAllocationTupleKey(assetAllocationTuple);
+        CZDAGShard& shard = zdagState.GetShard(assetAllocationTupleKey);
+        LOCK_ZDAG_SHARD(shard);
         // check to see if a transaction for this asset/address tuple has arrived before minimum latency period
-        const ArrivalTimesMap &arrivalTimes = arrivalTimesMap[assetAllocationTuple.ToString()];
+        const ArrivalTimesMap &arrivalTimes = shard.mapArrivalTimes[assetAllocationTupleKey];
         const int64_t & nNow = GetTimeMillis();
         int minLatency = ZDAG_MINIMUM_LATENCY_SECONDS * 1000;
         if (fUnitTest)
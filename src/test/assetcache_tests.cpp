@@ -0,0 +1,177 @@
+// Copyright (c) 2017-2018 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <services/asset.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+typedef CServiceRecordCache<int, CAsset, CAssetCacheTraits> AssetRecordCache;
+
+static void MakeAsset(const uint32_t nAsset, const CAmount nBalance, CAsset& asset)
+{
+    asset.nAsset = nAsset;
+    asset.strSymbol = "TEST";
+    asset.nBalance = nBalance;
+    asset.nTotalSupply = nBalance;
+    asset.nMaxSupply = nBalance;
+}
+
+BOOST_FIXTURE_TEST_SUITE(assetcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(assetcache_read_through)
+{
+    AssetRecordCache cache;
+    CAsset asset;
+    uint64_t nGeneration;
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), -1);
+
+    // a db hit is served from memory afterwards
+    CAsset dbAsset;
+    MakeAsset(1, 100, dbAsset);
+    cache.Add(1, &dbAsset, nGeneration);
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), 1);
+    BOOST_CHECK_EQUAL(asset.nBalance, 100);
+    BOOST_CHECK_EQUAL(asset.strSymbol, "TEST");
+
+    // a db miss is remembered
+    BOOST_CHECK_EQUAL(cache.Get(2, asset, nGeneration), -1);
+    cache.Add(2, nullptr, nGeneration);
+    BOOST_CHECK_EQUAL(cache.Get(2, asset, nGeneration), 0);
+    BOOST_CHECK(cache.DynamicMemoryUsage() > 0);
+
+    // clean entries are never written back
+    AssetMap mapAssets;
+    cache.GetDirty(mapAssets);
+    cache.EndFlush(true);
+    BOOST_CHECK(mapAssets.empty());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(assetcache_write_back)
+{
+    AssetRecordCache cache;
+    CAsset asset;
+    uint64_t nGeneration;
+    // 1 is unknown to the db, 2 is missing and 3 exists
+    BOOST_CHECK_EQUAL(cache.Get(2, asset, nGeneration), -1);
+    cache.Add(2, nullptr, nGeneration);
+    CAsset dbAsset;
+    MakeAsset(3, 50, dbAsset);
+    BOOST_CHECK_EQUAL(cache.Get(3, asset, nGeneration), -1);
+    cache.Add(3, &dbAsset, nGeneration);
+
+    AssetMap mapBlock;
+    MakeAsset(1, 10, mapBlock[1]);
+    // created and erased again without the db ever seeing it
+    mapBlock[2].nAsset = 2;
+    // erased
+    mapBlock[3].nAsset = 3;
+    cache.Write(mapBlock);
+    BOOST_CHECK(mapBlock.empty());
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), 1);
+    BOOST_CHECK_EQUAL(asset.nBalance, 10);
+    BOOST_CHECK_EQUAL(cache.Get(2, asset, nGeneration), 0);
+    BOOST_CHECK_EQUAL(cache.Get(3, asset, nGeneration), 0);
+
+    AssetMap mapAssets;
+    cache.GetDirty(mapAssets);
+    BOOST_CHECK_EQUAL(mapAssets.size(), 2U);
+    BOOST_CHECK(mapAssets.count(1) && !mapAssets[1].IsNull());
+    BOOST_CHECK(mapAssets.count(3) && mapAssets[3].IsNull());
+
+    // the dirty records are served until the db has them, reads racing the db write are not cached
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), 1);
+    BOOST_CHECK_EQUAL(asset.nBalance, 10);
+    BOOST_CHECK_EQUAL(cache.Get(4, asset, nGeneration), -1);
+    cache.Add(4, nullptr, nGeneration);
+    cache.EndFlush(true);
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), -1);
+    BOOST_CHECK_EQUAL(cache.Get(4, asset, nGeneration), -1);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(assetcache_failed_write)
+{
+    AssetRecordCache cache;
+    CAsset asset;
+    uint64_t nGeneration;
+    AssetMap mapBlock;
+    MakeAsset(1, 10, mapBlock[1]);
+    cache.Write(mapBlock);
+
+    // a failed db write keeps the dirty records for the next flush
+    AssetMap mapAssets;
+    cache.GetDirty(mapAssets);
+    BOOST_CHECK_EQUAL(mapAssets.size(), 1U);
+    cache.EndFlush(false);
+    BOOST_CHECK_EQUAL(cache.Get(1, asset, nGeneration), 1);
+    BOOST_CHECK_EQUAL(asset.nBalance, 10);
+    mapAssets.clear();
+    cache.GetDirty(mapAssets);
+    BOOST_CHECK_EQUAL(mapAssets.size(), 1U);
+    BOOST_CHECK_EQUAL(mapAssets[1].nBalance, 10);
+    cache.EndFlush(true);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(assetcache_dirty_scan)
+{
+    AssetRecordCache cache;
+    CAsset asset;
+    uint64_t nGeneration;
+    CAsset dbAsset;
+    MakeAsset(2, 50, dbAsset);
+    BOOST_CHECK_EQUAL(cache.Get(2, asset, nGeneration), -1);
+    cache.Add(2, &dbAsset, nGeneration);
+    AssetMap mapBlock;
+    MakeAsset(1, 10, mapBlock[1]);
+    mapBlock[3].nAsset = 3;
+    cache.Write(mapBlock);
+
+    // clean records are left to the db scan, erased ones are reported so the scan can skip them
+    std::map<int, bool> mapSeen;
+    cache.ForEachDirty([&](const int& nAsset, const CAsset& record) {
+        mapSeen[nAsset] = record.IsNull();
+    });
+    BOOST_CHECK_EQUAL(mapSeen.size(), 2U);
+    BOOST_CHECK(mapSeen.count(1) && !mapSeen[1]);
+    BOOST_CHECK(mapSeen.count(3) && mapSeen[3]);
+}
+
+BOOST_AUTO_TEST_CASE(assetcache_pending_writes)
+{
+    CServicePendingWrites<uint256, uint256> pending;
+    const uint256 txid1 = InsecureRand256(), txid2 = InsecureRand256(), txid3 = InsecureRand256();
+    const uint256 blockhash = InsecureRand256();
+    uint256 value;
+    BOOST_CHECK_EQUAL(pending.Get(txid1, value), -1);
+
+    pending.Write(txid1, blockhash);
+    pending.Write(txid2, blockhash);
+    pending.Erase(txid3);
+    // a later change of the same key replaces the earlier one
+    pending.Erase(txid2);
+    BOOST_CHECK_EQUAL(pending.Get(txid1, value), 1);
+    BOOST_CHECK(value == blockhash);
+    BOOST_CHECK_EQUAL(pending.Get(txid2, value), 0);
+    BOOST_CHECK_EQUAL(pending.Get(txid3, value), 0);
+    BOOST_CHECK(pending.DynamicMemoryUsage() > 0);
+
+    std::vector<std::pair<uint256, uint256> > vecWrites;
+    std::vector<uint256> vecErases;
+    pending.GetPending(vecWrites, vecErases);
+    BOOST_CHECK_EQUAL(vecWrites.size(), 1U);
+    BOOST_CHECK(vecWrites[0].first == txid1 && vecWrites[0].second == blockhash);
+    BOOST_CHECK_EQUAL(vecErases.size(), 2U);
+
+    pending.Clear();
+    BOOST_CHECK_EQUAL(pending.Get(txid1, value), -1);
+    BOOST_CHECK_EQUAL(pending.Get(txid2, value), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
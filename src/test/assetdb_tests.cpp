@@ -0,0 +1,65 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <services/asset.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(assetdb_tests, BasicTestingSetup)
+
+static void AddAllocation(AssetAllocationMap& mapAssetAllocations, const uint32_t nAsset, const CWitnessAddress& witnessAddress, const CAmount nBalance)
+{
+    CAssetAllocation& allocation = mapAssetAllocations[CAssetAllocationTuple(nAsset, witnessAddress).ToString()];
+    allocation.assetAllocationTuple = CAssetAllocationTuple(nAsset, witnessAddress);
+    allocation.nBalance = nBalance;
+}
+
+BOOST_AUTO_TEST_CASE(assetdb_owner_index)
+{
+    CAssetAllocationDB db(0, true, false);
+    BOOST_CHECK(CheckAssetKeyLayout(db));
+    BOOST_CHECK(CheckAssetKeyLayout(db));
+
+    const CWitnessAddress owner(0, std::vector<unsigned char>(WITNESS_V0_KEYHASH_SIZE, 0x01));
+    const CWitnessAddress other(0, std::vector<unsigned char>(WITNESS_V0_KEYHASH_SIZE, 0x02));
+    AssetAllocationMap mapAssetAllocations;
+    // guids whose little-endian order differs from their numeric order
+    for (const uint32_t nAsset : {0x100u, 0x2u, 0x10000u})
+        AddAllocation(mapAssetAllocations, nAsset, owner, 5);
+    AddAllocation(mapAssetAllocations, 0x2u, other, 7);
+    BOOST_CHECK(db.Flush(mapAssetAllocations));
+
+    std::vector<uint32_t> assetGuids;
+    BOOST_CHECK(db.ReadAssetsByAddress(owner, assetGuids));
+    BOOST_CHECK(assetGuids == std::vector<uint32_t>({0x2u, 0x100u, 0x10000u}));
+    BOOST_CHECK(db.ReadAssetsByAddress(other, assetGuids));
+    BOOST_CHECK(assetGuids == std::vector<uint32_t>({0x2u}));
+    BOOST_CHECK(db.ExistsAssetsByAddress(other));
+
+    // an emptied allocation leaves the owner range of its address
+    mapAssetAllocations.clear();
+    AddAllocation(mapAssetAllocations, 0x2u, other, 0);
+    AddAllocation(mapAssetAllocations, 0x100u, owner, 0);
+    BOOST_CHECK(db.Flush(mapAssetAllocations));
+    BOOST_CHECK(!db.ExistsAssetsByAddress(other));
+    BOOST_CHECK(db.ReadAssetsByAddress(owner, assetGuids));
+    BOOST_CHECK(assetGuids == std::vector<uint32_t>({0x2u, 0x10000u}));
+
+    CAssetAllocation allocation;
+    BOOST_CHECK(db.ReadAssetAllocation(CAssetAllocationTuple(0x10000u, owner), allocation));
+    BOOST_CHECK_EQUAL(allocation.nBalance, 5);
+    BOOST_CHECK(!db.ReadAssetAllocation(CAssetAllocationTuple(0x2u, other), allocation));
+}
+
+BOOST_AUTO_TEST_CASE(assetdb_legacy_layout)
+{
+    CAssetDB db(0, true, false);
+    // a record of the old layout, keyed by the raw guid
+    BOOST_CHECK(db.Write((uint32_t)1, std::string("asset")));
+    BOOST_CHECK(!CheckAssetKeyLayout(db));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
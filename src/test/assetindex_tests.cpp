@@ -0,0 +1,59 @@
+// Copyright (c) 2019 The PaydayCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/assetindex.h>
+#include <services/asset.h>
+#include <util/system.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(assetindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(assetindex_paging)
+{
+    // never started, so nothing but the calls below touches the in-memory database
+    AssetIndex db(1 << 20, true);
+    const CAssetAllocationTuple allocationTuple(1, CWitnessAddress(0, std::vector<unsigned char>(WITNESS_V0_KEYHASH_SIZE, 0x01)));
+    std::vector<uint256> vecAsset, vecAllocation;
+    std::vector<uint256> TXIDS;
+    BOOST_CHECK(db.ReadIndexTXIDs(1, 0, TXIDS) && TXIDS.empty());
+    BOOST_CHECK(!db.ReadIndexTXIDs(1, 1, TXIDS));
+    // interleave two assets and an allocation, each keeps its own dense sequence
+    for (int i = 0; i < 2 * fAssetIndexPageSize + 10; i++) {
+        vecAsset.push_back(InsecureRand256());
+        BOOST_CHECK(db.AppendIndexTXID(1, vecAsset.back()));
+        BOOST_CHECK(db.AppendIndexTXID(2, InsecureRand256()));
+        if (i % 2 == 0) {
+            vecAllocation.push_back(vecAsset.back());
+            BOOST_CHECK(db.AppendIndexTXID(allocationTuple, vecAllocation.back()));
+        }
+    }
+    // indexing a txid twice for the same owner is a no-op
+    BOOST_CHECK(db.AppendIndexTXID(1, vecAsset.back()));
+
+    BOOST_CHECK(db.ReadIndexTXIDs(1, 0, TXIDS));
+    BOOST_CHECK(TXIDS == std::vector<uint256>(vecAsset.end() - fAssetIndexPageSize, vecAsset.end()));
+    BOOST_CHECK(db.ReadIndexTXIDs(1, 2, TXIDS));
+    BOOST_CHECK(TXIDS == std::vector<uint256>(vecAsset.begin(), vecAsset.begin() + 10));
+    BOOST_CHECK(!db.ReadIndexTXIDs(1, 3, TXIDS));
+    BOOST_CHECK(db.ReadIndexTXIDs(allocationTuple, 1, TXIDS));
+    BOOST_CHECK(TXIDS == std::vector<uint256>(vecAllocation.begin(), vecAllocation.end() - fAssetIndexPageSize));
+
+    // erasing the newest entry hands its sequence number out again, erasing an older one leaves a shorter page
+    BOOST_CHECK(db.EraseIndexTXID(1, vecAsset.back()));
+    BOOST_CHECK(!db.EraseIndexTXID(1, vecAsset.back()));
+    vecAsset.pop_back();
+    BOOST_CHECK(db.EraseIndexTXID(1, vecAsset[5]));
+    BOOST_CHECK(db.ReadIndexTXIDs(1, 2, TXIDS));
+    BOOST_CHECK_EQUAL(TXIDS.size(), 8U);
+    BOOST_CHECK(std::find(TXIDS.begin(), TXIDS.end(), vecAsset[5]) == TXIDS.end());
+    vecAsset.push_back(InsecureRand256());
+    BOOST_CHECK(db.AppendIndexTXID(1, vecAsset.back()));
+    BOOST_CHECK(db.ReadIndexTXIDs(1, 0, TXIDS));
+    BOOST_CHECK(TXIDS == std::vector<uint256>(vecAsset.end() - fAssetIndexPageSize, vecAsset.end()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include <crypto/poly1305.h>
 #include <crypto/hkdf_sha256_32.h>
 #include <crypto/hmac_sha256.h>
+#include <crypto/keccak256.h>
 #include <crypto/hmac_sha512.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
@@ -53,6 +54,7 @@ static void TestVector(const Hasher &h, const In &in, const Out &out) {
 
 static void TestSHA1(const std::string &in, const std::string &hexout) { TestVector(CSHA1(), in, ParseHex(hexout));}
 static void TestSHA256(const std::string &in, const std::string &hexout) { TestVector(CSHA256(), in, ParseHex(hexout));}
+static void TestKeccak256(const std::string &in, const std::string &hexout) { TestVector(CKeccak256(), in, ParseHex(hexout));}
 static void TestSHA512(const std::string &in, const std::string &hexout) { TestVector(CSHA512(), in, ParseHex(hexout));}
 static void TestRIPEMD160(const std::string &in, const std::string &hexout) { TestVector(CRIPEMD160(), in, ParseHex(hexout));}
 
@@ -623,4 +625,34 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(keccak256_testvectors) {
+    TestKeccak256("", "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
+    TestKeccak256("abc", "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45");
+    TestKeccak256(std::string(135, 'a'), "34367dc248bbd832f4e3e69dfaac2f92638bd0bbd18f2912ba4ef454919cf446");
+    TestKeccak256(std::string(136, 'a'), "a6c4d403279fe3e0af03729caada8374b5ca54d8065329a3ebcaeb4b60aa386e");
+    TestKeccak256(std::string(1000000, 'a'), "fadae6b49f129bbb812be8407b7b2894f34aecf6dbd1f9b0f0c7e9853098fc96");
+}
+
+BOOST_AUTO_TEST_CASE(keccak256_many)
+{
+    // Mix of lengths around the rate so lanes finish after different numbers of blocks
+    for (int n = 0; n <= 11; ++n) {
+        std::vector<std::vector<unsigned char>> vecInputs(n);
+        std::vector<const unsigned char*> inputs;
+        std::vector<size_t> lens;
+        for (auto& input : vecInputs) {
+            input.resize(InsecureRandRange(3 * CKeccak256::RATE + 2));
+            for (unsigned char& c : input)
+                c = InsecureRandBits(8);
+            inputs.push_back(input.data());
+            lens.push_back(input.size());
+        }
+        std::vector<unsigned char> out1(32 * n), out2(32 * n);
+        for (int j = 0; j < n; ++j)
+            CKeccak256().Write(inputs[j], lens[j]).Finalize(out1.data() + 32 * j);
+        Keccak256Many(out2.data(), inputs.data(), lens.data(), n);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
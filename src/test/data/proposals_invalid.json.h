@@ -0,0 +1,452 @@
+namespace json_tests{
+static unsigned const char proposals_invalid[] = {
+0x5b, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 
+0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 
+0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 
+0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 
+0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 
+0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 
+0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x79, 0x59, 0x65, 0x38, 
+0x4b, 0x77, 0x79, 0x61, 0x55, 0x75, 0x35, 0x59, 
+0x73, 0x77, 0x53, 0x59, 0x6d, 0x42, 0x33, 0x71, 
+0x33, 0x72, 0x79, 0x78, 0x38, 0x58, 0x54, 0x55, 
+0x75, 0x39, 0x79, 0x37, 0x55, 0x69, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 
+0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 
+0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 
+0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 
+0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 
+0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 
+0x61, 0x73, 0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 
+0x61, 0x6c, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 
+0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 
+0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 
+0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 
+0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 
+0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 
+0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 
+0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 
+0x73, 0x22, 0x3a, 0x20, 0x22, 0x20, 0x31, 0x33, 
+0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 
+0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 
+0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 
+0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 
+0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 
+0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 
+0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 
+0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 
+0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 
+0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 
+0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 
+0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 
+0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 
+0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 
+0x2f, 0x64, 0x61, 0x73, 0x68, 0x63, 0x65, 0x6e, 
+0x74, 0x72, 0x61, 0x6c, 0x2e, 0x6f, 0x72, 0x67, 
+0x2f, 0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 
+0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 
+0x33, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 
+0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 
+0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 
+0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 
+0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 
+0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 
+0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 
+0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 
+0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 
+0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 
+0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 
+0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 
+0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 
+0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 
+0x45, 0x20, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 
+0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 
+0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 
+0x35, 0x2e, 0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 
+0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 
+0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 
+0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 
+0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 
+0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 
+0x22, 0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 
+0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 0x63, 
+0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 0x6f, 
+0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 0x2d, 
+0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 
+0x34, 0x39, 0x33, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 
+0x22, 0x65, 0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 
+0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 
+0x31, 0x33, 0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 
+0x20, 0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 
+0x20, 0x22, 0x20, 0x64, 0x65, 0x61, 0x6e, 0x2d, 
+0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 
+0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 0x22, 0x70, 
+0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 
+0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 
+0x20, 0x22, 0x31, 0x33, 0x70, 0x31, 0x69, 0x6a, 
+0x4c, 0x77, 0x73, 0x6e, 0x72, 0x63, 0x75, 0x79, 
+0x71, 0x63, 0x54, 0x76, 0x4a, 0x58, 0x6b, 0x71, 
+0x32, 0x41, 0x53, 0x64, 0x58, 0x71, 0x63, 0x6e, 
+0x45, 0x42, 0x4c, 0x45, 0x22, 0x2c, 0x20, 0x22, 
+0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 
+0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 
+0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 0x2c, 0x20, 
+0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 
+0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 
+0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 
+0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 
+0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 
+0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 0x68, 0x74, 
+0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 
+0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 
+0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x7d, 0x2c, 
+0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 0x65, 
+0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 
+0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 0x30, 
+0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 0x65, 
+0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 0x6e, 
+0x20, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x20, 
+0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 0x22, 
+0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 
+0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 
+0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 0x31, 0x69, 
+0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 0x63, 0x75, 
+0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 0x58, 0x6b, 
+0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 0x71, 0x63, 
+0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 0x2c, 0x20, 
+0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 
+0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x22, 
+0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 0x2c, 
+0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 0x5f, 
+0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 
+0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 0x30, 
+0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 0x70, 
+0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 0x22, 
+0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 0x68, 
+0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 0x61, 
+0x73, 0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 0x61, 
+0x6c, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 0x65, 
+0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 
+0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x7d, 
+0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 
+0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 
+0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 
+0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 
+0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x20, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 
+0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 
+0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 
+0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 
+0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 
+0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 
+0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 
+0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 
+0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 
+0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 
+0x3a, 0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 
+0x31, 0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 
+0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 
+0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 
+0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 
+0x64, 0x61, 0x73, 0x68, 0x63, 0x65, 0x6e, 0x74, 
+0x72, 0x61, 0x6c, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 
+0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 
+0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 
+0x22, 0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 
+0x64, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 
+0x3a, 0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 
+0x38, 0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 
+0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 
+0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 
+0x65, 0x72, 0xc3, 0xa0, 0x2d, 0x35, 0x34, 0x39, 
+0x33, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 
+0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 
+0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 
+0x31, 0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 
+0x73, 0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 
+0x54, 0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 
+0x53, 0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 
+0x4c, 0x45, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 
+0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 
+0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 
+0x35, 0x2e, 0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 
+0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 
+0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 
+0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 
+0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 
+0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 
+0x22, 0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 
+0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 0x63, 
+0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 0x6f, 
+0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 0x2d, 
+0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 
+0x34, 0x39, 0x33, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 
+0x22, 0x65, 0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 
+0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 
+0x31, 0x33, 0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 
+0x20, 0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 
+0x20, 0x22, 0x64, 0x65, 0x61, 0x6e, 0x2d, 0xd0, 
+0xbc, 0xd0, 0xb8, 0xd0, 0xbb, 0xd0, 0xbb, 0xd0, 
+0xb5, 0xd1, 0x80, 0x2d, 0x35, 0x34, 0x39, 0x33, 
+0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 
+0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 
+0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 
+0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 
+0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 
+0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 
+0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 
+0x45, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 
+0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 
+0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 
+0x2e, 0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 
+0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 
+0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 0x34, 
+0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 0x20, 
+0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 
+0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 
+0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 
+0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 0x63, 0x65, 
+0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 0x6f, 0x72, 
+0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 
+0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 
+0x39, 0x33, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 0x22, 
+0x65, 0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 0x63, 
+0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 0x31, 
+0x33, 0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 0x20, 
+0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 
+0x22, 0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 
+0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 
+0x33, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 
+0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 
+0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 
+0x31, 0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 
+0x73, 0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 
+0x54, 0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 
+0x53, 0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 
+0x4c, 0x45, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 
+0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 
+0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 
+0x35, 0x2e, 0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 
+0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 
+0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 
+0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 
+0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 
+0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 
+0x22, 0x3a, 0x20, 0x22, 0x20, 0x68, 0x74, 0x74, 
+0x70, 0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 
+0x63, 0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 
+0x6f, 0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 
+0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 
+0x35, 0x34, 0x39, 0x33, 0x22, 0x7d, 0x2c, 0x0a, 
+0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 0x65, 0x70, 
+0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 
+0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 0x30, 0x30, 
+0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 
+0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 0x6e, 0x2d, 
+0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 
+0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 0x22, 0x70, 
+0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 
+0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 
+0x20, 0x22, 0x31, 0x33, 0x70, 0x31, 0x69, 0x6a, 
+0x4c, 0x77, 0x73, 0x6e, 0x72, 0x63, 0x75, 0x79, 
+0x71, 0x63, 0x54, 0x76, 0x4a, 0x58, 0x6b, 0x71, 
+0x32, 0x41, 0x53, 0x64, 0x58, 0x71, 0x63, 0x6e, 
+0x45, 0x42, 0x4c, 0x45, 0x22, 0x2c, 0x20, 0x22, 
+0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 0x5f, 
+0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 
+0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 0x2c, 0x20, 
+0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 
+0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 
+0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 
+0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 
+0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 
+0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 0x68, 0x74, 
+0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 
+0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 
+0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x20, 0x22, 0x7d, 
+0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 
+0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 
+0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 
+0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 
+0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 
+0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 
+0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 0x31, 
+0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 0x63, 
+0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 0x58, 
+0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 0x71, 
+0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 
+0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 
+0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 
+0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 
+0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 
+0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 
+0x61, 0x73, 0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 
+0x61, 0x6c, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 
+0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 
+0x65, 0x72, 0x20, 0x35, 0x34, 0x39, 0x33, 0x22, 
+0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 
+0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 
+0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 
+0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 
+0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 
+0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 
+0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 
+0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 
+0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 
+0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 
+0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 
+0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 
+0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 
+0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 
+0x3a, 0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 
+0x31, 0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 
+0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 
+0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 
+0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 
+0x5b, 0x3a, 0x3a, 0x31, 0x2f, 0x66, 0x6f, 0x6f, 
+0x2f, 0x62, 0x61, 0x64, 0x5d, 0x2f, 0x62, 0x61, 
+0x64, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 
+0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 
+0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 
+0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 
+0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 
+0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 
+0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 
+0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 
+0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 
+0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 
+0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 
+0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 
+0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 
+0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 
+0x45, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 
+0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 
+0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 
+0x2e, 0x37, 0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 
+0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 
+0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 0x37, 0x34, 
+0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 0x2c, 0x20, 
+0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 
+0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 
+0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 
+0x2f, 0x2f, 0x3a, 0x3a, 0x31, 0x32, 0x2e, 0x33, 
+0x34, 0x2e, 0x35, 0x36, 0x2e, 0x37, 0x38, 0x5d, 
+0x2f, 0x22, 0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 
+0x6e, 0x64, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 
+0x22, 0x3a, 0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 
+0x36, 0x38, 0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 
+0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 
+0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 
+0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 
+0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 
+0x65, 0x6e, 0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 
+0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 
+0x33, 0x70, 0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 
+0x6e, 0x72, 0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 
+0x76, 0x4a, 0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 
+0x64, 0x58, 0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 
+0x45, 0x22, 0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 
+0x6d, 0x65, 0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 
+0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x32, 
+0x35, 0x2e, 0x37, 0x35, 0x22, 0x2c, 0x20, 0x22, 
+0x73, 0x74, 0x61, 0x72, 0x74, 0x5f, 0x65, 0x70, 
+0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x31, 0x34, 
+0x37, 0x34, 0x32, 0x36, 0x31, 0x30, 0x38, 0x36, 
+0x2c, 0x20, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 
+0x3a, 0x20, 0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 
+0x6c, 0x22, 0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 
+0x70, 0x3a, 0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 
+0x63, 0x65, 0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 
+0x6f, 0x72, 0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 
+0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 
+0x35, 0x34, 0x39, 0x33, 0x22, 0x7d, 0x2c, 0x0a, 
+0x7b, 0x22, 0x65, 0x6e, 0x64, 0x5f, 0x65, 0x70, 
+0x6f, 0x63, 0x68, 0x22, 0x3a, 0x20, 0x22, 0x31, 
+0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 0x34, 0x30, 
+0x30, 0x22, 0x2c, 0x20, 0x22, 0x6e, 0x61, 0x6d, 
+0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x61, 
+0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 0x72, 
+0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 0x20, 
+0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 0x74, 
+0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 
+0x22, 0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 0x31, 
+0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 0x63, 
+0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 0x58, 
+0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 0x71, 
+0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 0x74, 
+0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 0x35, 
+0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 0x74, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x37, 0x34, 0x32, 0x36, 0x31, 
+0x30, 0x38, 0x36, 0x2c, 0x20, 0x22, 0x74, 0x79, 
+0x70, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x20, 
+0x22, 0x75, 0x72, 0x6c, 0x22, 0x3a, 0x20, 0x22, 
+0x68, 0x74, 0x74, 0x70, 0x3a, 0x2f, 0x2f, 0x64, 
+0x61, 0x73, 0x68, 0x63, 0x65, 0x6e, 0x74, 0x72, 
+0x61, 0x6c, 0x2e, 0x6f, 0x72, 0x67, 0x2f, 0x64, 
+0x65, 0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 
+0x65, 0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 
+0x7d, 0x2c, 0x0a, 0x7b, 0x22, 0x65, 0x6e, 0x64, 
+0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 0x3a, 
+0x20, 0x31, 0x34, 0x39, 0x31, 0x33, 0x36, 0x38, 
+0x34, 0x30, 0x30, 0x2c, 0x20, 0x22, 0x6e, 0x61, 
+0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 
+0x61, 0x6e, 0x2d, 0x6d, 0x69, 0x6c, 0x6c, 0x65, 
+0x72, 0x2d, 0x35, 0x34, 0x39, 0x33, 0x22, 0x2c, 
+0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 0x6e, 
+0x74, 0x5f, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 
+0x73, 0x22, 0x3a, 0x20, 0x22, 0x31, 0x33, 0x70, 
+0x31, 0x69, 0x6a, 0x4c, 0x77, 0x73, 0x6e, 0x72, 
+0x63, 0x75, 0x79, 0x71, 0x63, 0x54, 0x76, 0x4a, 
+0x58, 0x6b, 0x71, 0x32, 0x41, 0x53, 0x64, 0x58, 
+0x71, 0x63, 0x6e, 0x45, 0x42, 0x4c, 0x45, 0x22, 
+0x2c, 0x20, 0x22, 0x70, 0x61, 0x79, 0x6d, 0x65, 
+0x6e, 0x74, 0x5f, 0x61, 0x6d, 0x6f, 0x75, 0x6e, 
+0x74, 0x22, 0x3a, 0x20, 0x32, 0x35, 0x2e, 0x37, 
+0x35, 0x2c, 0x20, 0x22, 0x73, 0x74, 0x61, 0x72, 
+0x74, 0x5f, 0x65, 0x70, 0x6f, 0x63, 0x68, 0x22, 
+0x3a, 0x20, 0x22, 0x31, 0x34, 0x37, 0x34, 0x32, 
+0x36, 0x31, 0x30, 0x38, 0x36, 0x22, 0x2c, 0x20, 
+0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 
+0x31, 0x2c, 0x20, 0x22, 0x75, 0x72, 0x6c, 0x22, 
+0x3a, 0x20, 0x22, 0x68, 0x74, 0x74, 0x70, 0x3a, 
+0x2f, 0x2f, 0x64, 0x61, 0x73, 0x68, 0x63, 0x65, 
+0x6e, 0x74, 0x72, 0x61, 0x6c, 0x2e, 0x6f, 0x72, 
+0x67, 0x2f, 0x64, 0x65, 0x61, 0x6e, 0x2d, 0x6d, 
+0x69, 0x6c, 0x6c, 0x65, 0x72, 0x2d, 0x35, 0x34, 
+0x39, 0x33, 0x22, 0x7d, 0x0a, 0x5d, 0x0a, 
+};};